@@ -1,7 +1,108 @@
 #include "utils/config.hpp"
 #include "utils/analysis.hpp"
 
+#include <sstream>
+
+// Parse a comma separated list of history lengths, "none" for an empty list
+std::vector<size_t> parseHistoryList(const std::string& list) {
+    std::vector<size_t> histories;
+    if (list == "none") return histories;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t bits = std::stoull(item);
+        if (bits > MAX_PREDICTABILITY_HISTORY) {
+            throw std::invalid_argument("Predictability history must be at most " + std::to_string(MAX_PREDICTABILITY_HISTORY));
+        }
+        histories.push_back(bits);
+    }
+    return histories;
+}
+
+void printUsage() {
+    std::cout << "Usage: trace-analyzer [options] [trace_file...]\n"
+              << "  --history N    depth of the PC / taken patterns, 1-" << MAX_PATTERN_LENGTH
+              << " (default " << config.PATTERN_HISTORY_LENGTH << ")\n"
+              << "  --predictability K1,K2,...\n"
+              << "                 global / local history lengths of the predictability bounds,\n"
+              << "                 0-" << MAX_PREDICTABILITY_HISTORY << " bits (default 0,4,8,16), none to skip\n"
+              << "  --index-bits N table index width of the reuse-distance histogram, 0-" << MAX_REUSE_INDEX_BITS
+              << " (default " << config.REUSE_INDEX_BITS << ")\n"
+              << "  --interval N   branches per working-set interval, 0 for none (default "
+              << config.WORKING_SET_INTERVAL << ")\n"
+              << "  --max-lines N  analyze at most N branches per trace\n"
+              << "  --out DIR      output directory (default results)\n"
+              << "  --progress     print rate, % of trace, ETA and RSS of running jobs to stderr\n"
+              << "  --telemetry FILE\n"
+              << "                 rewrite the same metrics to FILE (JSON if FILE ends in .json,\n"
+              << "                 OpenMetrics text otherwise) every --telemetry-interval seconds\n"
+              << "                 (default " << config.TELEMETRY_INTERVAL << ")\n"
+              << "  --perf         count cycles, instructions, cache and branch misses of the\n"
+              << "                 analyzer per trace and phase, written to OUT/perf_counters_analysis.csv\n"
+              << "  --shm-cache    share decoded traces between processes through " << config.SHM_CACHE_DIR << "\n"
+              << "  --async-io     stream traces through io_uring reads ahead of the analysis\n"
+              << "                 (pread where io_uring is unavailable) instead of mapping them\n"
+              << "  --io-depth N   reads in flight with --async-io (default " << config.ASYNC_QUEUE_DEPTH << ")\n"
+              << "  --io-buffer N  bytes per read with --async-io (default " << config.ASYNC_BUFFER_SIZE << ")\n"
+              << "  --direct-io    --async-io with O_DIRECT, leaving the page cache alone\n"
+              << "  --columnar     also write each table as a columnar binary .bpcol file (see utils/columnar.hpp)\n"
+              << "Without trace files, config.ORIGINAL_TRACES are analyzed.\n";
+}
+
 int main(int argc, char* argv[]) {
-    createPandasFriendlyCSV(config.ORIGINAL_TRACES, "results", 0);
+    std::vector<std::string> traceFiles;
+    std::string outputDir = "results";
+    size_t maxLines = 0;
+    size_t historyLength = config.PATTERN_HISTORY_LENGTH;
+    std::vector<size_t> predictabilityHistories = config.PREDICTABILITY_HISTORIES;
+    bool progressTerminal = false;
+    std::string telemetryFile;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--history") historyLength = std::stoull(value());
+            else if (arg == "--predictability") predictabilityHistories = parseHistoryList(value());
+            else if (arg == "--index-bits") config.REUSE_INDEX_BITS = std::stoull(value());
+            else if (arg == "--interval") config.WORKING_SET_INTERVAL = std::stoull(value());
+            else if (arg == "--max-lines") maxLines = std::stoull(value());
+            else if (arg == "--out") outputDir = value();
+            else if (arg == "--perf") perfProfiler().enable();
+            else if (arg == "--progress") progressTerminal = true;
+            else if (arg == "--telemetry") telemetryFile = value();
+            else if (arg == "--telemetry-interval") config.TELEMETRY_INTERVAL = std::stod(value());
+            else if (arg == "--shm-cache") config.SHM_TRACE_CACHE = true;
+            else if (arg == "--async-io") config.ASYNC_TRACE_IO = true;
+            else if (arg == "--io-depth") config.ASYNC_QUEUE_DEPTH = std::stoull(value());
+            else if (arg == "--io-buffer") config.ASYNC_BUFFER_SIZE = std::stoull(value());
+            else if (arg == "--direct-io") config.ASYNC_TRACE_IO = config.ASYNC_DIRECT_IO = true;
+            else if (arg == "--columnar") config.COLUMNAR_RESULTS = true;
+            else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+            else if (!arg.empty() && arg[0] == '-') throw std::invalid_argument("Unknown option " + arg);
+            else traceFiles.push_back(arg);
+        }
+        if (config.REUSE_INDEX_BITS > MAX_REUSE_INDEX_BITS) {
+            throw std::invalid_argument("Index bits must be at most " + std::to_string(MAX_REUSE_INDEX_BITS));
+        }
+        if (historyLength == 0 || historyLength > MAX_PATTERN_LENGTH) {
+            throw std::invalid_argument("History depth must be between 1 and " + std::to_string(MAX_PATTERN_LENGTH));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    if (progressTerminal || !telemetryFile.empty()) {
+        telemetry().start(progressTerminal, telemetryFile, config.TELEMETRY_INTERVAL);
+    }
+    createPandasFriendlyCSV(traceFiles.empty() ? config.ORIGINAL_TRACES : traceFiles, outputDir, maxLines, historyLength,
+                            predictabilityHistories);
+    telemetry().stop();
+    perfProfiler().writeCSV(outputDir + "/perf_counters_analysis.csv");
     return 0;
-}
\ No newline at end of file
+}
@@ -3,134 +3,389 @@
 #include "utils/utils.hpp"
 #include "utils/config.hpp"
 #include "utils/analysis.hpp"
+#include "utils/simpoint.hpp"
+#include "utils/experiment.hpp"
+#include "utils/server.hpp"
 
 
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <chrono>
+#include <functional>
 
-void runPredictor(std::vector<std::string> traceFiles, size_t maxLines = 0, const std::string& csvFile = "results/results_predict.csv");
+void runPredictor(std::vector<std::string> traceFiles, std::string& perfFile, const std::string& experimentFile = "",
+                  bool useCache = true, const std::string& shard = "", const std::string& filter = "");
+void runPredictorSimPoints(std::vector<std::string> traceFiles, const std::string& experimentFile,
+                           const std::string& simPointDir, size_t warmup, bool validate,
+                           const std::string& csvFile = "results/results_simpoint.csv");
+void runAliasing(std::vector<std::string> traceFiles, const std::string& outputDir = "results");
 
+// Entries and PCs listed per predictor in the aliasing reports
+const size_t ALIASING_REPORT_ROWS = 10;
+
+void printUsage() {
+    std::cout << "Usage: branch-predictor [options] [trace_file...]\n"
+              << "  --experiment FILE  evaluate the traces x predictors listed in FILE instead of\n"
+              << "                   config.TRACES x config.PREDICTORS (trace files given on the\n"
+              << "                   command line replace the file's traces)\n"
+              << "  --no-cache       simulate every job, ignoring the result cache in " << config.RESULT_CACHE_DIR << "\n"
+              << "  --shard i/N      run only jobs i, i+N, i+2N, ... (0 <= i < N) of the matrix and write\n"
+              << "                   <output>.shard-i-of-N.csv, combine the shards with merge-results\n"
+              << "  --filter SPEC    feed only the selected records to the predictors, clauses joined by\n"
+              << "                   commas: conditional, unconditional, direct, indirect, kind=bcr,\n"
+              << "                   pc=LO-HI, pcs=FILE (see utils/branch_filter.hpp)\n"
+              << "  --simpoints DIR  simulate only the simpoints in DIR (see trace-simpoint) and\n"
+              << "                   report weighted misprediction estimates for the predictors of\n"
+              << "                   --experiment or config.PREDICTORS, default traces are the\n"
+              << "                   experiment's or config.ORIGINAL_TRACES\n"
+              << "  --warmup N       branches simulated before each simpoint (default " << config.SIMPOINT_WARMUP << ")\n"
+              << "  --validate       also simulate the full trace and report the estimation error\n"
+              << "  --aliasing       run 2-bit and gshare with alias tracking and write\n"
+              << "                   results/aliasing*.csv (collisions per entry and per PC)\n"
+              << "  --progress       print rate, % of trace, ETA and RSS of running jobs to stderr\n"
+              << "  --telemetry FILE rewrite the same metrics to FILE (JSON if FILE ends in .json,\n"
+              << "                   OpenMetrics text otherwise) every --telemetry-interval seconds\n"
+              << "                   (default " << config.TELEMETRY_INTERVAL << ")\n"
+              << "  --perf           count cycles, instructions, cache and branch misses of the\n"
+              << "                   simulator per job and phase, written to perf_counters.csv in the\n"
+              << "                   results directory (perf_counters.shard-i-of-N.csv with --shard)\n"
+              << "  --shm-cache      share decoded traces between processes through " << config.SHM_CACHE_DIR << "\n"
+              << "  --clear-shm-cache  remove the decoded traces, stamps and locks from " << config.SHM_CACHE_DIR << "\n"
+              << "                   and exit\n"
+              << "  --async-io       stream traces through io_uring reads ahead of the simulation\n"
+              << "                   (pread where io_uring is unavailable) instead of mapping them\n"
+              << "  --io-depth N     reads in flight with --async-io (default " << config.ASYNC_QUEUE_DEPTH << ")\n"
+              << "  --io-buffer N    bytes per read with --async-io (default " << config.ASYNC_BUFFER_SIZE << ")\n"
+              << "  --direct-io      --async-io with O_DIRECT, leaving the page cache alone\n"
+              << "  --columnar       also write each result table as a columnar binary .bpcol file with\n"
+              << "                   full-precision values (see utils/columnar.hpp)\n"
+              << "  --huge-pages MODE  back large predictor tables and decoded traces with huge pages:\n"
+              << "                   none, thp (madvise) or hugetlb (reserved pool, falls back to thp)\n"
+              << "  --numa-local     place table pages on the NUMA node of the thread allocating them\n"
+              << "  --serve SOCKET   serve predictions to live branch streams on a UNIX domain socket\n"
+              << "                   (protocol in utils/server.hpp) until interrupted\n"
+              << "Without trace files, config.TRACES are evaluated.\n";
+}
 
 int main(int argc, char* argv[]) {
+    std::vector<std::string> traceFiles;
+    std::string simPointDir;
+    size_t warmup = config.SIMPOINT_WARMUP;
+    bool validate = false;
+    bool aliasing = false;
+    bool progressTerminal = false;
+    std::string telemetryFile;
+    std::string experimentFile;
+    bool useCache = true;
+    std::string shard;
+    std::string filter;
+    std::string socketPath;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--experiment") experimentFile = value();
+            else if (arg == "--no-cache") useCache = false;
+            else if (arg == "--shard") shard = value();
+            else if (arg == "--filter") filter = value();
+            else if (arg == "--simpoints") simPointDir = value();
+            else if (arg == "--warmup") warmup = std::stoull(value());
+            else if (arg == "--validate") validate = true;
+            else if (arg == "--aliasing") aliasing = true;
+            else if (arg == "--perf") perfProfiler().enable();
+            else if (arg == "--progress") progressTerminal = true;
+            else if (arg == "--telemetry") telemetryFile = value();
+            else if (arg == "--telemetry-interval") config.TELEMETRY_INTERVAL = std::stod(value());
+            else if (arg == "--shm-cache") config.SHM_TRACE_CACHE = true;
+            else if (arg == "--clear-shm-cache") {
+                std::cout << "Removed " << clearSharedTraces() << " files from " << config.SHM_CACHE_DIR << std::endl;
+                return 0;
+            }
+            else if (arg == "--async-io") config.ASYNC_TRACE_IO = true;
+            else if (arg == "--io-depth") config.ASYNC_QUEUE_DEPTH = std::stoull(value());
+            else if (arg == "--io-buffer") config.ASYNC_BUFFER_SIZE = std::stoull(value());
+            else if (arg == "--direct-io") config.ASYNC_TRACE_IO = config.ASYNC_DIRECT_IO = true;
+            else if (arg == "--columnar") config.COLUMNAR_RESULTS = true;
+            else if (arg == "--serve") socketPath = value();
+            else if (arg == "--huge-pages") tableMemory.hugePages = parseHugePages(value());
+            else if (arg == "--numa-local") tableMemory.numaLocal = true;
+            else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+            else if (!arg.empty() && arg[0] == '-') throw std::invalid_argument("Unknown option " + arg);
+            else traceFiles.push_back(arg);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
 
-    runPredictor(config.TRACES);
+    if (!socketPath.empty()) {
+        try {
+            PredictionServer server(socketPath);
+            server.run();
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    std::string perfFile = "results/perf_counters.csv";  // predictor runs write it next to their results
+    if (progressTerminal || !telemetryFile.empty()) {
+        telemetry().start(progressTerminal, telemetryFile, config.TELEMETRY_INTERVAL);
+    }
+
+    if (aliasing) {
+        try {
+            runAliasing(traceFiles.empty() ? config.TRACES : traceFiles);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            telemetry().stop();
+            return 1;
+        }
+    } else if (!simPointDir.empty()) {
+        try {
+            runPredictorSimPoints(traceFiles, experimentFile, simPointDir, warmup, validate);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            telemetry().stop();
+            return 1;
+        }
+    } else {
+        try {
+            runPredictor(traceFiles, perfFile, experimentFile, useCache, shard, filter);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            telemetry().stop();
+            return 1;
+        }
+    }
+    telemetry().stop();
+    perfProfiler().writeCSV(perfFile);
     
     return 0;
 }
 
-void runPredictor(std::vector<std::string> traceFiles, size_t maxLines, const std::string& csvFile) {
+void runPredictor(std::vector<std::string> traceFiles, std::string& perfFile, const std::string& experimentFile,
+                  bool useCache, const std::string& shard, const std::string& filter) {
+    Experiment experiment;
+    if (!experimentFile.empty()) {
+        experiment = loadExperiment(experimentFile);
+    } else {
+        for (const std::string& spec : config.PREDICTORS) {
+            experiment.predictors.push_back(PredictorSpec::parse(spec));
+        }
+    }
+    if (!traceFiles.empty()) experiment.traces = traceFiles;
+    if (experiment.traces.empty()) experiment.traces = config.TRACES;
+    if (!useCache) experiment.cacheDir.clear();
+    if (!shard.empty()) parseShard(shard, experiment.shardIndex, experiment.shardCount);
+    if (!filter.empty()) experiment.filter = BranchFilter::parse(filter);
+    perfFile = perfOutputPath(experiment);
+
+    runExperiment(experiment);
+}
+
+void runPredictorSimPoints(std::vector<std::string> traceFiles, const std::string& experimentFile,
+                           const std::string& simPointDir, size_t warmup, bool validate,
+                           const std::string& csvFile) {
+    // predictors of the experiment file or config.PREDICTORS, traces of the
+    // command line, the experiment file or config.ORIGINAL_TRACES
+    Experiment experiment;
+    if (!experimentFile.empty()) {
+        experiment = loadExperiment(experimentFile);
+    } else {
+        for (const std::string& spec : config.PREDICTORS) {
+            experiment.predictors.push_back(PredictorSpec::parse(spec));
+        }
+    }
+    if (traceFiles.empty()) traceFiles = experiment.traces;
+    if (traceFiles.empty()) traceFiles = config.ORIGINAL_TRACES;
 
     std::ofstream csv(csvFile);
     if (!csv.is_open()) {
         std::cerr << "Error: Could not open CSV file " << csvFile << std::endl;
         return;
     }
-    csv << "TraceFile,Predictor,TotalBranches,Mispredictions,MispredictionRate\n";
+    csv << "TraceFile,Predictor,SimulatedBranches,EstimatedMispredictionRate";
+    if (validate) csv << ",TotalBranches,MispredictionRate,AbsoluteError";
+    csv << "\n";
+    std::vector<ColumnSpec> columns = {
+        {"TraceFile", ColumnType::String}, {"Predictor", ColumnType::String},
+        {"SimulatedBranches", ColumnType::UInt64}, {"EstimatedMispredictionRate", ColumnType::Float64},
+    };
+    if (validate) {
+        columns.insert(columns.end(), {{"TotalBranches", ColumnType::UInt64}, {"MispredictionRate", ColumnType::Float64},
+                                       {"AbsoluteError", ColumnType::Float64}});
+    }
+    auto columnar = columnarFor(csvFile, columns, {{"table", "simpoint estimates"}, {"warmup", std::to_string(warmup)}});
 
-    for(std::string traceFile: traceFiles) {    
+    for (std::string traceFile: traceFiles) {
         std::string traceName = getTraceBaseName(traceFile);
-        
-        // write the header
-
+        std::vector<SimPoint> points = loadSimPoints(simPointFile(simPointDir, traceName));
 
-        std::cout << "Branch Predictor Simulator" << std::endl;
-        std::cout << "=========================" << std::endl;
+        std::cout << "Branch Predictor Simulator (simpoints)" << std::endl;
+        std::cout << "======================================" << std::endl;
         std::cout << "Trace file: " << traceFile << std::endl;
-        if (maxLines > 0) {
-            std::cout << "Max lines: " << maxLines << std::endl;
-        }
+        std::cout << "Simpoints: " << points.size() << ", warmup: " << warmup << std::endl;
         std::cout << std::endl;
-        
-        // -------------------------------------------------------------
-        // Create and evaluate the Always Taken predictor
-        AlwaysTakenPredictor alwaysTaken;
-        std::cout << "Evaluating Always Taken predictor..." << std::endl;
-        auto result = evaluatePredictor(alwaysTaken, traceFile, maxLines);
-        size_t totalBranches = result[0];
-        size_t mispredictions = result[1];
-        double mispredictionRate = (totalBranches > 0) ? 
-            (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
-        
-        // write the result to csv
-        csv << traceName << ","
-        << alwaysTaken.getName() << ","
-        << totalBranches << ","
-        << mispredictions << ","
-        << std::fixed << std::setprecision(2) << mispredictionRate << "\n";
-        // -------------------------------------------------------------
-
-        // -------------------------------------------------------------
-        // Create and evaluate 2-bit predictors with different table sizes
-        std::vector<size_t> tableSizes = {512, 1024, 2048, 4096};
-        for (size_t size : tableSizes) {
-            TwoBitPredictor twoBit(size);
-            std::cout << "Evaluating " << twoBit.getName() << " predictor..." << std::endl;
-            result = evaluatePredictor(twoBit, traceFile, maxLines);
-            totalBranches = result[0];
-            mispredictions = result[1];
-            mispredictionRate = (totalBranches > 0) ? 
-                (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
+
+        // write one row, optionally validated against a full simulation
+        auto report = [&](BranchPredictor& predictor, const SimPointEstimate& estimate, double seconds,
+                          const std::function<std::vector<size_t>()>& fullRun) {
+            std::cout << "Predictor: " << predictor.getName() << std::endl;
+            std::cout << "Simulated branches: " << estimate.simulatedBranches
+                      << " (" << std::fixed << std::setprecision(2) << seconds << "s)" << std::endl;
+            std::cout << "Estimated misprediction rate: " << estimate.mispredictionRate << "%" << std::endl;
 
             csv << traceName << ","
-                << twoBit.getName() << ","
-                << totalBranches << ","
-                << mispredictions << ","
-                << std::fixed << std::setprecision(2) << mispredictionRate << "\n";
+                << predictor.getName() << ","
+                << estimate.simulatedBranches << ","
+                << std::fixed << std::setprecision(2) << estimate.mispredictionRate;
+            if (validate) {
+                auto result = fullRun();
+                double fullRate = (result[0] > 0) ?
+                    (static_cast<double>(result[1]) / result[0]) * 100.0 : 0.0;
+                csv << "," << result[0] << "," << fullRate << ","
+                    << std::abs(fullRate - estimate.mispredictionRate);
+                if (columnar) {
+                    columnar->row(traceName, predictor.getName(), estimate.simulatedBranches,
+                                  estimate.mispredictionRate, result[0], fullRate,
+                                  std::abs(fullRate - estimate.mispredictionRate));
+                }
+            } else if (columnar) {
+                columnar->row(traceName, predictor.getName(), estimate.simulatedBranches, estimate.mispredictionRate);
+            }
+            csv << "\n";
+            std::cout << std::endl;
+        };
+
+        // profile-guided predictors are profiled on the simpoints themselves
+        for (const PredictorSpec& spec : experiment.predictors) {
+            std::unique_ptr<BranchPredictor> predictor = createPredictor(spec);
+            auto start = std::chrono::steady_clock::now();
+            SimPointEstimate estimate = estimateAnyWithSimPoints(*predictor, traceFile, points, warmup);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            report(*predictor, estimate, seconds, [&]() { return evaluateAnyPredictor(*predictor, traceFile, 0); });
         }
-        // -------------------------------------------------------------
-
-        // -------------------------------------------------------------
-        // Create and evaluate gshare predictor
-        GSharePredictor gshare(2048);
-        std::cout << "Evaluating gshare predictor..." << std::endl;
-        result = evaluatePredictor(gshare, traceFile, maxLines);
-        totalBranches = result[0];
-        mispredictions = result[1];
-        mispredictionRate = (totalBranches > 0) ? 
-            (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
-
-        csv << traceName << ","
-            << gshare.getName() << ","
-            << totalBranches << ","
-            << mispredictions << ","
-            << std::fixed << std::setprecision(2) << mispredictionRate << "\n";
-        // -------------------------------------------------------------
-
-        // -------------------------------------------------------------
-        // Create and evaluate profiled 2bit predictor
-        ProfiledPredictor profiled(2048);
-        std::cout << "Evaluating profiled predictor..." << std::endl;
-        auto profiledResult = evaluateProfiledPredictor(profiled, traceFile, maxLines);
-        totalBranches = profiledResult[0];
-        mispredictions = profiledResult[1];
-        mispredictionRate = (totalBranches > 0) ? 
-            (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
-
-        csv << traceName << ","
-            << profiled.getName() << ","
-            << totalBranches << ","
-            << mispredictions << ","
-            << std::fixed << std::setprecision(2) << mispredictionRate << "\n";
-        // -------------------------------------------------------------
-
-        // -------------------------------------------------------------
-        // Create and evaluate profiled 2bit predictor
-        Profiled2BitPredictor profiled2Bit(2048);
-        std::cout << "Evaluating profiled predictor..." << std::endl;
-        profiledResult = evaluateProfiled2BitPredictor(profiled2Bit, traceFile, maxLines);
-        totalBranches = profiledResult[0];
-        mispredictions = profiledResult[1];
-        mispredictionRate = (totalBranches > 0) ? 
-            (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
-
-        csv << traceName << ","
-            << profiled2Bit.getName() << ","
-            << totalBranches << ","
-            << mispredictions << ","
-            << std::fixed << std::setprecision(2) << mispredictionRate << "\n";
-        // -------------------------------------------------------------
     }
     csv.close();
-        std::cout << "Results written to " << csvFile << std::endl;
-}
\ No newline at end of file
+    if (columnar) columnar->close();
+    std::cout << "Results written to " << csvFile << std::endl;
+    if (columnar) std::cout << "Columnar results written to " << columnarPath(csvFile) << std::endl;
+}
+
+void runAliasing(std::vector<std::string> traceFiles, const std::string& outputDir) {
+    std::string summaryFile = outputDir + "/aliasing.csv";
+    std::string entriesFile = outputDir + "/aliasing_entries.csv";
+    std::string pcsFile = outputDir + "/aliasing_pcs.csv";
+    std::ofstream summary(summaryFile), entries(entriesFile), pcs(pcsFile);
+    if (!summary.is_open() || !entries.is_open() || !pcs.is_open()) {
+        std::cerr << "Error: Could not open CSV files in " << outputDir << std::endl;
+        return;
+    }
+    summary << "TraceFile,Predictor,TableEntries,OccupiedEntries,Occupancy_pct,Accesses,Collisions,"
+            << "Constructive,Destructive,Neutral,Collision_pct,Destructive_pct,MispredictionRate\n";
+    entries << "TraceFile,Predictor,Rank,Index,Accesses,Collisions,Constructive,Destructive,Neutral\n";
+    pcs << "TraceFile,Predictor,Rank,PC,Accesses,Collisions,Constructive,Destructive,Neutral\n";
+
+    const std::vector<ColumnSpec> countColumns = {
+        {"Accesses", ColumnType::UInt64}, {"Collisions", ColumnType::UInt64}, {"Constructive", ColumnType::UInt64},
+        {"Destructive", ColumnType::UInt64}, {"Neutral", ColumnType::UInt64},
+    };
+    auto withCounts = [&](std::vector<ColumnSpec> columns) {
+        columns.insert(columns.end(), countColumns.begin(), countColumns.end());
+        return columns;
+    };
+    auto summaryColumnar = columnarFor(summaryFile, {
+        {"TraceFile", ColumnType::String}, {"Predictor", ColumnType::String}, {"TableEntries", ColumnType::UInt64},
+        {"OccupiedEntries", ColumnType::UInt64}, {"Occupancy_pct", ColumnType::Float64},
+        {"Accesses", ColumnType::UInt64}, {"Collisions", ColumnType::UInt64}, {"Constructive", ColumnType::UInt64},
+        {"Destructive", ColumnType::UInt64}, {"Neutral", ColumnType::UInt64}, {"Collision_pct", ColumnType::Float64},
+        {"Destructive_pct", ColumnType::Float64}, {"MispredictionRate", ColumnType::Float64},
+    }, {{"table", "aliasing"}});
+    auto entriesColumnar = columnarFor(entriesFile, withCounts({
+        {"TraceFile", ColumnType::String}, {"Predictor", ColumnType::String}, {"Rank", ColumnType::UInt64},
+        {"Index", ColumnType::UInt64},
+    }), {{"table", "aliasing entries"}});
+    auto pcsColumnar = columnarFor(pcsFile, withCounts({
+        {"TraceFile", ColumnType::String}, {"Predictor", ColumnType::String}, {"Rank", ColumnType::UInt64},
+        {"PC", ColumnType::UInt64},
+    }), {{"table", "aliasing pcs"}});
+
+    for (std::string traceFile: traceFiles) {
+        std::string traceName = getTraceBaseName(traceFile);
+        std::cout << "Aliasing analysis of " << traceFile << std::endl;
+
+        // evaluate an instrumented predictor and write its three reports
+        auto report = [&](BranchPredictor& predictor, const AliasTracker& tracker) {
+            std::cout << "Evaluating " << predictor.getName() << " predictor..." << std::endl;
+            auto result = evaluatePredictor(predictor, traceFile);
+            double mispredictionRate = (result[0] > 0) ?
+                (static_cast<double>(result[1]) / result[0]) * 100.0 : 0.0;
+
+            AliasCounts total = tracker.totals();
+            size_t occupied = tracker.occupiedEntries();
+            double accesses = std::max<size_t>(total.accesses, 1);
+            summary << traceName << "," << predictor.getName() << ","
+                    << tracker.entries() << "," << occupied << ","
+                    << std::fixed << std::setprecision(2) << 100.0 * occupied / tracker.entries() << ","
+                    << total.accesses << "," << total.collisions << ","
+                    << total.constructive << "," << total.destructive << "," << total.neutral << ","
+                    << 100.0 * total.collisions / accesses << ","
+                    << 100.0 * total.destructive / accesses << ","
+                    << mispredictionRate << "\n";
+            if (summaryColumnar) {
+                summaryColumnar->row(traceName, predictor.getName(), tracker.entries(), occupied,
+                                     100.0 * occupied / tracker.entries(), total.accesses, total.collisions,
+                                     total.constructive, total.destructive, total.neutral,
+                                     100.0 * total.collisions / accesses, 100.0 * total.destructive / accesses,
+                                     mispredictionRate);
+            }
+
+            auto writeCounts = [](std::ofstream& out, const AliasCounts& counts) {
+                out << counts.accesses << "," << counts.collisions << "," << counts.constructive << ","
+                    << counts.destructive << "," << counts.neutral << "\n";
+            };
+            size_t rank = 1;
+            for (const auto& entry : tracker.hottestEntries(ALIASING_REPORT_ROWS)) {
+                if (entriesColumnar) {
+                    const AliasCounts& c = entry.second;
+                    entriesColumnar->row(traceName, predictor.getName(), rank, entry.first,
+                                         c.accesses, c.collisions, c.constructive, c.destructive, c.neutral);
+                }
+                entries << traceName << "," << predictor.getName() << "," << rank++ << "," << entry.first << ",";
+                writeCounts(entries, entry.second);
+            }
+            rank = 1;
+            for (const auto& entry : tracker.hottestPCs(ALIASING_REPORT_ROWS)) {
+                if (pcsColumnar) {
+                    const AliasCounts& c = entry.second;
+                    pcsColumnar->row(traceName, predictor.getName(), rank, entry.first,
+                                     c.accesses, c.collisions, c.constructive, c.destructive, c.neutral);
+                }
+                pcs << traceName << "," << predictor.getName() << "," << rank++ << ",0x"
+                    << std::hex << entry.first << std::dec << ",";
+                writeCounts(pcs, entry.second);
+            }
+
+            std::cout << "Occupancy: " << std::fixed << std::setprecision(2) << 100.0 * occupied / tracker.entries()
+                      << "%, collisions: " << 100.0 * total.collisions / accesses
+                      << "% (constructive " << total.constructive << ", destructive " << total.destructive
+                      << ", neutral " << total.neutral << ")" << std::endl << std::endl;
+        };
+
+        for (size_t size : {512, 1024, 2048, 4096}) {
+            BasicTwoBitPredictor<AliasTracker> twoBit(size);
+            report(twoBit, twoBit.aliasTracker());
+        }
+        BasicGSharePredictor<AliasTracker> gshare(2048);
+        report(gshare, gshare.aliasTracker());
+    }
+    std::cout << "Aliasing reports written to " << summaryFile << ", " << entriesFile << " and " << pcsFile << std::endl;
+}
@@ -0,0 +1,40 @@
+#include "utils/experiment.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+void printUsage() {
+    std::cout << "Usage: merge-results [options] shard_file...\n"
+              << "  -o, --out FILE  merged results (default results/results_predict.csv)\n"
+              << "Combines the per-shard files of branch-predictor --shard i/N into one results\n"
+              << "CSV in job matrix order, and their per-class files (<shard>_classes.shard-i-of-N.csv)\n"
+              << "into <output>_classes.csv. Fails without writing if a job is missing or duplicated.\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string output = "results/results_predict.csv";
+    std::vector<std::string> shardFiles;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "-o" || arg == "--out") output = value();
+            else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+            else if (!arg.empty() && arg[0] == '-') throw std::invalid_argument("Unknown option " + arg);
+            else shardFiles.push_back(arg);
+        }
+        if (shardFiles.empty()) throw std::invalid_argument("No shard files given");
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    return mergeShardResults(shardFiles, output) ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "predictor/counter.hpp"
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// ==== table aliasing instrumentation ====
+// Table predictors take an aliasing policy as a template parameter and call
+// record() on every update. NoAliasTracking is empty and its calls inline
+// away; AliasTracker tags each entry with the PC that last updated it.
+//
+// An update of an entry last written by another PC is a collision. Each
+// collision is classified against an interference-free copy of the predictor
+// (one private counter per PC and history): constructive if only the shared
+// entry predicted correctly, destructive if only the private counter did,
+// neutral if both agree.
+
+struct AliasCounts {
+    size_t accesses = 0;
+    size_t collisions = 0;
+    size_t constructive = 0;
+    size_t destructive = 0;
+    size_t neutral = 0;
+};
+
+// Default policy, compiles to nothing
+struct NoAliasTracking {
+    static constexpr bool enabled = false;
+    void resize(size_t entries) {}
+    void record(size_t index, uint64_t pc, uint64_t history, bool prediction, bool taken) {}
+    void reset() {}
+};
+
+class AliasTracker {
+private:
+    struct Context {
+        uint64_t pc;
+        uint64_t history;
+        bool operator==(const Context& other) const { return pc == other.pc && history == other.history; }
+    };
+    struct ContextHash {
+        size_t operator()(const Context& c) const {
+            return static_cast<size_t>((c.pc * 0x9E3779B97F4A7C15ULL) ^ (c.history * 0xC2B2AE3D27D4EB4FULL));
+        }
+    };
+
+    std::vector<uint64_t> lastWriter;           // entry -> PC of the last update
+    std::vector<bool> written;                  // entry -> updated at least once
+    std::vector<AliasCounts> entryCounts;       // entry -> counts
+    std::unordered_map<uint64_t, AliasCounts> pcCounts;             // PC -> counts of its updates
+    std::unordered_map<Context, State, ContextHash> privateCounters;  // interference-free counters
+
+public:
+    static constexpr bool enabled = true;
+
+    void resize(size_t entries) {
+        lastWriter.assign(entries, 0);
+        written.assign(entries, false);
+        entryCounts.assign(entries, AliasCounts());
+    }
+
+    // Called before entry index is updated with the outcome of pc; prediction
+    // is what the shared entry predicted, history the part of the index that
+    // is not the PC (0 for PC-indexed tables)
+    void record(size_t index, uint64_t pc, uint64_t history, bool prediction, bool taken) {
+        auto inserted = privateCounters.try_emplace(Context{pc, history}, WEAKLY_TAKEN);
+        State& own = inserted.first->second;
+        bool ownPrediction = (own >= WEAKLY_TAKEN);
+        updateCounterState(taken, own);
+
+        AliasCounts& entry = entryCounts[index];
+        AliasCounts& branch = pcCounts[pc];
+        entry.accesses++;
+        branch.accesses++;
+        if (written[index] && lastWriter[index] != pc) {
+            size_t AliasCounts::* kind = &AliasCounts::neutral;
+            if (prediction != ownPrediction) {
+                kind = (prediction == taken) ? &AliasCounts::constructive : &AliasCounts::destructive;
+            }
+            entry.collisions++;
+            branch.collisions++;
+            entry.*kind += 1;
+            branch.*kind += 1;
+        }
+        lastWriter[index] = pc;
+        written[index] = true;
+    }
+
+    void reset() {
+        resize(lastWriter.size());
+        pcCounts.clear();
+        privateCounters.clear();
+    }
+
+    size_t entries() const { return entryCounts.size(); }
+
+    // Entries updated at least once
+    size_t occupiedEntries() const {
+        return std::count(written.begin(), written.end(), true);
+    }
+
+    AliasCounts totals() const {
+        AliasCounts total;
+        for (const AliasCounts& counts : entryCounts) {
+            total.accesses += counts.accesses;
+            total.collisions += counts.collisions;
+            total.constructive += counts.constructive;
+            total.destructive += counts.destructive;
+            total.neutral += counts.neutral;
+        }
+        return total;
+    }
+
+    const AliasCounts& entry(size_t index) const { return entryCounts[index]; }
+
+    // Up to n entries with the most destructive collisions, then the most collisions
+    std::vector<std::pair<size_t, AliasCounts>> hottestEntries(size_t n) const {
+        std::vector<std::pair<size_t, AliasCounts>> hottest;
+        for (size_t i = 0; i < entryCounts.size(); i++) {
+            if (entryCounts[i].collisions > 0) hottest.emplace_back(i, entryCounts[i]);
+        }
+        return topByConflicts(hottest, n);
+    }
+
+    // Up to n PCs suffering the most destructive collisions, then the most collisions
+    std::vector<std::pair<uint64_t, AliasCounts>> hottestPCs(size_t n) const {
+        std::vector<std::pair<uint64_t, AliasCounts>> hottest;
+        for (const auto& entry : pcCounts) {
+            if (entry.second.collisions > 0) hottest.push_back(entry);
+        }
+        return topByConflicts(hottest, n);
+    }
+
+private:
+    template <typename Key>
+    static std::vector<std::pair<Key, AliasCounts>> topByConflicts(std::vector<std::pair<Key, AliasCounts>> items, size_t n) {
+        std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+            if (a.second.destructive != b.second.destructive) return a.second.destructive > b.second.destructive;
+            if (a.second.collisions != b.second.collisions) return a.second.collisions > b.second.collisions;
+            return a.first < b.first;
+        });
+        if (items.size() > n) items.resize(n);
+        return items;
+    }
+};
@@ -2,7 +2,7 @@
 
 #include <string>
 #include <cstdint>
-#include <sstream>
+#include <cstdio>
 
 // Define a struct to hold branch information from the trace
 struct Branch {
@@ -14,13 +14,15 @@ struct Branch {
     bool taken;            // Was the branch taken?
 
     inline std::string toString() const {
-        std::stringstream ss;
-        ss << "PC: " << std::hex << pc << "\n"
-           << "Target: " << std::hex  << target << "\n"
-           << "Kind: " << kind << "\n"
-           << "Direct: " << (direct ? "Yes" : "No") << "\n"
-           << "Conditional: " << (conditional ? "Yes" : "No") << "\n"
-           << "Taken: " << (taken ? "Yes" : "No");
-        return ss.str();
+        char text[160];
+        int n = std::snprintf(text, sizeof(text),
+                              "PC: %llx\nTarget: %llx\nKind: %c\nDirect: %s\nConditional: %s\nTaken: %s",
+                              static_cast<unsigned long long>(pc),
+                              static_cast<unsigned long long>(target),
+                              kind,
+                              direct ? "Yes" : "No",
+                              conditional ? "Yes" : "No",
+                              taken ? "Yes" : "No");
+        return std::string(text, n > 0 ? n : 0);
     }
 };
\ No newline at end of file
@@ -1,4 +1,11 @@
+#pragma once
 
+#include "predictor/table_memory.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
 
 enum State {
      STRONGLY_NOT_TAKEN = 0, 
@@ -19,3 +26,45 @@ void updateCounterState(bool taken, State& currentState) {
         else if (currentState > STRONGLY_NOT_TAKEN) currentState = static_cast<State>(currentState - 1);
     }
 }
+
+// 2-bit counters packed 32 to a 64-bit word. A lookup reads one aligned word,
+// so it never straddles a cache line, and 256 counters fit in one line.
+class PackedCounters {
+private:
+    TableVector<uint64_t> words;
+    size_t count;
+
+public:
+    PackedCounters(size_t entries = 0, State initial = WEAKLY_TAKEN) { resize(entries, initial); }
+
+    void resize(size_t entries, State initial = WEAKLY_TAKEN) {
+        count = entries;
+        words.assign((entries + 31) / 32, 0);
+        fill(initial);
+    }
+
+    void fill(State initial) {
+        uint64_t pattern = 0;
+        for (int i = 0; i < 32; i++) pattern |= static_cast<uint64_t>(initial) << (2 * i);
+        std::fill(words.begin(), words.end(), pattern);
+    }
+
+    size_t size() const { return count; }
+
+    State get(size_t index) const {
+        return static_cast<State>((words[index >> 5] >> ((index & 31) * 2)) & 3);
+    }
+
+    // Update with an outcome, returning the prediction the counter made before
+    bool update(size_t index, bool taken) {
+        uint64_t& word = words[index >> 5];
+        unsigned shift = (index & 31) * 2;
+        State state = static_cast<State>((word >> shift) & 3);
+        bool prediction = (state >= WEAKLY_TAKEN);
+        updateCounterState(taken, state);
+        word = (word & ~(3ULL << shift)) | (static_cast<uint64_t>(state) << shift);
+        return prediction;
+    }
+
+    const void* address(size_t index) const { return &words[index >> 5]; }
+};
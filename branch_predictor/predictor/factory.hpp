@@ -0,0 +1,157 @@
+#pragma once
+
+#include "predictor/predictor.hpp"
+#include "predictor/two_level.hpp"
+#include "predictor/loop.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <functional>
+#include <cstdint>
+
+// ==== predictor specs ====
+// A predictor configuration is written as its type followed by key=value
+// parameters, e.g. "gshare size=2048". Parameters missing from a spec take
+// the type's default, so the canonical form (toString) lists every parameter
+// in name order and identifies the configuration, e.g. in result caches.
+// Any non-profiled type also takes loop=N, which puts an N-entry loop table
+// (predictor/loop.hpp) on top of it.
+
+const char* const LOOP_OVERRIDE_PARAM = "loop";
+
+struct PredictorSpec {
+    std::string type;
+    std::map<std::string, uint64_t> params;
+
+    uint64_t param(const std::string& key) const {
+        auto it = params.find(key);
+        if (it == params.end()) throw std::invalid_argument("Predictor " + type + " has no parameter " + key);
+        return it->second;
+    }
+
+    std::string toString() const {
+        std::string text = type;
+        for (const auto& entry : params) {
+            text += " " + entry.first + "=" + std::to_string(entry.second);
+        }
+        return text;
+    }
+
+    static PredictorSpec parse(const std::string& text);
+};
+
+// A predictor type: its parameters with their defaults and a constructor
+struct PredictorType {
+    std::string name;
+    std::vector<std::pair<std::string, uint64_t>> params;
+    std::function<std::unique_ptr<BranchPredictor>(const PredictorSpec&)> create;
+    bool profiled = false;      // needs a profiling pass before prediction
+};
+
+inline size_t checkedTableSize(const PredictorSpec& spec, const std::string& key = "size") {
+    uint64_t size = spec.param(key);
+    if (size == 0 || (size & (size - 1)) != 0) {
+        throw std::invalid_argument(spec.type + " " + key + " must be a power of two, got " + std::to_string(size));
+    }
+    return static_cast<size_t>(size);
+}
+
+inline size_t checkedHistoryBits(const PredictorSpec& spec, size_t maxBits, const std::string& key = "history") {
+    uint64_t bits = spec.param(key);
+    if (bits == 0 || bits > maxBits) {
+        throw std::invalid_argument(spec.type + " " + key + " must be 1 to " + std::to_string(maxBits) +
+                                    " bits, got " + std::to_string(bits));
+    }
+    return static_cast<size_t>(bits);
+}
+
+// All predictor types known to specs
+inline const std::vector<PredictorType>& predictorTypes() {
+    static const std::vector<PredictorType> types = {
+        {"always_taken", {},
+         [](const PredictorSpec&) { return std::make_unique<AlwaysTakenPredictor>(); }},
+        {"2bit", {{"size", 2048}},
+         [](const PredictorSpec& s) { return std::make_unique<TwoBitPredictor>(checkedTableSize(s)); }},
+        {"gshare", {{"size", 2048}, {"history", 0}},      // history 0 = log2(size)
+         [](const PredictorSpec& s) {
+             size_t history = s.param("history") > 0 ? checkedHistoryBits(s, MAX_GLOBAL_HISTORY_BITS) : 0;
+             return std::make_unique<GSharePredictor>(checkedTableSize(s), history);
+         }},
+        {"profiled", {{"size", 2048}},
+         [](const PredictorSpec& s) { return std::make_unique<ProfiledPredictor>(checkedTableSize(s)); }, true},
+        {"profiled_2bit", {{"size", 2048}},
+         [](const PredictorSpec& s) { return std::make_unique<Profiled2BitPredictor>(checkedTableSize(s)); }, true},
+        {"pag", {{"history", 10}, {"bht", 1024}, {"hash", 0}},
+         [](const PredictorSpec& s) {
+             return std::make_unique<TwoLevelLocalPredictor>(LocalHistoryScheme::PAg,
+                 checkedHistoryBits(s, MAX_LOCAL_HISTORY_BITS), checkedTableSize(s, "bht"), 1, s.param("hash") != 0);
+         }},
+        {"pap", {{"history", 8}, {"bht", 1024}, {"phts", 64}, {"hash", 0}},
+         [](const PredictorSpec& s) {
+             return std::make_unique<TwoLevelLocalPredictor>(LocalHistoryScheme::PAp,
+                 checkedHistoryBits(s, MAX_LOCAL_HISTORY_BITS), checkedTableSize(s, "bht"),
+                 checkedTableSize(s, "phts"), s.param("hash") != 0);
+         }},
+        {"loop", {{"entries", 64}, {"ways", LOOP_DEFAULT_WAYS}},
+         [](const PredictorSpec& s) { return std::make_unique<LoopPredictor>(nullptr, checkedTableSize(s, "entries"), checkedTableSize(s, "ways")); }},
+        {"sag", {{"history", 10}, {"sets", 64}, {"block", 64}, {"hash", 1}},
+         [](const PredictorSpec& s) {
+             return std::make_unique<TwoLevelLocalPredictor>(LocalHistoryScheme::SAg,
+                 checkedHistoryBits(s, MAX_LOCAL_HISTORY_BITS), checkedTableSize(s, "sets"), 1, s.param("hash") != 0,
+                 checkedTableSize(s, "block"));
+         }},
+    };
+    return types;
+}
+
+inline const PredictorType& findPredictorType(const std::string& name) {
+    for (const auto& type : predictorTypes()) {
+        if (type.name == name) return type;
+    }
+    std::string known;
+    for (const auto& type : predictorTypes()) known += (known.empty() ? "" : ", ") + type.name;
+    throw std::invalid_argument("Unknown predictor type " + name + " (known: " + known + ")");
+}
+
+inline std::unique_ptr<BranchPredictor> createPredictor(const PredictorSpec& spec);
+
+// Parse "type key=value ...", filling in defaults
+inline PredictorSpec PredictorSpec::parse(const std::string& text) {
+    std::istringstream in(text);
+    PredictorSpec spec;
+    if (!(in >> spec.type)) throw std::invalid_argument("Empty predictor spec");
+    const PredictorType& type = findPredictorType(spec.type);
+    for (const auto& param : type.params) spec.params[param.first] = param.second;
+
+    std::string token;
+    while (in >> token) {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos) throw std::invalid_argument("Expected key=value in predictor spec, got " + token);
+        std::string key = token.substr(0, eq);
+        if (key == LOOP_OVERRIDE_PARAM && spec.type != "loop") {
+            if (type.profiled) throw std::invalid_argument("Profiled predictors cannot take a loop table");
+            uint64_t entries = std::stoull(token.substr(eq + 1));
+            if (entries > 0) spec.params[key] = entries;
+            else spec.params.erase(key);
+            continue;
+        }
+        if (spec.params.find(key) == spec.params.end()) {
+            throw std::invalid_argument("Predictor " + spec.type + " has no parameter " + key);
+        }
+        spec.params[key] = std::stoull(token.substr(eq + 1));
+    }
+    createPredictor(spec);  // reject invalid parameter values up front
+    return spec;
+}
+
+inline std::unique_ptr<BranchPredictor> createPredictor(const PredictorSpec& spec) {
+    std::unique_ptr<BranchPredictor> predictor = findPredictorType(spec.type).create(spec);
+    if (spec.params.count(LOOP_OVERRIDE_PARAM)) {
+        predictor = std::make_unique<LoopPredictor>(std::move(predictor), checkedTableSize(spec, LOOP_OVERRIDE_PARAM));
+    }
+    return predictor;
+}
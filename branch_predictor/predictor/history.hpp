@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+// ==== long global history ====
+// Outcome (or path) bits in a circular buffer of 64-bit words, so a push is
+// O(1) whatever the history length. Predictors index their tables through
+// folded views: the newest `length` bits XOR-folded down to `width` bits,
+// kept up to date incrementally on every push (the new bit enters at the
+// bottom, the bit leaving the window is cancelled at length % width, and the
+// bit shifted out of the top wraps around), so the cost per push is
+// O(views), not O(history length). Histories shorter than 64 bits live in
+// a single shift register.
+
+const size_t MAX_GLOBAL_HISTORY_BITS = 8192;
+
+class GlobalHistory {
+private:
+    struct FoldedView {
+        size_t length;
+        size_t width;
+        size_t outPoint;    // length % width, where the leaving bit is cancelled
+        uint64_t mask;
+        uint64_t value;
+    };
+
+    std::vector<uint64_t> words;
+    size_t capacityMask;    // capacity (power of two bits) - 1
+    size_t head = 0;        // position of the newest bit
+    uint64_t newest = 0;    // the newest 64 bits as a shift register, newest in bit 0
+    bool registerOnly;      // shorter than 64 bits and no views, push only shifts
+    size_t maxLength;
+    std::vector<FoldedView> views;
+
+    bool bitAt(size_t position) const {
+        return (words[position >> 6] >> (position & 63)) & 1;
+    }
+
+    static void foldIn(FoldedView& view, uint64_t entering, uint64_t leaving) {
+        uint64_t value = (view.value << 1) | entering;
+        value ^= leaving << view.outPoint;
+        value ^= value >> view.width;
+        view.value = value & view.mask;
+    }
+
+    void pushViews(bool bit) {
+        if (maxLength < 64) {
+            // the shift register holds the whole history and every leaving bit
+            for (FoldedView* view = views.data(), *end = view + views.size(); view != end; ++view) {
+                foldIn(*view, bit, (newest >> view->length) & 1);
+            }
+            return;
+        }
+        // locals, so stores to the buffer do not force reloads of the members
+        const size_t mask = capacityMask;
+        const size_t position = (head + 1) & mask;
+        uint64_t* data = words.data();
+        head = position;
+        data[position >> 6] = (data[position >> 6] & ~(uint64_t(1) << (position & 63))) |
+                              (static_cast<uint64_t>(bit) << (position & 63));
+        for (FoldedView* view = views.data(), *end = view + views.size(); view != end; ++view) {
+            size_t leavingPosition = (position - view->length) & mask;     // the new bit itself if length is 0
+            foldIn(*view, bit, (data[leavingPosition >> 6] >> (leavingPosition & 63)) & 1);
+        }
+    }
+
+public:
+    // Keeps at least maxLength bits of history
+    explicit GlobalHistory(size_t maxLength) : maxLength(maxLength) {
+        if (maxLength > MAX_GLOBAL_HISTORY_BITS) {
+            throw std::invalid_argument("Global history is limited to " + std::to_string(MAX_GLOBAL_HISTORY_BITS) + " bits");
+        }
+        size_t capacity = 64;
+        while (capacity < maxLength + 1) capacity <<= 1;    // + 1 for the bit leaving the longest view
+        words.assign(capacity / 64, 0);
+        capacityMask = capacity - 1;
+        registerOnly = maxLength < 64;
+    }
+
+    // Register a view of the newest length bits folded to width bits (1 to 63), returns its id
+    size_t addFoldedView(size_t length, size_t width) {
+        if (length > maxLength || width == 0 || width > 63) {
+            throw std::invalid_argument("Invalid folded history view");
+        }
+        views.push_back({length, width, length % width, (uint64_t(1) << width) - 1, 0});
+        registerOnly = false;
+        return views.size() - 1;
+    }
+
+    void push(bool bit) {
+        newest = (newest << 1) | bit;
+        if (registerOnly) return;
+        pushViews(bit);
+    }
+
+    uint64_t folded(size_t view) const { return views[view].value; }
+
+    // Bit pushed age pushes ago (age < length()), 0 = newest
+    bool bit(size_t age) const {
+        return maxLength < 64 ? (newest >> age) & 1 : bitAt((head - age) & capacityMask);
+    }
+
+    // The newest n bits (n <= 64), newest in bit 0
+    uint64_t recent(size_t n) const {
+        return n >= 64 ? newest : newest & ((uint64_t(1) << n) - 1);
+    }
+
+    size_t length() const { return maxLength; }
+
+    void reset() {
+        std::fill(words.begin(), words.end(), 0);
+        head = 0;
+        newest = 0;
+        for (FoldedView& view : views) view.value = 0;
+    }
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "predictor/predictor.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+// ==== loop predictor ====
+// A small set-associative table of loop branches. Each entry learns the trip
+// count of a loop (executions of the branch per loop instance, exit
+// included) and counts the current iteration; once the same trip count has
+// been seen LOOP_CONFIDENCE_MAX times in a row it predicts the exit, which
+// counter and history predictors miss on every loop instance.
+//
+// The table overrides a base predictor's confident predictions and is only
+// trained on branches the base predictor mispredicts: a new entry assumes the
+// mispredicted outcome was a loop exit. Without a base predictor, taken is
+// predicted outside confident loops. Entries are 8 bytes, so the default 64
+// entries take 512 bytes.
+
+const size_t LOOP_DEFAULT_WAYS = 4;
+const uint8_t LOOP_CONFIDENCE_MAX = 3;
+const uint8_t LOOP_AGE_MAX = 7;
+const uint16_t LOOP_MAX_ITERATIONS = (1 << 14) - 1;     // 14-bit trip and iteration counters
+const unsigned LOOP_TAG_BITS = 14;
+
+class LoopTable {
+private:
+    struct Entry {
+        uint16_t tag = 0;
+        uint16_t tripCount = 0;     // 0 until the first exit is seen
+        uint16_t iteration = 0;     // executions in the current loop instance
+        uint8_t confidence : 2;
+        uint8_t age : 3;            // replacement priority, 0 = free to replace
+        uint8_t direction : 1;      // outcome inside the loop, the exit is !direction
+        uint8_t valid : 1;
+
+        Entry() : confidence(0), age(0), direction(0), valid(0) {}
+    };
+
+    TableVector<Entry> entries;
+    size_t ways;
+    size_t setMask;
+    unsigned setBits;
+
+    size_t setIndex(uint64_t pc) const { return (pc & setMask) * ways; }
+    uint16_t tagOf(uint64_t pc) const { return static_cast<uint16_t>((pc >> setBits) & ((1u << LOOP_TAG_BITS) - 1)); }
+
+    Entry* find(uint64_t pc) {
+        Entry* set = &entries[setIndex(pc)];
+        uint16_t tag = tagOf(pc);
+        for (size_t w = 0; w < ways; w++) {
+            if (set[w].valid && set[w].tag == tag) return &set[w];
+        }
+        return nullptr;
+    }
+
+    static bool predictEntry(const Entry* entry, bool fallback) {
+        if (!entry || entry->confidence < LOOP_CONFIDENCE_MAX) return fallback;
+        return (entry->iteration + 1 == entry->tripCount) ? !entry->direction : entry->direction;
+    }
+
+    void updateEntry(Entry* entry, uint64_t pc, bool taken, bool prediction, bool allocate) {
+        if (entry) {
+            bool wasConfident = entry->confidence == LOOP_CONFIDENCE_MAX;
+            if (++entry->iteration >= LOOP_MAX_ITERATIONS) {
+                entry->valid = 0;           // not a loop we can count
+                return;
+            }
+            if (taken != entry->direction) {
+                // loop exit
+                if (entry->iteration == entry->tripCount) {
+                    if (entry->confidence < LOOP_CONFIDENCE_MAX) entry->confidence++;
+                } else {
+                    entry->tripCount = entry->iteration;
+                    entry->confidence = 0;
+                }
+                entry->iteration = 0;
+            } else if (entry->tripCount > 0 && entry->iteration >= entry->tripCount) {
+                // the loop runs longer than it used to
+                entry->tripCount = 0;
+                entry->confidence = 0;
+            }
+            if (wasConfident) {
+                if (prediction == taken && entry->age < LOOP_AGE_MAX) entry->age++;
+                else if (prediction != taken) entry->age = 0;
+            }
+            return;
+        }
+        if (!allocate) return;
+
+        Entry* set = &entries[setIndex(pc)];
+        Entry* victim = nullptr;
+        for (size_t w = 0; w < ways && !victim; w++) {
+            if (!set[w].valid || set[w].age == 0) victim = &set[w];
+        }
+        if (!victim) {
+            // every way is in use, age them so a later allocation succeeds
+            for (size_t w = 0; w < ways; w++) set[w].age--;
+            return;
+        }
+        *victim = Entry();
+        victim->valid = 1;
+        victim->tag = tagOf(pc);
+        victim->direction = !taken;
+        victim->age = LOOP_AGE_MAX;
+    }
+
+    static size_t checkedSize(size_t size, size_t ways) {
+        auto powerOfTwo = [](size_t n) { return n > 0 && (n & (n - 1)) == 0; };
+        if (!powerOfTwo(size) || !powerOfTwo(ways)) {
+            throw std::invalid_argument("Loop table entries and ways must be powers of two, got " +
+                                        std::to_string(size) + " entries, " + std::to_string(ways) + " ways");
+        }
+        if (size < ways) throw std::invalid_argument("Loop table entries must be at least the number of ways");
+        return size;
+    }
+
+public:
+    // entries / ways sets, both powers of two
+    LoopTable(size_t size, size_t ways = LOOP_DEFAULT_WAYS) : entries(checkedSize(size, ways)), ways(ways) {
+        size_t sets = std::max<size_t>(1, size / ways);
+        setMask = sets - 1;
+        setBits = 0;
+        while ((size_t(1) << setBits) < sets) setBits++;
+    }
+
+    // Override a prediction if the branch is a confident loop
+    bool predict(uint64_t pc, bool fallback) {
+        return predictEntry(find(pc), fallback);
+    }
+
+    // Train with the outcome; allocate an entry if the branch is new and was mispredicted
+    void update(uint64_t pc, bool taken, bool prediction, bool allocate) {
+        updateEntry(find(pc), pc, taken, prediction, allocate);
+    }
+
+    // predict() and update() with one lookup, allocating if fallback was wrong
+    bool process(uint64_t pc, bool taken, bool fallback) {
+        Entry* entry = find(pc);
+        bool prediction = predictEntry(entry, fallback);
+        updateEntry(entry, pc, taken, prediction, fallback != taken);
+        return prediction;
+    }
+
+    size_t size() const { return entries.size(); }
+
+    void reset() { std::fill(entries.begin(), entries.end(), Entry()); }
+
+    // Modeled entry: tag, trip count, iteration, confidence, age, direction, valid
+    uint64_t storageBits() const {
+        return entries.size() * (LOOP_TAG_BITS + 14 + 14 + 2 + 3 + 1 + 1);
+    }
+};
+
+// Loop table on top of any predictor, or on its own if base is null
+class LoopPredictor : public BranchPredictor {
+private:
+    std::unique_ptr<BranchPredictor> base;
+    LoopTable loops;
+    bool basePrediction = true;         // between predict() and update()
+    std::vector<uint8_t> basePredictions;
+
+public:
+    LoopPredictor(std::unique_ptr<BranchPredictor> base, size_t entries, size_t ways = LOOP_DEFAULT_WAYS)
+        : base(std::move(base)), loops(entries, ways) {}
+
+    bool predict(const Branch& branch) override {
+        basePrediction = base ? base->predict(branch) : true;
+        return loops.predict(branch.pc, basePrediction);
+    }
+
+    void update(const Branch& branch, bool predicted) override {
+        if (base) base->update(branch, basePrediction);
+        loops.update(branch.pc, branch.taken, predicted, basePrediction != branch.taken);
+    }
+
+    // The base predictor does not see the loop table, so it runs its own
+    // batched path first and the loop table adjusts its predictions
+    void processBatch(const Branch* branches, size_t count, uint8_t* predictions) override {
+        basePredictions.resize(count);
+        if (base) base->processBatch(branches, count, basePredictions.data());
+        else std::fill(basePredictions.begin(), basePredictions.end(), 1);
+        for (size_t i = 0; i < count; i++) {
+            predictions[i] = loops.process(branches[i].pc, branches[i].taken, basePredictions[i]);
+        }
+    }
+
+    std::string getName() const override {
+        std::stringstream ss;
+        if (base) ss << base->getName() << " + loop (" << loops.size() << ")";
+        else ss << "Loop (" << loops.size() << ")";
+        return ss.str();
+    }
+
+    void reset() override {
+        if (base) base->reset();
+        loops.reset();
+        basePrediction = true;
+    }
+
+    uint64_t storageBits() const override {
+        return loops.storageBits() + (base ? base->storageBits() : 0);
+    }
+};
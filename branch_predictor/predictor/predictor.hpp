@@ -2,6 +2,8 @@
 
 #include "predictor/branch.hpp"
 #include "predictor/counter.hpp"
+#include "predictor/aliasing.hpp"
+#include "predictor/history.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -17,6 +19,9 @@
 #include <sstream>
 #include <unordered_set>
 
+// How many branches ahead table predictors prefetch in processBatch
+const size_t PREFETCH_DISTANCE = 16;
+
 // Base class for all branch predictors
 class BranchPredictor {
 public:
@@ -33,6 +38,24 @@ public:
     
     // Reset the predictor state
     virtual void reset() = 0;
+
+    // Modeled hardware storage in bits (tables and history registers)
+    virtual uint64_t storageBits() const { return 0; }
+
+    // The state predict() would read for the branch, for divergence reports
+    // of predictor-validate; empty if the predictor does not describe it
+    virtual std::string describeState(const Branch& branch) const { return ""; }
+
+    // Predict and update a batch of branches in trace order, writing one
+    // prediction (0/1) per branch. Equivalent to calling predict() then
+    // update() for every branch; table predictors override it to prefetch.
+    virtual void processBatch(const Branch* branches, size_t count, uint8_t* predictions) {
+        for (size_t i = 0; i < count; i++) {
+            bool prediction = predict(branches[i]);
+            predictions[i] = prediction;
+            update(branches[i], prediction);
+        }
+    }
 };
 
 // Always Taken predictor - always predicts branch as taken
@@ -55,12 +78,14 @@ public:
     }
 };
 
-// 2-bit saturating counter predictor
-class TwoBitPredictor : public BranchPredictor {
+// 2-bit saturating counter predictor, AliasPolicy see predictor/aliasing.hpp
+template <typename AliasPolicy = NoAliasTracking>
+class BasicTwoBitPredictor : public BranchPredictor {
 private:    
-    std::vector<State> table;
+    TableVector<State> table;
     size_t tableSize;
     size_t indexMask;
+    AliasPolicy aliasing;
     
     // Convert PC to table index
     size_t getIndex(uint64_t pc) const {
@@ -68,9 +93,10 @@ private:
     }
     
 public:
-    TwoBitPredictor(size_t size) : tableSize(size) {
+    BasicTwoBitPredictor(size_t size) : tableSize(size) {
         // Initialize table with all entries as WEAKLY_TAKEN (2)
         table.resize(tableSize, WEAKLY_TAKEN);
+        aliasing.resize(tableSize);
         
         // Calculate mask for indexing (size - 1)
         indexMask = tableSize - 1;
@@ -84,46 +110,99 @@ public:
     void update(const Branch& branch, bool predicted) override {
         size_t index = getIndex(branch.pc);
         State& currentState = table[index];
+        aliasing.record(index, branch.pc, 0, currentState >= WEAKLY_TAKEN, branch.taken);
 
         // Update the counter state based on the actual outcome
         updateCounterState(branch.taken, currentState);
     }
+
+    // Indices only depend on the PC, so entries are prefetched a fixed distance ahead
+    void processBatch(const Branch* branches, size_t count, uint8_t* predictions) override {
+        if constexpr (AliasPolicy::enabled) {
+            BranchPredictor::processBatch(branches, count, predictions);
+            return;
+        }
+        for (size_t i = 0; i < std::min(count, PREFETCH_DISTANCE); i++) {
+            __builtin_prefetch(&table[getIndex(branches[i].pc)], 1);
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (i + PREFETCH_DISTANCE < count) {
+                __builtin_prefetch(&table[getIndex(branches[i + PREFETCH_DISTANCE].pc)], 1);
+            }
+            State& currentState = table[getIndex(branches[i].pc)];
+            predictions[i] = (currentState >= WEAKLY_TAKEN);
+            updateCounterState(branches[i].taken, currentState);
+        }
+    }
     
     std::string getName() const override {
         std::stringstream ss;
         ss << "2-bit (" << tableSize << ")";
         return ss.str();
     }
+
+    uint64_t storageBits() const override { return 2 * static_cast<uint64_t>(tableSize); }
+
+    std::string describeState(const Branch& branch) const override {
+        std::stringstream ss;
+        size_t index = getIndex(branch.pc);
+        ss << "index 0x" << std::hex << index << std::dec << ", counter " << table[index];
+        return ss.str();
+    }
     
     void reset() override {
         std::fill(table.begin(), table.end(), WEAKLY_TAKEN);
+        aliasing.reset();
     }
+
+    const AliasPolicy& aliasTracker() const { return aliasing; }
 };
 
-// gshare predictor - uses global history with XOR indexing
-class GSharePredictor : public BranchPredictor {
+using TwoBitPredictor = BasicTwoBitPredictor<>;
+
+// gshare predictor - uses global history with XOR indexing, AliasPolicy see predictor/aliasing.hpp.
+// The history length defaults to log2 of the table size; longer histories
+// are XOR-folded to the index width (predictor/history.hpp).
+template <typename AliasPolicy = NoAliasTracking>
+class BasicGSharePredictor : public BranchPredictor {
 private:    
-    std::vector<State> table;
+    TableVector<State> table;
     size_t tableSize;
     size_t indexMask;
-    size_t historyRegister;
-    int historyBits;
+    size_t historyBits;
+    GlobalHistory history;
+    bool foldHistory;                   // history longer than the index
+    uint64_t historyMask;               // history bits used in the index
+    size_t historyView = 0;             // history folded to the index width
+    std::vector<uint32_t> batchIndices; // scratch for processBatch, 32-bit so stores cannot alias the history
+    AliasPolicy aliasing;
+
+    static size_t indexBits(size_t size) {
+        return static_cast<size_t>(log2(size));
+    }
     
+    // History bits XORed into the index, folded if longer than the index
+    size_t historyIndex() const {
+        return (foldHistory ? history.folded(historyView) : history.recent(64)) & historyMask;
+    }
+
     // Get index using PC and history register
     size_t getIndex(uint64_t pc) const {
-        return ((pc & indexMask) ^ (historyRegister & indexMask));
+        return ((pc & indexMask) ^ historyIndex());
     }
     
 public:
-    GSharePredictor(size_t size) : tableSize(size), historyRegister(0) {
+    BasicGSharePredictor(size_t size, size_t historyLength = 0)
+        : tableSize(size), historyBits(historyLength > 0 ? historyLength : indexBits(size)), history(historyBits) {
         // Initialize table with all entries as WEAKLY_TAKEN (2)
         table.resize(tableSize, WEAKLY_TAKEN);
+        aliasing.resize(tableSize);
         
         // Calculate mask for indexing (size - 1)
         indexMask = tableSize - 1;
-        
-        // Calculate number of history bits to use (log2 of table size)
-        historyBits = static_cast<int>(log2(tableSize));
+        foldHistory = historyBits > indexBits(size);
+        historyMask = foldHistory ? indexMask : indexMask & ((uint64_t(1) << historyBits) - 1);
+        if (foldHistory) historyView = history.addFoldedView(historyBits, std::max<size_t>(1, indexBits(size)));
     }
     
     bool predict(const Branch& branch) override {
@@ -134,25 +213,69 @@ public:
     void update(const Branch& branch, bool predicted) override {
         size_t index = getIndex(branch.pc);
         State& currentState = table[index];
+        aliasing.record(index, branch.pc, historyIndex(), currentState >= WEAKLY_TAKEN, branch.taken);
         
         updateCounterState(branch.taken, currentState);
         
         // Update history register by shifting in the actual outcome
-        historyRegister = ((historyRegister << 1) | (branch.taken ? 1 : 0)) & ((1 << historyBits) - 1);
+        history.push(branch.taken);
+    }
+
+    // The history only depends on actual outcomes, so all indices of the batch
+    // are computed up front and their entries prefetched a fixed distance ahead
+    void processBatch(const Branch* branches, size_t count, uint8_t* predictions) override {
+        if constexpr (AliasPolicy::enabled) {
+            BranchPredictor::processBatch(branches, count, predictions);
+            return;
+        }
+        batchIndices.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            batchIndices[i] = getIndex(branches[i].pc);
+            history.push(branches[i].taken);
+        }
+        for (size_t i = 0; i < std::min(count, PREFETCH_DISTANCE); i++) {
+            __builtin_prefetch(&table[batchIndices[i]], 1);
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (i + PREFETCH_DISTANCE < count) {
+                __builtin_prefetch(&table[batchIndices[i + PREFETCH_DISTANCE]], 1);
+            }
+            State& currentState = table[batchIndices[i]];
+            predictions[i] = (currentState >= WEAKLY_TAKEN);
+            updateCounterState(branches[i].taken, currentState);
+        }
     }
     
     std::string getName() const override {
         std::stringstream ss;
-        ss << "gshare (" << tableSize << ")";
+        ss << "gshare";
+        if (historyBits != indexBits(tableSize)) ss << " h" << historyBits;
+        ss << " (" << tableSize << ")";
         return ss.str();
     }
     
     void reset() override {
         std::fill(table.begin(), table.end(), WEAKLY_TAKEN);
-        historyRegister = 0;
+        history.reset();
+        aliasing.reset();
+    }
+
+    // 2-bit counters plus the global history register
+    uint64_t storageBits() const override { return 2 * static_cast<uint64_t>(tableSize) + historyBits; }
+
+    std::string describeState(const Branch& branch) const override {
+        std::stringstream ss;
+        size_t index = getIndex(branch.pc);
+        ss << "index 0x" << std::hex << index << " (pc 0x" << (branch.pc & indexMask) << " ^ history 0x"
+           << historyIndex() << ")" << std::dec << ", counter " << table[index];
+        return ss.str();
     }
+
+    const AliasPolicy& aliasTracker() const { return aliasing; }
 };
 
+using GSharePredictor = BasicGSharePredictor<>;
+
 
 // Hardware-realistic basic Profiled predictor
 class ProfiledPredictor : public BranchPredictor {
@@ -212,6 +335,9 @@ class ProfiledPredictor : public BranchPredictor {
             // }
             return ss.str();
         }
+
+        // One direction bit per entry, the profile lives off-chip
+        uint64_t storageBits() const override { return tableSize; }
         
         void reset() override {
             takenCount.clear();
@@ -277,7 +403,7 @@ private:
     std::unordered_map<uint64_t, int> totalCount;     // PC -> total count
     
     // 2-bit counters table for prediction phase (hardware realistic)
-    std::vector<State> counterTable;
+    TableVector<State> counterTable;
     size_t tableSize;
     size_t indexMask;
     
@@ -333,6 +459,20 @@ public:
         // }
         return ss.str();
     }
+
+    uint64_t storageBits() const override { return 2 * static_cast<uint64_t>(tableSize); }
+
+    std::string describeState(const Branch& branch) const override {
+        std::stringstream ss;
+        if (profilingMode) {
+            auto seen = totalCount.find(branch.pc);
+            ss << "profiling, pc seen " << (seen == totalCount.end() ? 0 : seen->second) << " times";
+        } else {
+            size_t index = getIndex(branch.pc);
+            ss << "index 0x" << std::hex << index << std::dec << ", counter " << counterTable[index];
+        }
+        return ss.str();
+    }
     
     void reset() override {
         takenCount.clear();
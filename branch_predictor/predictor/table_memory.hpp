@@ -0,0 +1,199 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ==== table memory ====
+// Predictor tables and decoded trace columns are allocated through
+// TableAllocator. Blocks of at least HUGE_PAGE_SIZE bytes are mapped
+// directly, 2 MB aligned and rounded to whole huge pages, so the kernel can
+// back them with huge pages and the TLB covers a 64 MB table with 32
+// entries instead of 16384; smaller blocks come from the heap.
+//
+// tableMemory selects the backing at runtime (--huge-pages, --numa-local):
+//   none     plain mappings, the kernel's default transparent huge page policy
+//   thp      madvise(MADV_HUGEPAGE), transparent huge pages where available
+//   hugetlb  MAP_HUGETLB from the reserved pool (vm.nr_hugepages), falling
+//            back to thp when the pool is empty
+// With numaLocal the pages of a mapping are preferred on the NUMA node of
+// the allocating thread, and pinThreadToLocalNode() keeps a worker thread on
+// the node its tables live on. Allocation and release only depend on the
+// block size, so the policy can change while blocks are alive.
+
+const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+enum class HugePages { None, Transparent, Explicit };
+
+inline struct TableMemoryOptions {
+    HugePages hugePages = HugePages::None;
+    bool numaLocal = false;
+} tableMemory;
+
+// Bytes mapped so far with each backing, for reports
+struct TableMemoryStats {
+    std::atomic<uint64_t> mapped{0};        // plain mappings (none, or thp unavailable)
+    std::atomic<uint64_t> transparent{0};   // madvise(MADV_HUGEPAGE) mappings
+    std::atomic<uint64_t> hugetlb{0};       // MAP_HUGETLB mappings
+    std::atomic<uint64_t> numaBound{0};     // mappings preferring the allocating thread's node
+};
+
+inline TableMemoryStats& tableMemoryStats() {
+    static TableMemoryStats stats;
+    return stats;
+}
+
+inline HugePages parseHugePages(const std::string& mode) {
+    if (mode == "none") return HugePages::None;
+    if (mode == "thp") return HugePages::Transparent;
+    if (mode == "hugetlb") return HugePages::Explicit;
+    throw std::invalid_argument("Unknown huge page mode " + mode + " (none, thp, hugetlb)");
+}
+
+inline const char* hugePagesName(HugePages mode) {
+    switch (mode) {
+        case HugePages::None: return "none";
+        case HugePages::Transparent: return "thp";
+        case HugePages::Explicit: return "hugetlb";
+    }
+    return "unknown";
+}
+
+// NUMA node of the CPU the calling thread runs on
+inline int currentNumaNode() {
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return 0;
+    return static_cast<int>(node);
+}
+
+// Restrict the calling thread to the CPUs of the node it currently runs on,
+// returns false on single-node machines or if the node's CPUs are unknown
+inline bool pinThreadToLocalNode() {
+    int node = currentNumaNode();
+    std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::ifstream nodes("/sys/devices/system/node/online");
+    std::string cpus, online;
+    if (!std::getline(list, cpus) || !std::getline(nodes, online) || online == "0") return false;
+
+    // cpulist looks like "0-15,32-47"
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    size_t pos = 0;
+    while (pos < cpus.size()) {
+        size_t end = cpus.find(',', pos);
+        if (end == std::string::npos) end = cpus.size();
+        std::string range = cpus.substr(pos, end - pos);
+        size_t dash = range.find('-');
+        unsigned first = std::stoul(range.substr(0, dash));
+        unsigned last = (dash == std::string::npos) ? first : std::stoul(range.substr(dash + 1));
+        for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &set);
+        pos = end + 1;
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
+inline size_t hugePageRound(size_t bytes) {
+    return (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+}
+
+// Map a huge-page aligned block of hugePageRound(bytes), nullptr on failure
+inline void* mapTableMemory(size_t bytes) {
+    size_t length = hugePageRound(bytes);
+    TableMemoryStats& stats = tableMemoryStats();
+    void* block = MAP_FAILED;
+    bool hugetlb = false;
+
+    if (tableMemory.hugePages == HugePages::Explicit) {
+        block = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        hugetlb = block != MAP_FAILED;
+    }
+    if (block == MAP_FAILED) {
+        // over-map by one huge page and trim to an aligned block
+        char* raw = static_cast<char*>(mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (raw == MAP_FAILED) return nullptr;
+        uintptr_t address = reinterpret_cast<uintptr_t>(raw);
+        char* aligned = reinterpret_cast<char*>((address + HUGE_PAGE_SIZE - 1) & ~uintptr_t(HUGE_PAGE_SIZE - 1));
+        if (aligned > raw) munmap(raw, aligned - raw);
+        size_t tail = (raw + length + HUGE_PAGE_SIZE) - (aligned + length);
+        if (tail > 0) munmap(aligned + length, tail);
+        block = aligned;
+    }
+
+    if (hugetlb) {
+        stats.hugetlb += length;
+    } else if (tableMemory.hugePages != HugePages::None && madvise(block, length, MADV_HUGEPAGE) == 0) {
+        stats.transparent += length;
+    } else {
+        stats.mapped += length;
+    }
+
+    // before the first touch, so the pages are placed on the preferred node
+    if (tableMemory.numaLocal) {
+        unsigned long nodemask = 1UL << currentNumaNode();
+        if (syscall(SYS_mbind, block, length, MPOL_PREFERRED, &nodemask, sizeof(nodemask) * 8 + 1, 0) == 0) {
+            stats.numaBound += length;
+        }
+    }
+    return block;
+}
+
+inline void unmapTableMemory(void* block, size_t bytes) {
+    munmap(block, hugePageRound(bytes));
+}
+
+// Bytes of the current process backed by transparent huge pages (AnonHugePages)
+inline uint64_t anonHugePageBytes() {
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string key;
+    uint64_t kb;
+    while (smaps >> key) {
+        if (key == "AnonHugePages:" && smaps >> kb) return kb * 1024;
+        smaps.ignore(1 << 20, '\n');
+    }
+    return 0;
+}
+
+// std::allocator replacement mapping large blocks as above
+template <typename T>
+struct TableAllocator {
+    using value_type = T;
+
+    TableAllocator() = default;
+    template <typename U>
+    TableAllocator(const TableAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes < HUGE_PAGE_SIZE) return static_cast<T*>(::operator new(bytes));
+        void* block = mapTableMemory(bytes);
+        if (!block) throw std::bad_alloc();
+        return static_cast<T*>(block);
+    }
+
+    void deallocate(T* p, size_t n) {
+        size_t bytes = n * sizeof(T);
+        if (bytes < HUGE_PAGE_SIZE) ::operator delete(p);
+        else unmapTableMemory(p, bytes);
+    }
+
+    template <typename U>
+    bool operator==(const TableAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const TableAllocator<U>&) const { return false; }
+};
+
+// Vector for predictor tables and trace columns
+template <typename T>
+using TableVector = std::vector<T, TableAllocator<T>>;
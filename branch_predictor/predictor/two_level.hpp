@@ -0,0 +1,142 @@
+#pragma once
+
+#include "predictor/predictor.hpp"
+#include "predictor/counter.hpp"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+#include <cstdint>
+
+// ==== two-level local history predictors ====
+// Yeh and Patt's two-level adaptive predictors: a branch history table (BHT)
+// of per-branch (P) or per-set (S) outcome histories selects a 2-bit counter
+// in a pattern history table (PHT) that is either global (g) or one of
+// several tables selected by the branch address (p):
+//
+//   PAg  per-address histories, one global PHT
+//   PAp  per-address histories, per-address PHTs
+//   SAg  per-set histories, one global PHT
+//
+// A set is a group of branches sharing a history: SAg drops the offset
+// within a code block of blockBytes from the address before selecting the
+// BHT entry, so all branches of a block (and of the blocks aliasing onto
+// the same set) train one history, where PAg keeps one per branch address.
+// Histories are packed into 16-bit BHT entries. PHTs are stored as one
+// row of 2^historyBits packed counters per table, so a lookup reads one
+// history entry and one counter word, neither of which crosses a cache line,
+// and a PAp table's row of up to 256 counters shares a single line.
+// Addresses select BHT entries and PHTs either by their low bits or, with
+// hashed indexing, by a multiplicative (Fibonacci) hash of the whole PC
+// (of the block number for SAg).
+
+enum class LocalHistoryScheme { PAg, PAp, SAg };
+
+const size_t MAX_LOCAL_HISTORY_BITS = 16;
+
+class TwoLevelLocalPredictor : public BranchPredictor {
+private:
+    LocalHistoryScheme scheme;
+    size_t historyBits;
+    uint16_t historyMask;
+    size_t historyEntries;
+    size_t historyIndexBits;
+    size_t blockBytes;                  // SAg set granularity, 1 for per-address histories
+    size_t blockShift;
+    size_t patternTables;
+    size_t patternIndexBits;
+    bool hashedIndex;
+
+    TableVector<uint16_t> histories;
+    PackedCounters patterns;            // patternTables rows of 2^historyBits counters
+    std::vector<size_t> batchIndices;   // scratch for processBatch
+
+    static size_t log2Size(size_t size) {
+        size_t bits = 0;
+        while ((size_t(1) << bits) < size) bits++;
+        return bits;
+    }
+
+    // Select one of 2^bits entries by the branch address
+    size_t addressIndex(uint64_t pc, size_t bits) const {
+        if (bits == 0) return 0;
+        uint64_t mask = (uint64_t(1) << bits) - 1;
+        if (!hashedIndex) return pc & mask;
+        return (pc * 0x9E3779B97F4A7C15ULL) >> (64 - bits);
+    }
+
+    size_t historyIndex(uint64_t pc) const {
+        return addressIndex(pc >> blockShift, historyIndexBits);
+    }
+
+    size_t patternIndex(uint64_t pc, uint16_t history) const {
+        return (addressIndex(pc, patternIndexBits) << historyBits) | history;
+    }
+
+public:
+    // historyEntries, patternTables and blockBytes must be powers of two, historyBits at most MAX_LOCAL_HISTORY_BITS
+    TwoLevelLocalPredictor(LocalHistoryScheme scheme, size_t historyBits, size_t historyEntries,
+                           size_t patternTables = 1, bool hashedIndex = false, size_t blockBytes = 1)
+        : scheme(scheme), historyBits(historyBits),
+          historyMask(static_cast<uint16_t>((uint32_t(1) << historyBits) - 1)),
+          historyEntries(historyEntries), historyIndexBits(log2Size(historyEntries)),
+          blockBytes(blockBytes), blockShift(log2Size(blockBytes)),
+          patternTables(patternTables), patternIndexBits(log2Size(patternTables)), hashedIndex(hashedIndex) {
+        histories.resize(historyEntries, 0);
+        patterns.resize(patternTables << historyBits, WEAKLY_TAKEN);
+    }
+
+    bool predict(const Branch& branch) override {
+        uint16_t history = histories[historyIndex(branch.pc)];
+        return (patterns.get(patternIndex(branch.pc, history)) >= WEAKLY_TAKEN);
+    }
+
+    void update(const Branch& branch, bool predicted) override {
+        uint16_t& history = histories[historyIndex(branch.pc)];
+        patterns.update(patternIndex(branch.pc, history), branch.taken);
+        history = static_cast<uint16_t>(((history << 1) | (branch.taken ? 1 : 0)) & historyMask);
+    }
+
+    // Histories only depend on actual outcomes, so all PHT indices of the
+    // batch are computed first and their counter words prefetched ahead
+    void processBatch(const Branch* branches, size_t count, uint8_t* predictions) override {
+        batchIndices.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            uint16_t& history = histories[historyIndex(branches[i].pc)];
+            batchIndices[i] = patternIndex(branches[i].pc, history);
+            history = static_cast<uint16_t>(((history << 1) | (branches[i].taken ? 1 : 0)) & historyMask);
+        }
+        for (size_t i = 0; i < std::min(count, PREFETCH_DISTANCE); i++) {
+            __builtin_prefetch(patterns.address(batchIndices[i]), 1);
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (i + PREFETCH_DISTANCE < count) {
+                __builtin_prefetch(patterns.address(batchIndices[i + PREFETCH_DISTANCE]), 1);
+            }
+            predictions[i] = patterns.update(batchIndices[i], branches[i].taken);
+        }
+    }
+
+    std::string getName() const override {
+        std::stringstream ss;
+        switch (scheme) {
+            case LocalHistoryScheme::PAg: ss << "PAg h" << historyBits << " (" << historyEntries; break;
+            case LocalHistoryScheme::PAp: ss << "PAp h" << historyBits << " (" << historyEntries << "x" << patternTables; break;
+            case LocalHistoryScheme::SAg: ss << "SAg h" << historyBits << " (" << historyEntries << " sets of " << blockBytes << " B"; break;
+        }
+        if (hashedIndex) ss << " hashed";
+        ss << ")";
+        return ss.str();
+    }
+
+    void reset() override {
+        std::fill(histories.begin(), histories.end(), 0);
+        patterns.fill(WEAKLY_TAKEN);
+    }
+
+    uint64_t storageBits() const override {
+        return static_cast<uint64_t>(historyEntries) * historyBits +
+               2 * (static_cast<uint64_t>(patternTables) << historyBits);
+    }
+};
@@ -0,0 +1,218 @@
+#include "predictor/branch.hpp"
+#include "predictor/predictor.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+
+// Benchmark of scalar predict/update against processBatch for large tables,
+// or of the batched path with each table memory backing (--page-modes)
+
+struct BenchOptions {
+    size_t branches = 4000000;  // synthetic branches per run
+    size_t minLog = 10;         // smallest table, log2 entries
+    size_t maxLog = 24;         // largest table, log2 entries
+    size_t repeats = 3;         // best of N runs
+    std::string csvFile;        // optional CSV output
+    bool pageModes = false;     // compare huge page modes instead of scalar and batch
+};
+
+void printUsage() {
+    std::cout << "Usage: predictor-bench [options]\n"
+              << "  --branches N   synthetic branches per run (default 4000000)\n"
+              << "  --min-log L    smallest table size, log2 entries (default 10)\n"
+              << "  --max-log L    largest table size, log2 entries (default 24)\n"
+              << "  --repeats R    runs per measurement, best is reported (default 3)\n"
+              << "  --csv FILE     also write the results as CSV\n"
+              << "  --huge-pages MODE  table memory: none, thp or hugetlb (default none)\n"
+              << "  --numa-local   place table pages on the NUMA node of the benchmark thread\n"
+              << "  --page-modes   time processBatch with tables in none, thp and hugetlb memory\n";
+}
+
+// Branches spread over a wide PC range so that large tables miss in cache
+std::vector<Branch> makeBranches(size_t count, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<Branch> branches(count);
+    for (auto& branch : branches) {
+        uint64_t r = rng();
+        branch.pc = 0x400000 + ((r & 0x3FFFFFF) << 2);
+        branch.target = branch.pc + 0x40;
+        branch.kind = 'b';
+        branch.direct = true;
+        branch.conditional = true;
+        // per-PC bias with some noise
+        branch.taken = ((branch.pc >> 2) % 3 != 0) ^ ((r >> 40) % 10 == 0);
+    }
+    return branches;
+}
+
+// Best-of-N runtime in ns per branch, returns the misprediction count through mispredictions
+double timeRun(BranchPredictor& predictor, const std::vector<Branch>& branches, bool batched,
+               size_t repeats, size_t& mispredictions) {
+    double best = 1e30;
+    std::vector<uint8_t> predictions(branches.size());
+    for (size_t r = 0; r < repeats; r++) {
+        predictor.reset();
+        auto start = std::chrono::steady_clock::now();
+        if (batched) {
+            const size_t batchSize = 4096;
+            for (size_t i = 0; i < branches.size(); i += batchSize) {
+                size_t count = std::min(batchSize, branches.size() - i);
+                predictor.processBatch(&branches[i], count, &predictions[i]);
+            }
+        } else {
+            for (size_t i = 0; i < branches.size(); i++) {
+                bool prediction = predictor.predict(branches[i]);
+                predictions[i] = prediction;
+                predictor.update(branches[i], prediction);
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, seconds);
+    }
+    mispredictions = 0;
+    for (size_t i = 0; i < branches.size(); i++) {
+        if (predictions[i] != branches[i].taken) mispredictions++;
+    }
+    return best * 1e9 / branches.size();
+}
+
+using PredictorFactory = std::function<std::unique_ptr<BranchPredictor>(size_t)>;
+
+// Batched runtime of every table size with tables in each huge page mode.
+// Hugetlb falls back to thp without a reserved pool, the backing column
+// shows what the table got and huge MB the process's transparent huge pages.
+int benchPageModes(const std::vector<PredictorFactory>& factories, const std::vector<Branch>& branches,
+                   const BenchOptions& options, std::ofstream& csv) {
+    const HugePages modes[] = {HugePages::None, HugePages::Transparent, HugePages::Explicit};
+    if (csv.is_open()) csv << "Predictor,TableSize,HugePages,Backing,AnonHugePagesMB,BatchNsPerBranch,SpeedupOverNone\n";
+    std::cout << std::left << std::setw(22) << "Predictor" << std::setw(10) << "pages" << std::setw(10) << "backing"
+              << std::right << std::setw(9) << "huge MB" << std::setw(12) << "batch ns" << std::setw(10) << "speedup" << std::endl;
+
+    HugePages selected = tableMemory.hugePages;
+    int failures = 0;
+    for (auto& factory : factories) {
+        for (size_t log = options.minLog; log <= options.maxLog; log += 2) {
+            double baseline = 0;
+            size_t baselineMisses = 0;
+            for (HugePages mode : modes) {
+                TableMemoryStats& stats = tableMemoryStats();
+                uint64_t hugetlb = stats.hugetlb, transparent = stats.transparent;
+                tableMemory.hugePages = mode;
+                auto predictor = factory(size_t(1) << log);
+                const char* backing = stats.hugetlb > hugetlb ? "hugetlb"
+                                    : stats.transparent > transparent ? "thp" : "4k";
+
+                size_t misses = 0;
+                double batch = timeRun(*predictor, branches, true, options.repeats, misses);
+                uint64_t hugeMB = anonHugePageBytes() / (1024 * 1024);
+                if (mode == HugePages::None) {
+                    baseline = batch;
+                    baselineMisses = misses;
+                }
+
+                std::cout << std::left << std::setw(22) << predictor->getName()
+                          << std::setw(10) << hugePagesName(mode) << std::setw(10) << backing
+                          << std::right << std::setw(9) << hugeMB << std::fixed << std::setprecision(2)
+                          << std::setw(12) << batch << std::setw(9) << baseline / batch << "x";
+                if (misses != baselineMisses) {
+                    std::cout << "  MISMATCH (" << baselineMisses << " vs " << misses << ")";
+                    failures++;
+                }
+                std::cout << std::endl;
+
+                if (csv.is_open()) {
+                    csv << predictor->getName() << "," << (size_t(1) << log) << "," << hugePagesName(mode) << ","
+                        << backing << "," << hugeMB << "," << batch << "," << baseline / batch << "\n";
+                }
+            }
+        }
+    }
+    tableMemory.hugePages = selected;
+    return failures;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--branches") options.branches = std::stoull(value());
+            else if (arg == "--min-log") options.minLog = std::stoull(value());
+            else if (arg == "--max-log") options.maxLog = std::stoull(value());
+            else if (arg == "--repeats") options.repeats = std::stoull(value());
+            else if (arg == "--csv") options.csvFile = value();
+            else if (arg == "--huge-pages") tableMemory.hugePages = parseHugePages(value());
+            else if (arg == "--numa-local") tableMemory.numaLocal = true;
+            else if (arg == "--page-modes") options.pageModes = true;
+            else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+            else throw std::invalid_argument("Unknown option " + arg);
+        }
+        if (options.branches == 0 || options.repeats == 0 || options.maxLog > 30) {
+            throw std::invalid_argument("Invalid arguments");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    std::vector<Branch> branches = makeBranches(options.branches, 1);
+
+    std::ofstream csv;
+    if (!options.csvFile.empty()) {
+        csv.open(options.csvFile);
+        if (!csv.is_open()) {
+            std::cerr << "Error: Could not open CSV file " << options.csvFile << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<PredictorFactory> factories = {
+        [](size_t size) { return std::make_unique<TwoBitPredictor>(size); },
+        [](size_t size) { return std::make_unique<GSharePredictor>(size); },
+    };
+    if (options.pageModes) return benchPageModes(factories, branches, options, csv);
+
+    if (csv.is_open()) csv << "Predictor,TableSize,ScalarNsPerBranch,BatchNsPerBranch,Speedup\n";
+
+    std::cout << std::left << std::setw(22) << "Predictor"
+              << std::right << std::setw(12) << "scalar ns" << std::setw(12) << "batch ns"
+              << std::setw(10) << "speedup" << std::endl;
+
+    int failures = 0;
+    for (auto& factory : factories) {
+        for (size_t log = options.minLog; log <= options.maxLog; log += 2) {
+            auto predictor = factory(size_t(1) << log);
+            size_t scalarMisses = 0, batchMisses = 0;
+            double scalar = timeRun(*predictor, branches, false, options.repeats, scalarMisses);
+            double batch = timeRun(*predictor, branches, true, options.repeats, batchMisses);
+
+            std::cout << std::left << std::setw(22) << predictor->getName()
+                      << std::right << std::fixed << std::setprecision(2)
+                      << std::setw(12) << scalar << std::setw(12) << batch
+                      << std::setw(9) << scalar / batch << "x";
+            if (scalarMisses != batchMisses) {
+                std::cout << "  MISMATCH (" << scalarMisses << " vs " << batchMisses << ")";
+                failures++;
+            }
+            std::cout << std::endl;
+
+            if (csv.is_open()) {
+                csv << predictor->getName() << "," << (size_t(1) << log) << ","
+                    << scalar << "," << batch << "," << scalar / batch << "\n";
+            }
+        }
+    }
+    return failures;
+}
@@ -0,0 +1,104 @@
+#include "utils/config.hpp"
+#include "utils/dse.hpp"
+#include "utils/experiment.hpp"
+#include "utils/telemetry.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+void printUsage() {
+    std::cout << "Usage: predictor-dse [options] [trace_file...]\n"
+              << "  --space FILE     experiment file whose predictor lines span the search space\n"
+              << "                   (default config.DSE_PREDICTORS), and traces if none are given\n"
+              << "  --budget BITS    skip predictors needing more storage, K / M suffixes multiply\n"
+              << "                   by 1024 (default unlimited)\n"
+              << "  --threads T      design points evaluated in parallel (default: all cores)\n"
+              << "  --simpoints DIR  simpoints used as the pruning sample (default " << config.SIMPOINT_DIR << ")\n"
+              << "  --warmup N       branches simulated before each simpoint (default " << config.SIMPOINT_WARMUP << ")\n"
+              << "  --sample N       prefix sampled for traces without simpoints (default " << config.DSE_SAMPLE_BRANCHES << ")\n"
+              << "  --margin PCT     prune a point if a smaller one is estimated better by more than\n"
+              << "                   PCT percentage points (default " << config.DSE_PRUNE_MARGIN << ")\n"
+              << "  --no-prune       simulate every design point on the full trace\n"
+              << "  --no-cache       ignore the result cache in " << config.RESULT_CACHE_DIR << "\n"
+              << "  --out DIR        output directory (default results)\n"
+              << "  --huge-pages MODE  back large predictor tables and decoded traces with huge pages:\n"
+              << "                   none, thp (madvise) or hugetlb (reserved pool, falls back to thp)\n"
+              << "  --numa-local     place table pages on the NUMA node of the worker thread using them\n"
+              << "  --progress       print rate, % of trace and ETA of running jobs to stderr\n"
+              << "Without trace files, config.TRACES are explored.\n";
+}
+
+uint64_t parseBits(const std::string& text) {
+    size_t end = 0;
+    uint64_t bits = std::stoull(text, &end);
+    std::string suffix = text.substr(end);
+    if (suffix == "K" || suffix == "k") bits *= 1024;
+    else if (suffix == "M" || suffix == "m") bits *= 1024 * 1024;
+    else if (!suffix.empty()) throw std::invalid_argument("Invalid storage budget " + text);
+    return bits;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> traceFiles;
+    std::string spaceFile;
+    bool useCache = true;
+    bool progressTerminal = false;
+    DseOptions options;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--space") spaceFile = value();
+            else if (arg == "--budget") options.budget = parseBits(value());
+            else if (arg == "--threads") options.threads = std::stoull(value());
+            else if (arg == "--simpoints") options.simPointDir = value();
+            else if (arg == "--warmup") options.warmup = std::stoull(value());
+            else if (arg == "--sample") options.sampleBranches = std::stoull(value());
+            else if (arg == "--margin") options.margin = std::stod(value());
+            else if (arg == "--no-prune") options.prune = false;
+            else if (arg == "--no-cache") useCache = false;
+            else if (arg == "--out") options.outputDir = value();
+            else if (arg == "--progress") progressTerminal = true;
+            else if (arg == "--huge-pages") tableMemory.hugePages = parseHugePages(value());
+            else if (arg == "--numa-local") tableMemory.numaLocal = true;
+            else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+            else if (!arg.empty() && arg[0] == '-') throw std::invalid_argument("Unknown option " + arg);
+            else traceFiles.push_back(arg);
+        }
+
+        if (!spaceFile.empty()) {
+            Experiment experiment = loadExperiment(spaceFile);
+            options.space = experiment.predictors;
+            if (traceFiles.empty()) traceFiles = experiment.traces;
+        } else {
+            for (const std::string& line : config.DSE_PREDICTORS) {
+                for (const PredictorSpec& spec : expandPredictorSpecs(line)) options.space.push_back(spec);
+            }
+        }
+        if (options.space.empty()) throw std::invalid_argument("Empty search space");
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+    if (traceFiles.empty()) traceFiles = config.TRACES;
+    if (!useCache) options.cacheDir.clear();
+    config.EVALUATION_LOG = false;      // design points finish in any order
+
+    if (progressTerminal) telemetry().start(true, "", config.TELEMETRY_INTERVAL);
+    try {
+        runDesignSpaceExploration(traceFiles, options);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        telemetry().stop();
+        return 1;
+    }
+    telemetry().stop();
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "predictor/factory.hpp"
+#include "utils/validate.hpp"
+#include "utils/synthetic.hpp"
+#include "utils/config.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unistd.h>
+
+// Differential validation of the simulator's optimized paths against
+// reference implementations (utils/validate.hpp), on given or synthetic traces
+
+struct ValidateRunOptions {
+    size_t configs = 20;                // random configurations per trace
+    uint64_t seed = 1;
+    std::vector<std::string> specs;     // fixed configurations instead of random ones
+    uint64_t syntheticBranches = 1000000;
+    ValidationOptions validation;
+};
+
+void printUsage() {
+    std::cout << "Usage: predictor-validate [options] [trace_file...]\n"
+              << "  --configs N      random predictor configurations per trace (default 20)\n"
+              << "  --seed S         seed of the configurations and the synthetic traces (default 1)\n"
+              << "  --predictor SPEC validate SPEC, e.g. \"gshare size=4096\", instead of random\n"
+              << "                   configurations (repeatable)\n"
+              << "  --synthetic N    branches of the synthetic traces used without trace files\n"
+              << "                   (default 1000000)\n"
+              << "  --max-lines N    compare at most N branches per trace and pass\n"
+              << "  --context N      branches listed before a divergence (default 8)\n"
+              << "  --shm-cache      optimized engine reads through the shared-memory trace cache\n"
+              << "  --async-io       optimized engine reads through io_uring\n"
+              << "  --direct-io      --async-io with O_DIRECT\n"
+              << "  --huge-pages MODE  table memory of the optimized engine: none, thp or hugetlb\n"
+              << "Without trace files, a synthetic trace is generated in the text and the binary\n"
+              << "format. Stops at the first divergence with a state dump, exit status 1.\n";
+}
+
+int main(int argc, char* argv[]) {
+    ValidateRunOptions options;
+    std::vector<std::string> traceFiles;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--configs") options.configs = std::stoull(value());
+            else if (arg == "--seed") options.seed = std::stoull(value());
+            else if (arg == "--predictor") options.specs.push_back(value());
+            else if (arg == "--synthetic") options.syntheticBranches = std::stoull(value());
+            else if (arg == "--max-lines") options.validation.maxLines = std::stoull(value());
+            else if (arg == "--context") options.validation.context = std::stoull(value());
+            else if (arg == "--shm-cache") config.SHM_TRACE_CACHE = true;
+            else if (arg == "--async-io") config.ASYNC_TRACE_IO = true;
+            else if (arg == "--direct-io") config.ASYNC_TRACE_IO = config.ASYNC_DIRECT_IO = true;
+            else if (arg == "--huge-pages") tableMemory.hugePages = parseHugePages(value());
+            else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+            else if (!arg.empty() && arg[0] == '-') throw std::invalid_argument("Unknown option " + arg);
+            else traceFiles.push_back(arg);
+        }
+        if (options.syntheticBranches == 0) throw std::invalid_argument("--synthetic must be positive");
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    std::vector<std::string> syntheticFiles;
+    auto removeSynthetic = [&]() {
+        for (const auto& file : syntheticFiles) std::filesystem::remove(file);
+    };
+
+    try {
+        FastRng rng(options.seed);
+        std::vector<PredictorSpec> specs;
+        for (const auto& text : options.specs) specs.push_back(PredictorSpec::parse(text));
+
+        if (traceFiles.empty()) {
+            std::string base = (std::filesystem::temp_directory_path() /
+                                ("bp-validate-" + std::to_string(getpid()))).string();
+            SyntheticOptions synthetic;
+            synthetic.branches = options.syntheticBranches;
+            synthetic.seed = options.seed;
+            for (TraceFormat format : {TraceFormat::Text, TraceFormat::Binary}) {
+                synthetic.format = format;
+                std::string path = base + (format == TraceFormat::Binary ? ".bin" : ".out");
+                syntheticFiles.push_back(path);
+                TraceWriter writer(path, format);
+                SyntheticProgram(synthetic).writeTrace(writer);
+                writer.close();
+                traceFiles.push_back(path);
+            }
+        }
+
+        size_t validated = 0;
+        for (const auto& traceFile : traceFiles) {
+            std::vector<PredictorSpec> traceSpecs = specs;
+            if (traceSpecs.empty()) {
+                for (size_t c = 0; c < options.configs; c++) traceSpecs.push_back(randomPredictorSpec(rng));
+            }
+            std::cout << "Validating " << traceSpecs.size() << " configurations on " << traceFile << std::endl;
+            for (const PredictorSpec& spec : traceSpecs) {
+                ValidationResult result = validatePredictor(spec, traceFile, options.validation);
+                if (result.diverged) {
+                    printDivergence(std::cout, traceFile, spec, result);
+                    removeSynthetic();
+                    return 1;
+                }
+                std::cout << "  ok  " << spec.toString() << ": " << result.branches << " branches, "
+                          << result.mispredictions << " mispredictions" << std::endl;
+                validated++;
+            }
+        }
+        std::cout << "All " << validated << " runs match the reference implementations" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        removeSynthetic();
+        return 1;
+    }
+    removeSynthetic();
+    return 0;
+}
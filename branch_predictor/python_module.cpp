@@ -0,0 +1,656 @@
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include "predictor/branch.hpp"
+#include "predictor/predictor.hpp"
+#include "predictor/factory.hpp"
+#include "utils/trace_cache.hpp"
+#include "utils/analysis.hpp"
+#include "utils/config.hpp"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <functional>
+
+// ==== bpsim python module ====
+// Python bindings for the trace reader, the trace analyzer and every
+// predictor of the factory, built with `make python`:
+//
+//   import bpsim, numpy as np
+//   trace = bpsim.Trace("trace/gcc_cutted.out")
+//   pcs = np.asarray(trace.pc)                     # uint64 view of the decoded column
+//   result = bpsim.Predictor("gshare size=4096").simulate(trace, record=True)
+//   wrong = np.asarray(result.mispredicted)        # bool per branch
+//
+// Columns and per-branch results are read-only memoryviews over the C++
+// buffers (NumPy wraps them without copying) that keep their owner alive.
+// The flag columns are bit-packed like the decoded trace: 64 branches per
+// uint64 word, branch i in bit i % 64, e.g.
+// np.unpackbits(np.asarray(trace.taken).view(np.uint8), bitorder="little")[:len(trace)].
+// Decoding, simulation and analysis run with the GIL released, so threads
+// can drive sweeps in parallel; a Trace can be shared by any number of
+// simulations, a Predictor runs one simulation at a time.
+
+// Run work without the GIL, turning C++ exceptions into Python ones; returns false on error
+static bool runWithoutGil(const std::function<void()>& work) {
+    std::string error;
+    bool invalidArgument = false;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        work();
+    } catch (const std::invalid_argument& e) {
+        error = e.what();
+        invalidArgument = true;
+    } catch (const std::exception& e) {
+        error = e.what();
+        if (error.empty()) error = "Unknown error";
+    }
+    Py_END_ALLOW_THREADS
+    if (error.empty()) return true;
+    PyErr_SetString(invalidArgument ? PyExc_ValueError : PyExc_RuntimeError, error.c_str());
+    return false;
+}
+
+
+// ==== read-only buffer over a C++ array ====
+struct ColumnObject {
+    PyObject_HEAD
+    PyObject* owner;            // keeps the memory alive
+    const void* data;
+    Py_ssize_t length;
+    Py_ssize_t itemsize;
+    const char* format;
+};
+
+static void Column_dealloc(ColumnObject* self) {
+    Py_XDECREF(self->owner);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static int Column_getbuffer(ColumnObject* self, Py_buffer* view, int flags) {
+    if (flags & PyBUF_WRITABLE) {
+        PyErr_SetString(PyExc_BufferError, "bpsim columns are read-only");
+        view->obj = nullptr;
+        return -1;
+    }
+    static const uint64_t empty = 0;
+    view->buf = const_cast<void*>(self->data ? self->data : &empty);
+    view->obj = reinterpret_cast<PyObject*>(self);
+    Py_INCREF(self);
+    view->len = self->length * self->itemsize;
+    view->readonly = 1;
+    view->itemsize = self->itemsize;
+    view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(self->format) : nullptr;
+    view->ndim = 1;
+    view->shape = (flags & PyBUF_ND) ? &self->length : nullptr;
+    view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? &self->itemsize : nullptr;
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+
+static PyBufferProcs Column_buffer = {
+    reinterpret_cast<getbufferproc>(Column_getbuffer), nullptr,
+};
+
+static PyTypeObject ColumnPyType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+};
+
+// A memoryview of length items of format ("Q" uint64, "?" bool) at data, owned by owner
+static PyObject* columnView(PyObject* owner, const void* data, size_t length, size_t itemsize, const char* format) {
+    ColumnObject* column = PyObject_New(ColumnObject, &ColumnPyType);
+    if (!column) return nullptr;
+    Py_INCREF(owner);
+    column->owner = owner;
+    column->data = data;
+    column->length = static_cast<Py_ssize_t>(length);
+    column->itemsize = static_cast<Py_ssize_t>(itemsize);
+    column->format = format;
+    PyObject* view = PyMemoryView_FromObject(reinterpret_cast<PyObject*>(column));
+    Py_DECREF(column);
+    return view;
+}
+
+
+// ==== Trace ====
+struct TraceObject {
+    PyObject_HEAD
+    std::shared_ptr<const DecodedTrace>* trace;
+    PyObject* path;
+};
+
+static void Trace_dealloc(TraceObject* self) {
+    delete self->trace;
+    Py_XDECREF(self->path);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static int Trace_init(TraceObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"path", "shared", nullptr};
+    const char* path;
+    int shared = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|p", const_cast<char**>(keywords), &path, &shared)) return -1;
+    if (self->trace) {
+        // exported columns point into the decoded trace
+        PyErr_SetString(PyExc_RuntimeError, "Trace is already initialized");
+        return -1;
+    }
+
+    std::string traceFile = path;
+    std::shared_ptr<const DecodedTrace> decoded;
+    bool ok = runWithoutGil([&]() {
+        decoded = shared ? attachSharedTrace(traceFile) : DecodedTrace::decode(traceFile);
+    });
+    if (!ok) return -1;
+    self->trace = new std::shared_ptr<const DecodedTrace>(std::move(decoded));
+    Py_XSETREF(self->path, PyUnicode_FromString(path));
+    return 0;
+}
+
+static bool traceReady(TraceObject* self) {
+    if (self->trace) return true;
+    PyErr_SetString(PyExc_RuntimeError, "Trace is not initialized");
+    return false;
+}
+
+static Py_ssize_t Trace_len(TraceObject* self) {
+    return self->trace ? static_cast<Py_ssize_t>((*self->trace)->size()) : 0;
+}
+
+// Column getters, closure selects the column
+enum TraceColumn { COLUMN_PC, COLUMN_TARGET, COLUMN_KIND_LOW, COLUMN_KIND_HIGH, COLUMN_DIRECT, COLUMN_CONDITIONAL, COLUMN_TAKEN };
+
+static PyObject* Trace_column(TraceObject* self, void* closure) {
+    if (!traceReady(self)) return nullptr;
+    const BranchColumns& columns = (*self->trace)->columns();
+    size_t words = bitWords(columns.count);
+    PyObject* owner = reinterpret_cast<PyObject*>(self);
+    switch (static_cast<TraceColumn>(reinterpret_cast<intptr_t>(closure))) {
+        case COLUMN_PC:          return columnView(owner, columns.pc, columns.count, 8, "Q");
+        case COLUMN_TARGET:      return columnView(owner, columns.target, columns.count, 8, "Q");
+        case COLUMN_KIND_LOW:    return columnView(owner, columns.kindLow, words, 8, "Q");
+        case COLUMN_KIND_HIGH:   return columnView(owner, columns.kindHigh, words, 8, "Q");
+        case COLUMN_DIRECT:      return columnView(owner, columns.direct, words, 8, "Q");
+        case COLUMN_CONDITIONAL: return columnView(owner, columns.conditional, words, 8, "Q");
+        case COLUMN_TAKEN:       return columnView(owner, columns.taken, words, 8, "Q");
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* Trace_path(TraceObject* self, void*) {
+    if (!self->path) Py_RETURN_NONE;
+    Py_INCREF(self->path);
+    return self->path;
+}
+
+static PyObject* Trace_branch(TraceObject* self, PyObject* arg) {
+    if (!traceReady(self)) return nullptr;
+    Py_ssize_t i = PyLong_AsSsize_t(arg);
+    if (i == -1 && PyErr_Occurred()) return nullptr;
+    Py_ssize_t count = static_cast<Py_ssize_t>((*self->trace)->size());
+    if (i < 0) i += count;
+    if (i < 0 || i >= count) {
+        PyErr_SetString(PyExc_IndexError, "branch index out of range");
+        return nullptr;
+    }
+    Branch branch = (*self->trace)->branch(static_cast<size_t>(i));
+    return Py_BuildValue("{s:K,s:K,s:C,s:O,s:O,s:O}",
+                         "pc", static_cast<unsigned long long>(branch.pc),
+                         "target", static_cast<unsigned long long>(branch.target),
+                         "kind", branch.kind,
+                         "direct", branch.direct ? Py_True : Py_False,
+                         "conditional", branch.conditional ? Py_True : Py_False,
+                         "taken", branch.taken ? Py_True : Py_False);
+}
+
+#define TRACE_COLUMN(name, column, doc) \
+    {name, reinterpret_cast<getter>(Trace_column), nullptr, doc, reinterpret_cast<void*>(column)}
+
+static PyGetSetDef Trace_getset[] = {
+    {"path", reinterpret_cast<getter>(Trace_path), nullptr, "trace file", nullptr},
+    TRACE_COLUMN("pc", COLUMN_PC, "branch addresses, uint64 per branch"),
+    TRACE_COLUMN("target", COLUMN_TARGET, "target addresses, uint64 per branch"),
+    TRACE_COLUMN("kind_low", COLUMN_KIND_LOW, "bit 0 of the kind code (b=0, c=1, r=2, other=3), packed"),
+    TRACE_COLUMN("kind_high", COLUMN_KIND_HIGH, "bit 1 of the kind code, packed"),
+    TRACE_COLUMN("direct", COLUMN_DIRECT, "direct branch flags, packed"),
+    TRACE_COLUMN("conditional", COLUMN_CONDITIONAL, "conditional branch flags, packed"),
+    TRACE_COLUMN("taken", COLUMN_TAKEN, "outcomes, packed"),
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+static PyMethodDef Trace_methods[] = {
+    {"branch", reinterpret_cast<PyCFunction>(Trace_branch), METH_O, "branch(i) -> dict of branch i"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PySequenceMethods Trace_sequence = {
+    reinterpret_cast<lenfunc>(Trace_len),
+};
+
+static PyTypeObject TracePyType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+};
+
+
+// ==== Result ====
+struct ResultData {
+    std::string trace;
+    std::string predictor;
+    size_t totalBranches = 0;
+    size_t mispredictions = 0;
+    bool recorded = false;
+    std::vector<uint8_t> predictions;
+    std::vector<uint8_t> mispredicted;
+};
+
+struct ResultObject {
+    PyObject_HEAD
+    ResultData* data;
+};
+
+static void Result_dealloc(ResultObject* self) {
+    delete self->data;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static PyObject* Result_get(ResultObject* self, void* closure) {
+    const ResultData& data = *self->data;
+    PyObject* owner = reinterpret_cast<PyObject*>(self);
+    switch (reinterpret_cast<intptr_t>(closure)) {
+        case 0: return PyUnicode_FromString(data.trace.c_str());
+        case 1: return PyUnicode_FromString(data.predictor.c_str());
+        case 2: return PyLong_FromSize_t(data.totalBranches);
+        case 3: return PyLong_FromSize_t(data.mispredictions);
+        case 4: return PyFloat_FromDouble(data.totalBranches > 0 ?
+                    static_cast<double>(data.mispredictions) / data.totalBranches * 100.0 : 0.0);
+        case 5: if (!data.recorded) Py_RETURN_NONE;
+                return columnView(owner, data.predictions.data(), data.predictions.size(), 1, "?");
+        case 6: if (!data.recorded) Py_RETURN_NONE;
+                return columnView(owner, data.mispredicted.data(), data.mispredicted.size(), 1, "?");
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* Result_repr(ResultObject* self) {
+    const ResultData& data = *self->data;
+    return PyUnicode_FromFormat("<bpsim.Result %s on %s: %zu of %zu mispredicted>", data.predictor.c_str(),
+                                data.trace.c_str(), data.mispredictions, data.totalBranches);
+}
+
+#define RESULT_FIELD(name, index, doc) \
+    {name, reinterpret_cast<getter>(Result_get), nullptr, doc, reinterpret_cast<void*>(index)}
+
+static PyGetSetDef Result_getset[] = {
+    RESULT_FIELD("trace", 0, "trace name"),
+    RESULT_FIELD("predictor", 1, "predictor name"),
+    RESULT_FIELD("total_branches", 2, "simulated branches"),
+    RESULT_FIELD("mispredictions", 3, "mispredicted branches"),
+    RESULT_FIELD("misprediction_rate", 4, "mispredictions in percent"),
+    RESULT_FIELD("predictions", 5, "prediction per branch (bool), None unless recorded"),
+    RESULT_FIELD("mispredicted", 6, "misprediction per branch (bool), None unless recorded"),
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+static PyTypeObject ResultPyType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+};
+
+
+// ==== Predictor ====
+struct PredictorObject {
+    PyObject_HEAD
+    std::unique_ptr<BranchPredictor>* predictor;
+    std::string* spec;
+    bool busy;                  // only read and written with the GIL held
+};
+
+static void Predictor_dealloc(PredictorObject* self) {
+    delete self->predictor;
+    delete self->spec;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+static int Predictor_init(PredictorObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"spec", nullptr};
+    const char* text;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s", const_cast<char**>(keywords), &text)) return -1;
+    if (self->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "Predictor is running a simulation");
+        return -1;
+    }
+    try {
+        PredictorSpec spec = PredictorSpec::parse(text);
+        delete self->predictor;
+        self->predictor = new std::unique_ptr<BranchPredictor>(createPredictor(spec));
+        delete self->spec;
+        self->spec = new std::string(spec.toString());
+    } catch (const std::exception& e) {
+        PyErr_SetString(PyExc_ValueError, e.what());
+        return -1;
+    }
+    return 0;
+}
+
+static bool predictorReady(PredictorObject* self) {
+    if (!self->predictor) {
+        PyErr_SetString(PyExc_RuntimeError, "Predictor is not initialized");
+        return false;
+    }
+    if (self->busy) {
+        PyErr_SetString(PyExc_RuntimeError, "Predictor is running a simulation");
+        return false;
+    }
+    return true;
+}
+
+// Feed count branches from the start of the trace through processBatch, predictions to out (or scratch)
+static void simulateBatches(BranchPredictor& predictor, const std::shared_ptr<const DecodedTrace>& trace,
+                            size_t count, uint8_t* out, size_t* mispredictions) {
+    DecodedTraceReader reader(trace);
+    std::vector<Branch> batch(EVALUATION_BATCH_SIZE);
+    std::vector<uint8_t> scratch(out ? 0 : EVALUATION_BATCH_SIZE);
+    size_t done = 0;
+    while (done < count) {
+        size_t n = reader.nextDirectionBatch(batch.data(), std::min(EVALUATION_BATCH_SIZE, count - done));
+        if (n == 0) break;
+        uint8_t* predictions = out ? out + done : scratch.data();
+        predictor.processBatch(batch.data(), n, predictions);
+        if (mispredictions) {
+            for (size_t i = 0; i < n; i++) *mispredictions += predictions[i] != batch[i].taken;
+        }
+        done += n;
+    }
+}
+
+static PyObject* Predictor_simulate(PredictorObject* self, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"trace", "max_branches", "record", nullptr};
+    PyObject* traceArg;
+    unsigned long long maxBranches = 0;
+    int record = 0;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "O!|Kp", const_cast<char**>(keywords),
+                                     &TracePyType, &traceArg, &maxBranches, &record)) {
+        return nullptr;
+    }
+    TraceObject* traceObject = reinterpret_cast<TraceObject*>(traceArg);
+    if (!traceReady(traceObject) || !predictorReady(self)) return nullptr;
+
+    std::shared_ptr<const DecodedTrace> trace = *traceObject->trace;
+    BranchPredictor& predictor = **self->predictor;
+    auto data = std::make_unique<ResultData>();
+    data->trace = getTraceBaseName(PyUnicode_AsUTF8(traceObject->path));
+    data->predictor = predictor.getName();
+    data->recorded = record;
+    size_t count = maxBranches > 0 ? std::min<size_t>(maxBranches, trace->size()) : trace->size();
+
+    self->busy = true;
+    bool ok = runWithoutGil([&]() {
+        predictor.reset();
+        // profile-guided predictors see the same branches in a profiling pass first
+        auto* profiled = dynamic_cast<ProfiledPredictor*>(&predictor);
+        auto* profiled2Bit = dynamic_cast<Profiled2BitPredictor*>(&predictor);
+        if (profiled || profiled2Bit) {
+            simulateBatches(predictor, trace, count, nullptr, nullptr);
+            if (profiled) profiled->switchToPredict();
+            else profiled2Bit->switchToPredict();
+        }
+        if (data->recorded) data->predictions.resize(count);
+        simulateBatches(predictor, trace, count, data->recorded ? data->predictions.data() : nullptr,
+                        &data->mispredictions);
+        data->totalBranches = count;
+        if (data->recorded) {
+            data->mispredicted.resize(count);
+            const uint64_t* taken = trace->columns().taken;
+            for (size_t i = 0; i < count; i++) {
+                data->mispredicted[i] = data->predictions[i] != testBit(taken, i);
+            }
+        }
+    });
+    self->busy = false;
+    if (!ok) return nullptr;
+
+    ResultObject* result = PyObject_New(ResultObject, &ResultPyType);
+    if (!result) return nullptr;
+    result->data = data.release();
+    return reinterpret_cast<PyObject*>(result);
+}
+
+static PyObject* Predictor_reset(PredictorObject* self, PyObject*) {
+    if (!predictorReady(self)) return nullptr;
+    (*self->predictor)->reset();
+    Py_RETURN_NONE;
+}
+
+static PyObject* Predictor_get(PredictorObject* self, void* closure) {
+    if (!self->predictor) {
+        PyErr_SetString(PyExc_RuntimeError, "Predictor is not initialized");
+        return nullptr;
+    }
+    switch (reinterpret_cast<intptr_t>(closure)) {
+        case 0: return PyUnicode_FromString((*self->predictor)->getName().c_str());
+        case 1: return PyUnicode_FromString(self->spec->c_str());
+        case 2: return PyLong_FromUnsignedLongLong((*self->predictor)->storageBits());
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject* Predictor_repr(PredictorObject* self) {
+    if (!self->spec) return PyUnicode_FromString("<bpsim.Predictor>");
+    return PyUnicode_FromFormat("<bpsim.Predictor %s>", self->spec->c_str());
+}
+
+static PyMethodDef Predictor_methods[] = {
+    {"simulate", reinterpret_cast<PyCFunction>(Predictor_simulate), METH_VARARGS | METH_KEYWORDS,
+     "simulate(trace, max_branches=0, record=False) -> Result\n"
+     "Reset the predictor and run it over the trace (profiled predictors profile it first).\n"
+     "With record, the result holds per-branch predictions and mispredictions."},
+    {"reset", reinterpret_cast<PyCFunction>(Predictor_reset), METH_NOARGS, "reset the predictor state"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyGetSetDef Predictor_getset[] = {
+    {"name", reinterpret_cast<getter>(Predictor_get), nullptr, "predictor name", reinterpret_cast<void*>(0)},
+    {"spec", reinterpret_cast<getter>(Predictor_get), nullptr, "canonical spec", reinterpret_cast<void*>(1)},
+    {"storage_bits", reinterpret_cast<getter>(Predictor_get), nullptr, "modeled storage", reinterpret_cast<void*>(2)},
+    {nullptr, nullptr, nullptr, nullptr, nullptr},
+};
+
+static PyTypeObject PredictorPyType = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+};
+
+
+// ==== module functions ====
+// Dict built from (key, new reference) pairs, nullptr if any value failed
+static PyObject* buildDict(std::initializer_list<std::pair<const char*, PyObject*>> items) {
+    PyObject* dict = PyDict_New();
+    bool ok = dict != nullptr;
+    for (const auto& item : items) {
+        if (ok && item.second) ok = PyDict_SetItemString(dict, item.first, item.second) == 0;
+        else ok = false;
+        Py_XDECREF(item.second);
+    }
+    if (!ok) Py_XDECREF(dict);
+    return ok ? dict : nullptr;
+}
+
+static PyObject* boundsList(const std::vector<PredictabilityBound>& bounds) {
+    PyObject* list = PyList_New(0);
+    for (const PredictabilityBound& bound : bounds) {
+        PyObject* item = buildDict({
+            {"history", PyUnicode_FromString(historyKindName(bound.kind).c_str())},
+            {"bits", PyLong_FromSize_t(bound.bits)},
+            {"entropy", PyFloat_FromDouble(bound.entropy)},
+            {"misprediction_bound", PyFloat_FromDouble(bound.mispredictionBound)},
+        });
+        if (!item || PyList_Append(list, item) != 0) {
+            Py_XDECREF(item);
+            Py_DECREF(list);
+            return nullptr;
+        }
+        Py_DECREF(item);
+    }
+    return list;
+}
+
+static PyObject* patternList(const std::vector<PatternData>& patterns) {
+    PyObject* list = PyList_New(0);
+    for (const PatternData& pattern : patterns) {
+        PyObject* item = Py_BuildValue("(sd)", pattern.pattern.c_str(), pattern.percentage);
+        if (!item || PyList_Append(list, item) != 0) {
+            Py_XDECREF(item);
+            Py_DECREF(list);
+            return nullptr;
+        }
+        Py_DECREF(item);
+    }
+    return list;
+}
+
+static PyObject* module_analyze(PyObject*, PyObject* args, PyObject* kwargs) {
+    static const char* keywords[] = {"path", "max_lines", "history", nullptr};
+    const char* path;
+    unsigned long long maxLines = 0;
+    unsigned long long history = config.PATTERN_HISTORY_LENGTH;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "s|KK", const_cast<char**>(keywords), &path, &maxLines, &history)) {
+        return nullptr;
+    }
+    std::string traceFile = path;
+    BranchMetrics metrics;
+    bool ok = runWithoutGil([&]() {
+        if (!std::filesystem::exists(traceFile)) throw std::invalid_argument("No such trace: " + traceFile);
+        metrics = analyzeBranchTrace(traceFile, maxLines, history);
+    });
+    if (!ok) return nullptr;
+
+    PyObject* hotspots = PyList_New(0);
+    for (const BranchMetrics::Hotspot& hotspot : metrics.topHotspots) {
+        PyObject* item = buildDict({
+            {"pc", PyLong_FromUnsignedLongLong(hotspot.address)},
+            {"executions", PyLong_FromSize_t(hotspot.executions)},
+            {"execution_percent", PyFloat_FromDouble(hotspot.executionPercentage)},
+            {"taken_percent", PyFloat_FromDouble(hotspot.takenPercentage)},
+            {"conditional", PyBool_FromLong(hotspot.isConditional)},
+        });
+        if (!item || PyList_Append(hotspots, item) != 0) {
+            Py_XDECREF(item);
+            Py_DECREF(hotspots);
+            return nullptr;
+        }
+        Py_DECREF(item);
+    }
+
+    return buildDict({
+        {"trace", PyUnicode_FromString(metrics.traceName.c_str())},
+        {"total_branches", PyLong_FromSize_t(metrics.totalBranches)},
+        {"direct_branches", PyLong_FromSize_t(metrics.directBranches)},
+        {"indirect_branches", PyLong_FromSize_t(metrics.indirectBranches)},
+        {"conditional_branches", PyLong_FromSize_t(metrics.conditionalBranches)},
+        {"unconditional_branches", PyLong_FromSize_t(metrics.unconditionalBranches)},
+        {"regular_branches", PyLong_FromSize_t(metrics.regularBranches)},
+        {"call_instructions", PyLong_FromSize_t(metrics.callInstructions)},
+        {"return_instructions", PyLong_FromSize_t(metrics.returnInstructions)},
+        {"taken_branches", PyLong_FromSize_t(metrics.takenBranches)},
+        {"cond_taken_branches", PyLong_FromSize_t(metrics.condTakenBranches)},
+        {"unique_branch_locations", PyLong_FromSize_t(metrics.uniqueBranchLocations)},
+        {"unique_cond_branch_locations", PyLong_FromSize_t(metrics.uniqueCondBranchLocations)},
+        {"highly_predictable_all", PyLong_FromSize_t(metrics.highlyPredictableAll)},
+        {"highly_predictable_cond", PyLong_FromSize_t(metrics.highlyPredictableCond)},
+        {"hotspot_percent", PyFloat_FromDouble(metrics.hotspotPercentage)},
+        {"taken_percent", PyFloat_FromDouble(metrics.takenBranchesPercent)},
+        {"cond_taken_percent", PyFloat_FromDouble(metrics.condTakenBranchesPercent)},
+        {"pc_patterns", patternList(metrics.pcPatterns)},
+        {"taken_patterns", patternList(metrics.takenPatterns)},
+        {"hotspots", hotspots},
+        {"predictability", boundsList(metrics.predictability)},
+    });
+}
+
+static PyObject* module_predictor_types(PyObject*, PyObject*) {
+    PyObject* types = PyDict_New();
+    if (!types) return nullptr;
+    for (const PredictorType& type : predictorTypes()) {
+        PyObject* params = PyDict_New();
+        for (const auto& param : type.params) {
+            PyObject* value = PyLong_FromUnsignedLongLong(param.second);
+            PyDict_SetItemString(params, param.first.c_str(), value);
+            Py_XDECREF(value);
+        }
+        PyDict_SetItemString(types, type.name.c_str(), params);
+        Py_DECREF(params);
+    }
+    return types;
+}
+
+static PyMethodDef module_methods[] = {
+    {"analyze", reinterpret_cast<PyCFunction>(module_analyze), METH_VARARGS | METH_KEYWORDS,
+     "analyze(path, max_lines=0, history=config.PATTERN_HISTORY_LENGTH) -> dict of trace-analyzer metrics"},
+    {"predictor_types", module_predictor_types, METH_NOARGS,
+     "predictor_types() -> {type: {parameter: default}} of the predictor specs"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+static PyModuleDef bpsimModule = {
+    PyModuleDef_HEAD_INIT, "bpsim", "Branch predictor simulator bindings", -1, module_methods,
+};
+
+PyMODINIT_FUNC PyInit_bpsim() {
+    ColumnPyType.tp_name = "bpsim.Column";
+    ColumnPyType.tp_basicsize = sizeof(ColumnObject);
+    ColumnPyType.tp_dealloc = reinterpret_cast<destructor>(Column_dealloc);
+    ColumnPyType.tp_as_buffer = &Column_buffer;
+    ColumnPyType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ColumnPyType.tp_doc = "read-only buffer over a C++ array";
+
+    TracePyType.tp_name = "bpsim.Trace";
+    TracePyType.tp_basicsize = sizeof(TraceObject);
+    TracePyType.tp_dealloc = reinterpret_cast<destructor>(Trace_dealloc);
+    TracePyType.tp_as_sequence = &Trace_sequence;
+    TracePyType.tp_flags = Py_TPFLAGS_DEFAULT;
+    TracePyType.tp_doc = "Trace(path, shared=False): decoded trace columns; shared attaches the node-wide shm copy";
+    TracePyType.tp_methods = Trace_methods;
+    TracePyType.tp_getset = Trace_getset;
+    TracePyType.tp_init = reinterpret_cast<initproc>(Trace_init);
+    TracePyType.tp_new = PyType_GenericNew;
+
+    ResultPyType.tp_name = "bpsim.Result";
+    ResultPyType.tp_basicsize = sizeof(ResultObject);
+    ResultPyType.tp_dealloc = reinterpret_cast<destructor>(Result_dealloc);
+    ResultPyType.tp_repr = reinterpret_cast<reprfunc>(Result_repr);
+    ResultPyType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ResultPyType.tp_doc = "result of Predictor.simulate";
+    ResultPyType.tp_getset = Result_getset;
+
+    PredictorPyType.tp_name = "bpsim.Predictor";
+    PredictorPyType.tp_basicsize = sizeof(PredictorObject);
+    PredictorPyType.tp_dealloc = reinterpret_cast<destructor>(Predictor_dealloc);
+    PredictorPyType.tp_repr = reinterpret_cast<reprfunc>(Predictor_repr);
+    PredictorPyType.tp_flags = Py_TPFLAGS_DEFAULT;
+    PredictorPyType.tp_doc = "Predictor(spec): a predictor built from a spec such as \"gshare size=4096\"";
+    PredictorPyType.tp_methods = Predictor_methods;
+    PredictorPyType.tp_getset = Predictor_getset;
+    PredictorPyType.tp_init = reinterpret_cast<initproc>(Predictor_init);
+    PredictorPyType.tp_new = PyType_GenericNew;
+
+    PyTypeObject* types[] = {&ColumnPyType, &TracePyType, &ResultPyType, &PredictorPyType};
+    for (PyTypeObject* type : types) {
+        if (PyType_Ready(type) < 0) return nullptr;
+    }
+
+    config.EVALUATION_LOG = false;
+    PyObject* module = PyModule_Create(&bpsimModule);
+    if (!module) return nullptr;
+    const char* names[] = {"Trace", "Result", "Predictor"};
+    PyTypeObject* exported[] = {&TracePyType, &ResultPyType, &PredictorPyType};
+    for (size_t i = 0; i < 3; i++) {
+        Py_INCREF(exported[i]);
+        if (PyModule_AddObject(module, names[i], reinterpret_cast<PyObject*>(exported[i])) < 0) {
+            Py_DECREF(exported[i]);
+            Py_DECREF(module);
+            return nullptr;
+        }
+    }
+    return module;
+}
@@ -0,0 +1,240 @@
+#include "utils/config.hpp"
+#include "utils/utils.hpp"
+#include "utils/trace_io.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <filesystem>
+
+// How intervals of the input trace are selected
+enum class CutMode {
+    Segments,     // `count` evenly spaced segments, first at the beginning and last at the end
+    Systematic,   // every `period`-th interval, starting at interval `offset`
+    Random        // each interval independently with probability 1 / `period`
+};
+
+struct CutOptions {
+    CutMode mode = CutMode::Segments;
+    size_t segmentSize = 1000000;   // branches per segment / interval
+    size_t count = 3;               // number of segments (Segments mode)
+    size_t period = 10;             // sampling period (Systematic / Random mode)
+    size_t offset = 0;              // first kept interval (Systematic mode)
+    uint64_t seed = 1;              // PRNG seed (Random mode)
+    TraceFormat outputFormat = TraceFormat::Text;
+};
+
+void printUsage() {
+    std::cout << "Usage: trace-cut [options] [input_file [output_file]]\n"
+              << "  --mode segments|systematic|random  interval selection (default segments)\n"
+              << "  --segment N    branches per segment or interval (default 1000000)\n"
+              << "  --count K      number of evenly spaced segments (default 3: begin/middle/end)\n"
+              << "  --period P     keep one interval in P for systematic/random (default 10)\n"
+              << "  --offset O     first kept interval for systematic (default 0)\n"
+              << "  --seed S       random sampling seed (default 1)\n"
+              << "  --binary       write the binary trace format\n"
+              << "Without an input file, the traces in config.TRACES are cut from config.ORIGINAL_TRACES.\n";
+}
+
+// Copy up to n records, verbatim when the formats match, returns the number copied
+size_t copyRecords(TraceReader& reader, TraceWriter& writer, size_t n) {
+    if (reader.format() == writer.format()) {
+        const char* start = reader.position();
+        size_t copied = reader.skip(n);
+        writer.writeRaw(start, reader.position() - start, copied);
+        return copied;
+    }
+    Branch branch;
+    size_t copied = 0;
+    while (copied < n && reader.next(branch)) {
+        writer.write(branch);
+        copied++;
+    }
+    return copied;
+}
+
+// Average text line length over the first few thousand lines
+double estimateLineLength(const TraceReader& reader) {
+    const char* begin = reader.dataBegin();
+    const char* end = std::min(reader.dataEnd(), begin + (1 << 20));
+    size_t lines = 0;
+    for (const char* p = begin; p < end; ) {
+        const void* nl = std::memchr(p, '\n', end - p);
+        if (!nl) break;
+        p = static_cast<const char*>(nl) + 1;
+        lines++;
+    }
+    return lines > 0 ? static_cast<double>(end - begin) / lines : static_cast<double>(end - begin);
+}
+
+// Evenly spaced segments; text traces are positioned by byte offset aligned to line starts
+bool cutSegments(TraceReader& reader, TraceWriter& writer, const CutOptions& options) {
+    size_t segments = std::max<size_t>(options.count, 1);
+
+    if (reader.format() == TraceFormat::Binary) {
+        size_t total = reader.recordCount();
+        if (total < segments * options.segmentSize) {
+            std::cout << "File too small for segments of size " << options.segmentSize << "." << std::endl;
+            return false;
+        }
+        for (size_t i = 0; i < segments; i++) {
+            size_t start = (segments == 1) ? 0 : i * (total - options.segmentSize) / (segments - 1);
+            reader.seek(start * BINARY_RECORD_SIZE);
+            copyRecords(reader, writer, options.segmentSize);
+        }
+        return true;
+    }
+
+    // Middle segments are placed by a line length estimated from the start of
+    // the trace, keep the margin of the original script (4 segments of data)
+    // and check that no segment runs into the next one
+    double lineLength = estimateLineLength(reader);
+    size_t dataSize = reader.dataSize();
+    size_t segmentBytes = static_cast<size_t>(lineLength * options.segmentSize);
+    if (dataSize < std::max<size_t>(segments + 1, 4) * segmentBytes) {
+        std::cout << "File too small for segments of size " << options.segmentSize << "." << std::endl;
+        return false;
+    }
+    std::vector<size_t> starts(segments);
+    for (size_t i = 0; i < segments; i++) {
+        if (i == 0) {
+            reader.seek(0);
+        } else if (i == segments - 1) {
+            reader.seekTail(options.segmentSize);
+        } else {
+            reader.seek(i * (dataSize - segmentBytes) / (segments - 1));
+        }
+        starts[i] = reader.bytesConsumed();
+    }
+    for (size_t i = 0; i + 1 < segments; i++) {
+        reader.seek(starts[i]);
+        reader.skip(options.segmentSize);
+        if (reader.bytesConsumed() > starts[i + 1]) {
+            std::cout << "Segment " << i << " of size " << options.segmentSize
+                      << " overlaps the next one, lines are longer than estimated." << std::endl;
+            return false;
+        }
+    }
+    for (size_t i = 0; i < segments; i++) {
+        reader.seek(starts[i]);
+        copyRecords(reader, writer, options.segmentSize);
+    }
+    return true;
+}
+
+// Systematic or random sampling of fixed-size intervals in one streaming pass
+bool cutIntervals(TraceReader& reader, TraceWriter& writer, const CutOptions& options) {
+    std::mt19937_64 rng(options.seed);
+    std::bernoulli_distribution keepRandom(1.0 / std::max<size_t>(options.period, 1));
+    size_t period = std::max<size_t>(options.period, 1);
+
+    for (size_t interval = 0; ; interval++) {
+        bool keep;
+        if (options.mode == CutMode::Systematic) {
+            keep = interval >= options.offset && (interval - options.offset) % period == 0;
+        } else {
+            keep = keepRandom(rng);
+        }
+        size_t n = keep ? copyRecords(reader, writer, options.segmentSize)
+                        : reader.skip(options.segmentSize);
+        if (n < options.segmentSize) break;
+    }
+    return true;
+}
+
+bool cutTrace(const std::string& inputFile, const std::string& outputFile, const CutOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    TraceReader reader(inputFile);
+
+    std::filesystem::path outputDir = std::filesystem::path(outputFile).parent_path();
+    if (!outputDir.empty()) {
+        std::filesystem::create_directories(outputDir);
+    }
+    TraceWriter writer(outputFile, options.outputFormat);
+
+    std::cout << "Cutting " << inputFile << "..." << std::endl;
+    bool ok = (options.mode == CutMode::Segments) ? cutSegments(reader, writer, options)
+                                                  : cutIntervals(reader, writer, options);
+    writer.close();
+    if (!ok) {
+        std::filesystem::remove(outputFile);
+        return false;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Wrote " << writer.recordsWritten() << " branches to " << outputFile
+              << " in " << std::fixed << std::setprecision(2) << seconds << "s" << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    CutOptions options;
+    std::vector<std::string> positional;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--mode") {
+                std::string mode = value();
+                if (mode == "segments") options.mode = CutMode::Segments;
+                else if (mode == "systematic") options.mode = CutMode::Systematic;
+                else if (mode == "random") options.mode = CutMode::Random;
+                else throw std::invalid_argument("Unknown mode " + mode);
+            }
+            else if (arg == "--segment") options.segmentSize = std::stoull(value());
+            else if (arg == "--count") options.count = std::stoull(value());
+            else if (arg == "--period") options.period = std::stoull(value());
+            else if (arg == "--offset") options.offset = std::stoull(value());
+            else if (arg == "--seed") options.seed = std::stoull(value());
+            else if (arg == "--binary") options.outputFormat = TraceFormat::Binary;
+            else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+            else if (!arg.empty() && arg[0] == '-') throw std::invalid_argument("Unknown option " + arg);
+            else positional.push_back(arg);
+        }
+        if (positional.size() > 2 || options.segmentSize == 0) {
+            throw std::invalid_argument("Invalid arguments");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    std::string extension = (options.outputFormat == TraceFormat::Binary) ? ".bin" : ".out";
+    int failures = 0;
+
+    if (!positional.empty()) {
+        std::string output = positional.size() == 2
+            ? positional[1]
+            : "trace/" + getTraceBaseName(positional[0]) + "_cutted" + extension;
+        try {
+            if (!cutTrace(positional[0], output, options)) failures++;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            failures++;
+        }
+        return failures;
+    }
+
+    // default: regenerate the cutted traces used for predictor evaluation
+    for (const auto& original : config.ORIGINAL_TRACES) {
+        std::string cutted = "trace/" + getTraceBaseName(original) + "_cutted.out";
+        if (std::find(config.TRACES.begin(), config.TRACES.end(), cutted) == config.TRACES.end()) continue;
+        if (options.outputFormat == TraceFormat::Binary) {
+            cutted = cutted.substr(0, cutted.size() - 4) + extension;
+        }
+        try {
+            if (!cutTrace(original, cutted, options)) failures++;
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            failures++;
+        }
+    }
+    return failures;
+}
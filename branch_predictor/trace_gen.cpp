@@ -0,0 +1,192 @@
+#include "utils/trace_io.hpp"
+#include "utils/synthetic.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <iomanip>
+#include <filesystem>
+
+// Synthetic trace generator: worker threads generate fixed-size chunks into
+// their own buffers, the main thread writes the chunks in order
+
+struct GenOptions {
+    SyntheticOptions synthetic;
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string outputFile;
+};
+
+void printUsage() {
+    std::cout << "Usage: trace-gen [options] output_file\n"
+              << "  --branches N   branches to generate, K / M / G suffixes multiply by 1000\n"
+              << "                 (default 10M)\n"
+              << "  --seed S       program and outcome seed (default 1)\n"
+              << "  --mix SPEC     weights of conditional branch classes\n"
+              << "                 (default loop=20,biased=50,correlated=20,random=10)\n"
+              << "  --calls P      share of call sites, each returning (default 0.1)\n"
+              << "  --indirect P   share of indirect jump sites (default 0.02)\n"
+              << "  --noise P      flip probability of correlated branches (default 0.02)\n"
+              << "  --functions N  functions in the program (default 256)\n"
+              << "  --body N       branch sites per function (default 16)\n"
+              << "  --max-depth N  call nesting limit (default 16)\n"
+              << "  --max-trip N   largest loop trip count (default 32)\n"
+              << "  --chunk N      branches per independently seeded chunk (default 262144),\n"
+              << "                 the output depends on it but not on --threads\n"
+              << "  --threads T    generator threads (default: all cores)\n"
+              << "  --binary       write the binary trace format\n";
+}
+
+uint64_t parseCount(const std::string& text) {
+    size_t end = 0;
+    uint64_t count = std::stoull(text, &end);
+    std::string suffix = text.substr(end);
+    if (suffix == "K" || suffix == "k") count *= 1000;
+    else if (suffix == "M" || suffix == "m") count *= 1000000;
+    else if (suffix == "G" || suffix == "g") count *= 1000000000;
+    else if (!suffix.empty()) throw std::invalid_argument("Invalid count " + text);
+    return count;
+}
+
+// Generate all chunks on options.threads workers, writing them in order
+void generateTrace(const SyntheticProgram& program, const GenOptions& options, TraceWriter& writer) {
+    const SyntheticOptions& synthetic = options.synthetic;
+    uint64_t chunks = (synthetic.branches + synthetic.chunkBranches - 1) / synthetic.chunkBranches;
+    size_t threads = static_cast<size_t>(std::max<uint64_t>(1, std::min<uint64_t>(options.threads, chunks)));
+    size_t window = 2 * threads;        // finished chunks waiting to be written
+
+    struct Slot {
+        std::vector<char> data;         // keeps its size, only `bytes` are valid
+        size_t bytes = 0;
+        uint64_t chunk = 0;
+        bool ready = false;
+    };
+    std::vector<Slot> slots(window);
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint64_t written = 0;
+    std::atomic<uint64_t> nextChunk(0);
+    std::exception_ptr failure;
+
+    auto branchesOf = [&](uint64_t chunk) {
+        return static_cast<size_t>(std::min<uint64_t>(synthetic.chunkBranches,
+                                                      synthetic.branches - chunk * synthetic.chunkBranches));
+    };
+
+    auto worker = [&]() {
+        std::vector<char> buffer;
+        try {
+            for (uint64_t chunk = nextChunk++; chunk < chunks; chunk = nextChunk++) {
+                size_t capacity = program.chunkCapacity(branchesOf(chunk));
+                if (buffer.size() < capacity) buffer.resize(capacity);
+                size_t bytes = program.generateChunk(chunk, branchesOf(chunk), buffer.data());
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return chunk < written + window || failure; });
+                if (failure) return;
+                Slot& slot = slots[chunk % window];
+                slot.data.swap(buffer);
+                slot.bytes = bytes;
+                slot.chunk = chunk;
+                slot.ready = true;
+                changed.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            failure = std::current_exception();
+            changed.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) workers.emplace_back(worker);
+
+    try {
+        for (uint64_t chunk = 0; chunk < chunks; chunk++) {
+            Slot& slot = slots[chunk % window];
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return (slot.ready && slot.chunk == chunk) || failure; });
+                if (failure) break;
+            }
+            // the slot is not reused before `written` advances
+            writer.writeRaw(slot.data.data(), slot.bytes, branchesOf(chunk));
+            std::lock_guard<std::mutex> lock(mutex);
+            slot.ready = false;
+            written = chunk + 1;
+            changed.notify_all();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        failure = std::current_exception();
+        changed.notify_all();
+    }
+    for (auto& thread : workers) thread.join();
+    if (failure) std::rethrow_exception(failure);
+}
+
+int main(int argc, char* argv[]) {
+    GenOptions options;
+    SyntheticOptions& synthetic = options.synthetic;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--branches") synthetic.branches = parseCount(value());
+            else if (arg == "--seed") synthetic.seed = std::stoull(value());
+            else if (arg == "--mix") parseSyntheticMix(value(), synthetic);
+            else if (arg == "--calls") synthetic.callFraction = std::stod(value());
+            else if (arg == "--indirect") synthetic.indirectFraction = std::stod(value());
+            else if (arg == "--noise") synthetic.noise = std::stod(value());
+            else if (arg == "--functions") synthetic.functions = std::stoull(value());
+            else if (arg == "--body") synthetic.bodySites = std::stoull(value());
+            else if (arg == "--max-depth") synthetic.maxDepth = std::stoull(value());
+            else if (arg == "--max-trip") synthetic.maxTrip = std::stoull(value());
+            else if (arg == "--chunk") synthetic.chunkBranches = parseCount(value());
+            else if (arg == "--threads") options.threads = std::stoull(value());
+            else if (arg == "--binary") synthetic.format = TraceFormat::Binary;
+            else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+            else if (!arg.empty() && arg[0] == '-') throw std::invalid_argument("Unknown option " + arg);
+            else if (options.outputFile.empty()) options.outputFile = arg;
+            else throw std::invalid_argument("More than one output file");
+        }
+        if (options.outputFile.empty()) throw std::invalid_argument("Missing output file");
+        if (synthetic.chunkBranches == 0 || options.threads == 0 || synthetic.maxDepth == 0) {
+            throw std::invalid_argument("Sizes must be positive");
+        }
+        if (synthetic.callFraction < 0 || synthetic.indirectFraction < 0 ||
+            synthetic.callFraction + synthetic.indirectFraction > 1) {
+            throw std::invalid_argument("Call and indirect shares must be non-negative and sum to at most 1");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        SyntheticProgram program(synthetic);
+        TraceWriter writer(options.outputFile, synthetic.format);
+        generateTrace(program, options, writer);
+        writer.close();
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double bytes = static_cast<double>(std::filesystem::file_size(options.outputFile));
+        std::cout << "Generated " << synthetic.branches << " branches (" << std::fixed << std::setprecision(2)
+                  << bytes / 1e9 << " GB) to " << options.outputFile << " in " << seconds << "s, "
+                  << bytes / 1e9 / seconds << " GB/s, " << synthetic.branches / seconds / 1e6 << "M branches/s"
+                  << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "utils/config.hpp"
+#include "utils/utils.hpp"
+#include "utils/simpoint.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+struct SimPointOptions {
+    size_t intervalSize = 100000;   // branches per interval
+    size_t clusters = 10;           // k-means k (upper bound on simpoints per trace)
+    size_t dims = 15;               // random projection dimensions
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = 1;
+    std::string outputDir = config.SIMPOINT_DIR;
+};
+
+void printUsage() {
+    std::cout << "Usage: trace-simpoint [options] [trace_file...]\n"
+              << "  --interval N   branches per interval (default 100000)\n"
+              << "  --k K          number of clusters / simpoints (default 10)\n"
+              << "  --dims D       random projection dimensions (default 15)\n"
+              << "  --threads T    k-means threads (default: all cores)\n"
+              << "  --seed S       projection and k-means seed (default 1)\n"
+              << "  --out DIR      output directory (default " << config.SIMPOINT_DIR << ")\n"
+              << "Without trace files, config.ORIGINAL_TRACES are processed.\n";
+}
+
+void findSimPoints(const std::string& traceFile, const SimPointOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    std::cout << "Profiling intervals of " << traceFile << "..." << std::endl;
+
+    std::vector<float> vectors;
+    std::vector<size_t> lengths;
+    buildIntervalVectors(traceFile, options.intervalSize, options.dims, options.seed, vectors, lengths);
+
+    std::vector<SimPoint> points = selectSimPoints(vectors, lengths, options.dims, options.intervalSize,
+                                                   options.clusters, options.threads, options.seed);
+
+    std::string csvFile = simPointFile(options.outputDir, getTraceBaseName(traceFile));
+    saveSimPoints(points, csvFile);
+
+    size_t simulated = 0;
+    for (const auto& point : points) simulated += point.length;
+    size_t total = 0;
+    for (size_t length : lengths) total += length;
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Selected " << points.size() << " of " << lengths.size() << " intervals ("
+              << simulated << " of " << total << " branches) in "
+              << std::fixed << std::setprecision(2) << seconds << "s" << std::endl;
+    std::cout << "Simpoints written to " << csvFile << std::endl << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    SimPointOptions options;
+    std::vector<std::string> traceFiles;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) throw std::invalid_argument("Missing value for " + arg);
+                return argv[++i];
+            };
+            if (arg == "--interval") options.intervalSize = std::stoull(value());
+            else if (arg == "--k") options.clusters = std::stoull(value());
+            else if (arg == "--dims") options.dims = std::stoull(value());
+            else if (arg == "--threads") options.threads = std::stoull(value());
+            else if (arg == "--seed") options.seed = std::stoull(value());
+            else if (arg == "--out") options.outputDir = value();
+            else if (arg == "-h" || arg == "--help") { printUsage(); return 0; }
+            else if (!arg.empty() && arg[0] == '-') throw std::invalid_argument("Unknown option " + arg);
+            else traceFiles.push_back(arg);
+        }
+        if (options.intervalSize == 0 || options.clusters == 0 || options.dims == 0 || options.threads == 0) {
+            throw std::invalid_argument("Sizes must be positive");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    if (traceFiles.empty()) traceFiles = config.ORIGINAL_TRACES;
+    std::filesystem::create_directories(options.outputDir);
+
+    int failures = 0;
+    for (const auto& traceFile : traceFiles) {
+        try {
+            findSimPoints(traceFile, options);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            failures++;
+        }
+    }
+    return failures;
+}
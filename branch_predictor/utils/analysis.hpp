@@ -2,6 +2,14 @@
 
 #include "predictor/branch.hpp"
 #include "utils/utils.hpp"
+#include "utils/trace_cache.hpp"
+#include "utils/trace_columns.hpp"
+#include "utils/hash.hpp"
+#include "utils/columnar.hpp"
+#include "utils/patterns.hpp"
+#include "utils/predictability.hpp"
+#include "utils/reuse_distance.hpp"
+#include "utils/config.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -18,7 +26,11 @@
 #include <set>
 #include <map>
 
+// Branches decoded into columns at a time by the analyzer
+const size_t ANALYSIS_CHUNK_SIZE = 1 << 20;
 
+// Largest table index width of the reuse-distance analysis (dense 2^bits key space)
+const size_t MAX_REUSE_INDEX_BITS = 24;
 
 // PattenData structure to hold pattern name and percentage
 struct PatternData {
@@ -37,6 +49,7 @@ struct PatternData {
 struct BranchMetrics {
     std::string traceName;
     size_t totalBranches = 0;
+    size_t skippedLines = 0;     // malformed text lines, not counted as branches
     size_t directBranches = 0;
     size_t indirectBranches = 0;
     size_t conditionalBranches = 0;
@@ -71,6 +84,24 @@ struct BranchMetrics {
         bool isConditional;  // Whether this is a conditional branch
     };
     std::vector<Hotspot> topHotspots;
+
+    // Predictability bounds for each configured history, see utils/predictability.hpp
+    std::vector<PredictabilityBound> predictability;
+    std::vector<BranchPredictability> branchPredictability;   // per conditional PC, most executed first
+
+    // Reuse distances of PCs and of table indices (pc & (2^reuseIndexBits - 1)), see utils/reuse_distance.hpp
+    size_t reuseIndexBits = 0;
+    ReuseHistogram pcReuse;
+    ReuseHistogram indexReuse;
+
+    // Distinct PCs / table indices per interval of config.WORKING_SET_INTERVAL branches
+    struct WorkingSetInterval {
+        size_t start;
+        size_t branches;
+        size_t uniquePCs;
+        size_t uniqueIndices;
+    };
+    std::vector<WorkingSetInterval> workingSet;
     
     // Calculate percentages
     void calculatePercentages() {
@@ -140,13 +171,22 @@ struct BranchMetrics {
 
 
 // Analyze a single trace file and return metrics
-BranchMetrics analyzeBranchTrace(const std::string& filename, size_t maxLines = 0) {
+// patterns look back historyLength (1-32) branches, predictability bounds use
+// each of predictabilityHistories bits of global and local history
+BranchMetrics analyzeBranchTrace(const std::string& filename, size_t maxLines = 0,
+                                 size_t historyLength = config.PATTERN_HISTORY_LENGTH,
+                                 const std::vector<size_t>& predictabilityHistories = config.PREDICTABILITY_HISTORIES) {
     BranchMetrics metrics;
     metrics.traceName = getTraceBaseName(filename);
-    
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << std::endl;
+    perfProfiler().beginJob(metrics.traceName, "analysis");
+    TelemetryJob progress(metrics.traceName, "analysis");
+    perfProfiler().enter(PerfPhase::Parse);
+    
+    std::unique_ptr<BranchSource> reader;
+    try {
+        reader = openTrace(filename, true);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << filename << ": " << e.what() << std::endl;
         return metrics;
     }
     
@@ -159,92 +199,122 @@ BranchMetrics analyzeBranchTrace(const std::string& filename, size_t maxLines =
     std::unordered_map<uint64_t, bool> isConditional;  // PC -> isConditional flag
     
     // ==== locality analysis ====
-    const size_t HISTORY_LENGTH = 4;
-    std::deque<uint64_t> recentPCs;  // recent PCs for locality analysis
-    
-    // record patterns
-    std::unordered_map<std::string, size_t> pcPatternCounts;
-    std::unordered_map<std::string, size_t> takenPatternCounts;
-    
-    // process the trace file line by line
-    std::string line;
-    while (std::getline(file, line) && (maxLines == 0 || metrics.totalBranches < maxLines)) {
-        Branch branch;
-        std::istringstream iss(line);
-        std::string pc, target, kind, direct, conditional, taken;
-        
-        if (!(iss >> std::hex >> branch.pc
-                  >> std::hex >> branch.target
-                  >> branch.kind
-                  >> branch.direct
-                  >> branch.conditional
-                  >> branch.taken)) continue;
-        
-        metrics.totalBranches++;
-        
-        // ==== basic counters ====
-        if (branch.direct) metrics.directBranches++;
-        if (branch.conditional) metrics.conditionalBranches++;
-        if (branch.taken) metrics.takenBranches++;
-        
+    historyLength = std::clamp<size_t>(historyLength, 1, MAX_PATTERN_LENGTH);
+    std::vector<uint64_t> recentPCs(historyLength);  // ring buffer of recent PCs for locality analysis
+    size_t recentHead = 0;                           // slot of the next PC
+    size_t recentCount = 0;
+    
+    // record packed patterns, see utils/patterns.hpp
+    PatternCounter pcPatternCounts(historyLength);
+    PatternCounter takenPatternCounts(historyLength);
+
+    // ==== predictability bounds ====
+    PredictabilityAnalyzer predictability(predictabilityHistories);
+
+    // ==== reuse distance and working set ====
+    metrics.reuseIndexBits = std::min(config.REUSE_INDEX_BITS, MAX_REUSE_INDEX_BITS);
+    uint64_t indexMask = (uint64_t(1) << metrics.reuseIndexBits) - 1;
+    ReuseDistanceAnalyzer pcReuse;
+    ReuseDistanceAnalyzer indexReuse(size_t(1) << metrics.reuseIndexBits);
+    size_t interval = config.WORKING_SET_INTERVAL;
+    size_t intervalStart = 0;
+    auto closeInterval = [&](size_t end) {
+        metrics.workingSet.push_back({intervalStart, end - intervalStart, pcReuse.intervalSize(), indexReuse.intervalSize()});
+        pcReuse.startInterval();
+        indexReuse.startInterval();
+        intervalStart = end;
+    };
+    
+    // process the trace in chunks of columns
+    TraceColumns chunk;
+    while (maxLines == 0 || metrics.totalBranches < maxLines) {
+        size_t limit = (maxLines == 0) ? ANALYSIS_CHUNK_SIZE
+                                       : std::min(ANALYSIS_CHUNK_SIZE, maxLines - metrics.totalBranches);
+        perfProfiler().enter(PerfPhase::Parse);
+        if (readColumns(*reader, chunk, limit) == 0) break;
+        perfProfiler().enter(PerfPhase::Analyze);
+        BranchColumns columns = chunk.view();
+        progress.update(metrics.totalBranches + columns.size(), reader->progress());
+
+        // ==== basic counters, popcounts over the packed flag bits ====
+        metrics.totalBranches += columns.size();
+        metrics.directBranches += columns.countDirect();
+        metrics.conditionalBranches += columns.countConditional();
+        metrics.takenBranches += columns.countTaken();
+        metrics.condTakenBranches += columns.countConditionalTaken();
+
         // ==== branch kind ====
-        if (branch.kind == 'b') metrics.regularBranches++;
-        else if (branch.kind == 'c') metrics.callInstructions++;
-        else if (branch.kind == 'r') metrics.returnInstructions++;
-        
-        // ==== branch execution count ====
-        branchExecutions[branch.pc]++;
+        metrics.regularBranches += columns.countKind(encodeBranchKind('b'));
+        metrics.callInstructions += columns.countKind(encodeBranchKind('c'));
+        metrics.returnInstructions += columns.countKind(encodeBranchKind('r'));
+
+        size_t position = metrics.totalBranches - columns.size();
+        for (const Branch branch : columns) {
+            // ==== reuse distance and working set ====
+            if (interval > 0 && position - intervalStart == interval) closeInterval(position);
+            pcReuse.access(branch.pc);
+            indexReuse.access(branch.pc & indexMask);
+            position++;
+
+            // ==== branch execution count ====
+            branchExecutions[branch.pc]++;
         
-        // update all branches statistics, PC -> (taken, total)
-        allBranchStats[branch.pc].second++;  // total execution count
-        if (branch.taken) allBranchStats[branch.pc].first++;  // taken count
+            // update all branches statistics, PC -> (taken, total)
+            allBranchStats[branch.pc].second++;  // total execution count
+            if (branch.taken) allBranchStats[branch.pc].first++;  // taken count
         
-        // Track whether this branch is conditional
-        isConditional[branch.pc] = branch.conditional;
+            // Track whether this branch is conditional
+            isConditional[branch.pc] = branch.conditional;
         
-        // update conditional branches statistics, PC -> (taken, total)
-        if (branch.conditional) {
-            conditionalStats[branch.pc].second++;  // total execution count
-            if (branch.taken) {
-                conditionalStats[branch.pc].first++;  // taken count
-                metrics.condTakenBranches++;
+            // update conditional branches statistics, PC -> (taken, total)
+            if (branch.conditional) {
+                conditionalStats[branch.pc].second++;  // total execution count
+                if (branch.taken) conditionalStats[branch.pc].first++;  // taken count
+                predictability.observe(branch.pc, branch.taken);
             }
-        }
         
-        // ==== locality analysis ====
-        if (!recentPCs.empty()) {
-            // record the pattern of recent PCs
-            std::string pcPattern = "";
-            for (size_t i = 0; i < std::min(recentPCs.size(), HISTORY_LENGTH); i++) {
-                pcPattern += (recentPCs[i] == branch.pc) ? "S" : "D";  // Same/Different PC
-            }
-            pcPatternCounts[pcPattern]++;
+            // ==== locality analysis ====
+            if (recentCount > 0) {
+                // record the pattern of recent PCs, most recent first
+                uint64_t pcPattern = 0;
+                uint64_t sameMask = 0;
+                for (size_t i = 0; i < recentCount; i++) {
+                    size_t slot = (recentHead + historyLength - 1 - i) % historyLength;
+                    bool same = (recentPCs[slot] == branch.pc);  // Same/Different PC
+                    sameMask |= uint64_t(same) << i;
+                    pcPattern |= (same ? PATTERN_SAME : PATTERN_DIFFERENT) << (2 * i);
+                }
+                pcPatternCounts.add(pcPattern);
             
-            // record the pattern of taken/not-taken, only for conditional branches
-            if (branch.conditional && conditionalStats[branch.pc].second >= 2) {
-                std::string takenPattern = "";
-                for (size_t i = 0; i < std::min(recentPCs.size(), HISTORY_LENGTH); i++) {
-                    if (recentPCs[i] == branch.pc) {
-                        // retrieve the direction of the previous branch
-                        double takenRatio = (double)conditionalStats[branch.pc].first / 
-                                           conditionalStats[branch.pc].second;
-                        takenPattern += (takenRatio > 0.5) ? "T" : "N";  // nominally taken/not-taken
-                    } else {
-                        takenPattern += "X";  // if not the same PC, use 'X'
+                // record the pattern of taken/not-taken, only for conditional branches
+                if (branch.conditional && conditionalStats[branch.pc].second >= 2) {
+                    // retrieve the nominal direction of this branch
+                    double takenRatio = (double)conditionalStats[branch.pc].first / 
+                                       conditionalStats[branch.pc].second;
+                    uint64_t direction = (takenRatio > 0.5) ? PATTERN_TAKEN : PATTERN_NOT_TAKEN;
+                    uint64_t takenPattern = 0;
+                    for (size_t i = 0; i < recentCount; i++) {
+                        // if not the same PC, use 'X'
+                        takenPattern |= (((sameMask >> i) & 1) ? direction : PATTERN_OTHER) << (2 * i);
                     }
+                    takenPatternCounts.add(takenPattern);
                 }
-                takenPatternCounts[takenPattern]++;
             }
-        }
         
-        // update recent PCs
-        recentPCs.push_front(branch.pc);
-        if (recentPCs.size() > HISTORY_LENGTH) {
-            recentPCs.pop_back();
+            // update recent PCs
+            recentPCs[recentHead] = branch.pc;
+            recentHead = (recentHead + 1) % historyLength;
+            recentCount = std::min(recentCount + 1, historyLength);
         }
     }
     
+    metrics.skippedLines = reader->skippedLines();
+    if (metrics.skippedLines > 0) {
+        std::cerr << "Warning: skipped " << metrics.skippedLines << " malformed lines in " << filename << std::endl;
+    }
+
     // Calculate derived metrics
+    perfProfiler().enter(PerfPhase::Analyze);
     metrics.indirectBranches = metrics.totalBranches - metrics.directBranches;
     metrics.unconditionalBranches = metrics.totalBranches - metrics.conditionalBranches;
     metrics.uniqueBranchLocations = allBranchStats.size();
@@ -299,12 +369,21 @@ BranchMetrics analyzeBranchTrace(const std::string& filename, size_t maxLines =
     
     metrics.hotspotPercentage = 100.0 * hotspotTotal / metrics.totalBranches;
     
-    // Store raw PC pattern counts
-    metrics.rawPCPatternCounts = std::map<std::string, size_t>(pcPatternCounts.begin(), pcPatternCounts.end());
-    
-    // Store raw taken pattern counts
-    metrics.rawTakenPatternCounts = std::map<std::string, size_t>(takenPatternCounts.begin(), pcPatternCounts.end());
+    // Store raw pattern counts, patterns are only turned into strings here
+    pcPatternCounts.forEach([&](uint64_t code, size_t count) {
+        metrics.rawPCPatternCounts[decodePattern(code, PC_PATTERN_SYMBOLS)] = count;
+    });
+    takenPatternCounts.forEach([&](uint64_t code, size_t count) {
+        metrics.rawTakenPatternCounts[decodePattern(code, TAKEN_PATTERN_SYMBOLS)] = count;
+    });
     
+    metrics.predictability = predictability.aggregate();
+    metrics.branchPredictability = predictability.perBranch();
+
+    if (interval > 0 && metrics.totalBranches > intervalStart) closeInterval(metrics.totalBranches);
+    metrics.pcReuse = pcReuse.result();
+    metrics.indexReuse = indexReuse.result();
+
     // Calculate percentages
     metrics.calculatePercentages();
     metrics.calculatePatternStats();
@@ -315,7 +394,9 @@ BranchMetrics analyzeBranchTrace(const std::string& filename, size_t maxLines =
 // Function to analyze multiple trace files and create pandas-friendly CSV files
 void createPandasFriendlyCSV(const std::vector<std::string>& traceFiles, 
                              const std::string& outputDir = "results",
-                             size_t maxLines = 0) {
+                             size_t maxLines = 0,
+                             size_t historyLength = config.PATTERN_HISTORY_LENGTH,
+                             const std::vector<size_t>& predictabilityHistories = config.PREDICTABILITY_HISTORIES) {
     
     // Create directory for analysis if it doesn't exist
     if (!std::filesystem::exists(outputDir)) {
@@ -327,16 +408,36 @@ void createPandasFriendlyCSV(const std::vector<std::string>& traceFiles,
     std::string pcPatternsCSV = outputDir + "/pc_patterns_by_rank.csv";
     std::string takenPatternsCSV = outputDir + "/taken_patterns_by_rank.csv";
     std::string hotspotsCSV = outputDir + "/trace_hotspots.csv";
+    std::string predictabilityCSV = outputDir + "/predictability.csv";
+    std::string branchPredictabilityCSV = outputDir + "/predictability_by_pc.csv";
+    std::string reuseCSV = outputDir + "/reuse_distance.csv";
+    std::string workingSetCSV = outputDir + "/working_set.csv";
     
     // Analyze each trace file
     std::vector<BranchMetrics> allMetrics;
     for (const auto& traceFile : traceFiles) {
         std::cout << "Analyzing " << traceFile << "..." << std::endl;
-        BranchMetrics metrics = analyzeBranchTrace(traceFile, maxLines);
+        BranchMetrics metrics = analyzeBranchTrace(traceFile, maxLines, historyLength, predictabilityHistories);
         allMetrics.push_back(metrics);
     }
+
+    // schema metadata of the columnar copies, see utils/columnar.hpp
+    std::vector<std::pair<std::string, std::string>> metadata;
+    if (config.COLUMNAR_RESULTS) {
+        metadata = {{"max_lines", std::to_string(maxLines)}, {"history_length", std::to_string(historyLength)}};
+        for (size_t i = 0; i < traceFiles.size(); i++) {
+            metadata.push_back({"trace_hash." + allMetrics[i].traceName, hashToHex(hashFile(traceFiles[i]))});
+        }
+    }
+    auto tableMetadata = [&](const std::string& table) {
+        auto entries = metadata;
+        entries.insert(entries.begin(), {"table", table});
+        return entries;
+    };
     
     // Create main CSV file with basic metrics
+    perfProfiler().beginJob("all", "csv");
+    perfProfiler().enter(PerfPhase::Export);
     std::ofstream mainFile(mainCSV);
     if (!mainFile.is_open()) {
         std::cerr << "Error: Could not create CSV file " << mainCSV << std::endl;
@@ -361,8 +462,29 @@ void createPandasFriendlyCSV(const std::vector<std::string>& traceFiles,
              << "HighlyPredictableCond_pct,"
              << "Top5HotspotPercentage" << std::endl;
     
+    auto mainColumnar = columnarFor(mainCSV, {
+        {"TraceName", ColumnType::String}, {"TotalBranches", ColumnType::UInt64},
+        {"DirectBranches_pct", ColumnType::Float64}, {"IndirectBranches_pct", ColumnType::Float64},
+        {"ConditionalBranches_pct", ColumnType::Float64}, {"UnconditionalBranches_pct", ColumnType::Float64},
+        {"RegularBranches_pct", ColumnType::Float64}, {"FunctionCalls_pct", ColumnType::Float64},
+        {"FunctionReturns_pct", ColumnType::Float64}, {"TakenBranches_pct", ColumnType::Float64},
+        {"ConditionalTaken_pct", ColumnType::Float64}, {"UniqueBranchLocations", ColumnType::UInt64},
+        {"UniqueCondBranchLocations", ColumnType::UInt64}, {"HighlyPredictableAll_pct", ColumnType::Float64},
+        {"HighlyPredictableCond_pct", ColumnType::Float64}, {"Top5HotspotPercentage", ColumnType::Float64},
+    }, tableMetadata("trace comparison"));
+
     // Write main CSV data for each trace
     for (const auto& metrics : allMetrics) {
+        if (mainColumnar) {
+            mainColumnar->row(metrics.traceName, metrics.totalBranches, metrics.directBranchesPercent,
+                              metrics.indirectBranchesPercent, metrics.conditionalBranchesPercent,
+                              metrics.unconditionalBranchesPercent, metrics.regularBranchesPercent,
+                              metrics.callInstructionsPercent, metrics.returnInstructionsPercent,
+                              metrics.takenBranchesPercent, metrics.condTakenBranchesPercent,
+                              metrics.uniqueBranchLocations, metrics.uniqueCondBranchLocations,
+                              metrics.highlyPredictableAllPercent, metrics.highlyPredictableCondPercent,
+                              metrics.hotspotPercentage);
+        }
         mainFile << metrics.traceName << ","
                  << metrics.totalBranches << ","
                  << std::fixed << std::setprecision(2)
@@ -424,6 +546,20 @@ void createPandasFriendlyCSV(const std::vector<std::string>& traceFiles,
     
     pcPatternsFile.close();
     std::cout << "PC patterns by rank CSV exported to " << pcPatternsCSV << std::endl;
+
+    // the columnar copies of the by-rank tables are long: one row per trace and rank
+    const std::vector<ColumnSpec> patternColumns = {
+        {"TraceName", ColumnType::String}, {"Rank", ColumnType::UInt64},
+        {"Pattern", ColumnType::String}, {"Percentage", ColumnType::Float64},
+    };
+    if (auto columnar = columnarFor(pcPatternsCSV, patternColumns, tableMetadata("pc patterns by rank"))) {
+        for (const auto& metrics : allMetrics) {
+            for (size_t rank = 0; rank < metrics.pcPatterns.size(); rank++) {
+                columnar->row(metrics.traceName, rank + 1, metrics.pcPatterns[rank].pattern,
+                              metrics.pcPatterns[rank].percentage);
+            }
+        }
+    }
     
     // =================== Create taken patterns by rank CSV file ===================
     std::ofstream takenPatternsFile(takenPatternsCSV);
@@ -464,6 +600,15 @@ void createPandasFriendlyCSV(const std::vector<std::string>& traceFiles,
     
     takenPatternsFile.close();
     std::cout << "Taken patterns by rank CSV exported to " << takenPatternsCSV << std::endl;
+
+    if (auto columnar = columnarFor(takenPatternsCSV, patternColumns, tableMetadata("taken patterns by rank"))) {
+        for (const auto& metrics : allMetrics) {
+            for (size_t rank = 0; rank < metrics.takenPatterns.size(); rank++) {
+                columnar->row(metrics.traceName, rank + 1, metrics.takenPatterns[rank].pattern,
+                              metrics.takenPatterns[rank].percentage);
+            }
+        }
+    }
     
     // =================== Create hotspots CSV file ===================
     std::ofstream hotspotsFile(hotspotsCSV);
@@ -504,6 +649,139 @@ void createPandasFriendlyCSV(const std::vector<std::string>& traceFiles,
     
     hotspotsFile.close();
     std::cout << "Branch hotspots CSV exported to " << hotspotsCSV << std::endl;
+
+    if (auto columnar = columnarFor(hotspotsCSV, {
+            {"TraceName", ColumnType::String}, {"Rank", ColumnType::UInt64}, {"Address", ColumnType::UInt64},
+            {"Executions", ColumnType::UInt64}, {"ExecPct", ColumnType::Float64}, {"TakenPct", ColumnType::Float64},
+            {"IsConditional", ColumnType::UInt64},
+        }, tableMetadata("trace hotspots"))) {
+        for (const auto& metrics : allMetrics) {
+            for (size_t i = 0; i < metrics.topHotspots.size(); i++) {
+                const auto& hotspot = metrics.topHotspots[i];
+                columnar->row(metrics.traceName, i + 1, hotspot.address, hotspot.executions,
+                              hotspot.executionPercentage, hotspot.takenPercentage, hotspot.isConditional);
+            }
+        }
+    }
+
+    // =================== Create predictability CSV files ===================
+    if (!predictabilityHistories.empty()) {
+        std::ofstream predictabilityFile(predictabilityCSV);
+        if (!predictabilityFile.is_open()) {
+            std::cerr << "Error: Could not create CSV file " << predictabilityCSV << std::endl;
+            return;
+        }
+        predictabilityFile << "TraceName,History,HistoryBits,ConditionalBranches,ConditionalEntropy,MispredictionBound_pct" << std::endl;
+        auto columnar = columnarFor(predictabilityCSV, {
+            {"TraceName", ColumnType::String}, {"History", ColumnType::String}, {"HistoryBits", ColumnType::UInt64},
+            {"ConditionalBranches", ColumnType::UInt64}, {"ConditionalEntropy", ColumnType::Float64},
+            {"MispredictionBound_pct", ColumnType::Float64},
+        }, tableMetadata("predictability"));
+        for (const auto& metrics : allMetrics) {
+            for (const auto& bound : metrics.predictability) {
+                if (columnar) {
+                    columnar->row(metrics.traceName, historyKindName(bound.kind), bound.bits,
+                                  metrics.conditionalBranches, bound.entropy, bound.mispredictionBound);
+                }
+                predictabilityFile << metrics.traceName << ","
+                                   << historyKindName(bound.kind) << ","
+                                   << bound.bits << ","
+                                   << metrics.conditionalBranches << ","
+                                   << std::fixed << std::setprecision(4) << bound.entropy << ","
+                                   << bound.mispredictionBound << std::endl;
+            }
+        }
+        predictabilityFile.close();
+        std::cout << "Predictability bounds CSV exported to " << predictabilityCSV << std::endl;
+
+        std::ofstream branchFile(branchPredictabilityCSV);
+        if (!branchFile.is_open()) {
+            std::cerr << "Error: Could not create CSV file " << branchPredictabilityCSV << std::endl;
+            return;
+        }
+        branchFile << "TraceName,PC,Executions,History,HistoryBits,ConditionalEntropy,MispredictionBound_pct" << std::endl;
+        auto branchColumnar = columnarFor(branchPredictabilityCSV, {
+            {"TraceName", ColumnType::String}, {"PC", ColumnType::UInt64}, {"Executions", ColumnType::UInt64},
+            {"History", ColumnType::String}, {"HistoryBits", ColumnType::UInt64},
+            {"ConditionalEntropy", ColumnType::Float64}, {"MispredictionBound_pct", ColumnType::Float64},
+        }, tableMetadata("predictability by pc"));
+        for (const auto& metrics : allMetrics) {
+            for (const auto& branch : metrics.branchPredictability) {
+                for (const auto& bound : branch.bounds) {
+                    if (branchColumnar) {
+                        branchColumnar->row(metrics.traceName, branch.pc, branch.executions, historyKindName(bound.kind),
+                                            bound.bits, bound.entropy, bound.mispredictionBound);
+                    }
+                    branchFile << metrics.traceName << ",0x" << std::hex << branch.pc << std::dec << ","
+                               << branch.executions << ","
+                               << historyKindName(bound.kind) << ","
+                               << bound.bits << ","
+                               << std::fixed << std::setprecision(4) << bound.entropy << ","
+                               << bound.mispredictionBound << std::endl;
+                }
+            }
+        }
+        branchFile.close();
+        std::cout << "Per-branch predictability CSV exported to " << branchPredictabilityCSV << std::endl;
+    }
+
+    // =================== Create reuse distance CSV file ===================
+    std::ofstream reuseFile(reuseCSV);
+    if (!reuseFile.is_open()) {
+        std::cerr << "Error: Could not create CSV file " << reuseCSV << std::endl;
+        return;
+    }
+    // LRUHitRate_pct: hit rate of a fully associative LRU table of DistanceMax + 1 entries
+    reuseFile << "TraceName,Stream,IndexBits,DistanceMin,DistanceMax,Accesses,Accesses_pct,LRUHitRate_pct" << std::endl;
+    auto reuseColumnar = columnarFor(reuseCSV, {
+        {"TraceName", ColumnType::String}, {"Stream", ColumnType::String}, {"IndexBits", ColumnType::UInt64},
+        {"DistanceMin", ColumnType::UInt64}, {"DistanceMax", ColumnType::UInt64}, {"Accesses", ColumnType::UInt64},
+        {"Accesses_pct", ColumnType::Float64}, {"LRUHitRate_pct", ColumnType::Float64},
+    }, tableMetadata("reuse distance"));
+    for (const auto& metrics : allMetrics) {
+        auto writeHistogram = [&](const std::string& stream, size_t bits, const ReuseHistogram& histogram) {
+            for (size_t b = 0; b < histogram.buckets.size() && histogram.accesses > 0; b++) {
+                if (reuseColumnar) {
+                    reuseColumnar->row(metrics.traceName, stream, bits, ReuseHistogram::bucketMin(b),
+                                       ReuseHistogram::bucketMax(b), histogram.buckets[b],
+                                       100.0 * histogram.buckets[b] / histogram.accesses, histogram.lruHitRate(b));
+                }
+                reuseFile << metrics.traceName << "," << stream << "," << bits << ","
+                          << ReuseHistogram::bucketMin(b) << "," << ReuseHistogram::bucketMax(b) << ","
+                          << histogram.buckets[b] << ","
+                          << std::fixed << std::setprecision(4) << 100.0 * histogram.buckets[b] / histogram.accesses << ","
+                          << histogram.lruHitRate(b) << std::endl;
+            }
+        };
+        writeHistogram("pc", 64, metrics.pcReuse);
+        writeHistogram("index", metrics.reuseIndexBits, metrics.indexReuse);
+    }
+    reuseFile.close();
+    std::cout << "Reuse distance CSV exported to " << reuseCSV << std::endl;
+
+    // =================== Create working set CSV file ===================
+    std::ofstream workingSetFile(workingSetCSV);
+    if (!workingSetFile.is_open()) {
+        std::cerr << "Error: Could not create CSV file " << workingSetCSV << std::endl;
+        return;
+    }
+    workingSetFile << "TraceName,Interval,Start,Branches,UniquePCs,UniqueIndices" << std::endl;
+    auto workingSetColumnar = columnarFor(workingSetCSV, {
+        {"TraceName", ColumnType::String}, {"Interval", ColumnType::UInt64}, {"Start", ColumnType::UInt64},
+        {"Branches", ColumnType::UInt64}, {"UniquePCs", ColumnType::UInt64}, {"UniqueIndices", ColumnType::UInt64},
+    }, tableMetadata("working set"));
+    for (const auto& metrics : allMetrics) {
+        for (size_t i = 0; i < metrics.workingSet.size(); i++) {
+            const auto& ws = metrics.workingSet[i];
+            if (workingSetColumnar) {
+                workingSetColumnar->row(metrics.traceName, i, ws.start, ws.branches, ws.uniquePCs, ws.uniqueIndices);
+            }
+            workingSetFile << metrics.traceName << "," << i << "," << ws.start << "," << ws.branches << ","
+                           << ws.uniquePCs << "," << ws.uniqueIndices << std::endl;
+        }
+    }
+    workingSetFile.close();
+    std::cout << "Working set CSV exported to " << workingSetCSV << std::endl;
     
     // Also print a simple summary to console
     std::cout << "\n===== Trace Analysis Summary =====\n";
@@ -513,6 +791,16 @@ void createPandasFriendlyCSV(const std::vector<std::string>& traceFiles,
                   << "  - Conditional branches: " << metrics.conditionalBranchesPercent << "%\n"
                   << "  - Highly predictable cond. branches: " << metrics.highlyPredictableCondPercent << "%\n"
                   << "  - Top 5 hotspot percentage: " << metrics.hotspotPercentage << "%\n";
+
+        // Show the tightest misprediction bound over the configured histories
+        if (!metrics.predictability.empty()) {
+            auto best = std::min_element(metrics.predictability.begin(), metrics.predictability.end(),
+                [](const PredictabilityBound& a, const PredictabilityBound& b) {
+                    return a.mispredictionBound < b.mispredictionBound;
+                });
+            std::cout << "  - Misprediction bound: " << best->mispredictionBound << "% ("
+                      << historyKindName(best->kind) << " history, " << best->bits << " bits)\n";
+        }
                   
         // Show top taken patterns
         if (!metrics.takenPatterns.empty()) {
@@ -0,0 +1,429 @@
+# pragma once
+
+#include "predictor/branch.hpp"
+#include "utils/config.hpp"
+#include "utils/trace_io.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// ==== asynchronous trace reader ====
+// Streams a trace through a ring of config.ASYNC_QUEUE_DEPTH buffers of
+// config.ASYNC_BUFFER_SIZE bytes. Every buffer has a read in flight while
+// the parser works on the oldest completed one, so the disk keeps busy
+// during simulation; a consumed buffer is immediately reissued for the next
+// unread part of the file. Reads are submitted through io_uring (raw
+// syscalls, no liburing) and fall back to blocking pread() where io_uring is
+// unavailable (old kernels, seccomp). With config.ASYNC_DIRECT_IO the file
+// is opened with O_DIRECT, so traces larger than RAM do not evict the page
+// cache; buffers and reads are aligned to ASYNC_IO_ALIGNMENT for it.
+//
+// Records crossing a buffer boundary are assembled in a small carry buffer,
+// all others are parsed in place.
+
+const size_t ASYNC_IO_ALIGNMENT = 4096;
+
+// Minimal io_uring: one submission and one completion ring, readv only
+class IoUring {
+private:
+    int ringFd = -1;
+    void* sqRing = nullptr;
+    size_t sqRingSize = 0;
+    void* cqRing = nullptr;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+    unsigned pending = 0;           // queued, not yet submitted
+
+    void release() {
+        if (sqes) munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing) munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) ::close(ringFd);
+        sqes = nullptr;
+        sqRing = cqRing = nullptr;
+        ringFd = -1;
+    }
+
+public:
+    IoUring() = default;
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    ~IoUring() { release(); }
+
+    // Set up a ring of at least entries slots, returns false (with errno) if io_uring is unavailable
+    bool setup(unsigned entries) {
+        io_uring_params params{};
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (ringFd < 0) return false;
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) { sqRing = nullptr; release(); return false; }
+        cqRing = singleMap ? sqRing
+                           : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) { cqRing = nullptr; release(); return false; }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* s = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (s == MAP_FAILED) { release(); return false; }
+        sqes = static_cast<io_uring_sqe*>(s);
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    bool active() const { return ringFd >= 0; }
+
+    // Queue a readv of one iovec, tagged with userData; the iovec must live until completion
+    void queueRead(int fd, const iovec* vector, uint64_t offset, uint64_t userData) {
+        unsigned tail = *sqTail;
+        unsigned index = tail & sqMask;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(vector);
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = userData;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        pending++;
+    }
+
+    // Submit queued reads and wait for at least waitFor completions
+    void submit(unsigned waitFor) {
+        while (true) {
+            unsigned flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+            long n = syscall(__NR_io_uring_enter, ringFd, pending, waitFor, flags, nullptr, 0);
+            if (n >= 0) {
+                pending -= std::min<unsigned>(pending, static_cast<unsigned>(n));
+                return;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                throw std::runtime_error(std::string("io_uring_enter: ") + std::strerror(errno));
+            }
+        }
+    }
+
+    // Pop one completion, returns false if none is ready
+    bool complete(uint64_t& userData, int& result) {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return false;
+        const io_uring_cqe& cqe = cqes[head & cqMask];
+        userData = cqe.user_data;
+        result = cqe.res;
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+
+
+// Trace reader streaming the file through io_uring (or pread) buffers, see above
+class AsyncTraceReader final : public BranchSource {
+private:
+    struct Buffer {
+        char* data = nullptr;
+        uint64_t offset = 0;        // file offset of data[0]
+        size_t expected = 0;        // bytes of the file this buffer covers
+        size_t filled = 0;
+        bool inFlight = false;
+        iovec vector{};
+    };
+
+    std::string path;
+    int fd = -1;
+    uint64_t fileSize = 0;
+    size_t bufferSize;
+    bool directIO;
+    IoUring ring;
+    std::vector<Buffer> buffers;
+    uint64_t nextOffset = 0;        // next file offset to issue a read for
+    size_t current = 0;             // buffer being parsed
+    bool exhausted = false;
+
+    TraceFormat traceFormat = TraceFormat::Text;
+    const char* cursor = nullptr;   // next byte in the current buffer
+    const char* limit = nullptr;    // end of the current buffer's data
+    uint64_t consumed = 0;          // file bytes before the current buffer
+    std::string carry;              // a record crossing a buffer boundary
+
+    [[noreturn]] void fail(const std::string& what, int error) {
+        throw std::runtime_error(what + " " + path + ": " + std::strerror(error));
+    }
+
+    // Issue the read of the rest of buffer b. O_DIRECT needs aligned offsets,
+    // addresses and lengths, so after a short read the partial block is read again
+    void issue(Buffer& b) {
+        if (directIO) b.filled &= ~(ASYNC_IO_ALIGNMENT - 1);
+        b.vector.iov_base = b.data + b.filled;
+        b.vector.iov_len = (directIO ? bufferSize - b.filled : b.expected - b.filled);
+        b.inFlight = true;
+        if (ring.active()) {
+            ring.queueRead(fd, &b.vector, b.offset + b.filled, &b - buffers.data());
+            return;
+        }
+        while (b.filled < b.expected) {
+            ssize_t n = pread(fd, b.data + b.filled, b.vector.iov_len, b.offset + b.filled);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) fail("Could not read", errno);
+            if (n == 0) break;          // the file shrank
+            b.filled += n;
+            if (directIO && b.filled < b.expected) b.filled &= ~(ASYNC_IO_ALIGNMENT - 1);
+            b.vector.iov_len = (directIO ? bufferSize : b.expected) - b.filled;
+        }
+        b.inFlight = false;
+    }
+
+    // Point b at the next unread part of the file and start reading it
+    bool refill(Buffer& b) {
+        if (nextOffset >= fileSize) return false;
+        b.offset = nextOffset;
+        b.expected = static_cast<size_t>(std::min<uint64_t>(bufferSize, fileSize - nextOffset));
+        b.filled = 0;
+        nextOffset += b.expected;
+        issue(b);
+        return true;
+    }
+
+    // Block until buffer b's read has completed, reissuing short reads
+    void wait(Buffer& b) {
+        while (b.inFlight) {
+            ring.submit(1);
+            uint64_t tag;
+            int result;
+            while (ring.complete(tag, result)) {
+                Buffer& done = buffers[tag];
+                if (result < 0) fail("Could not read", -result);
+                done.filled += result;
+                if (result == 0 || done.filled >= done.expected) {
+                    done.filled = std::min(done.filled, done.expected);
+                    done.expected = done.filled;
+                    done.inFlight = false;
+                } else {
+                    issue(done);        // short read, fetch the rest
+                }
+            }
+        }
+    }
+
+    // Make the next buffer current, reissuing the consumed one; false at end of file
+    bool advance() {
+        if (exhausted) return false;
+        Buffer& done = buffers[current];
+        consumed += done.expected;
+        bool reissued = refill(done);
+        if (reissued && ring.active()) ring.submit(0);
+        current = (current + 1) % buffers.size();
+        Buffer& b = buffers[current];
+        if (b.offset < consumed || b.expected == 0) {
+            exhausted = true;           // every buffer is behind the end of the file
+            cursor = limit = nullptr;
+            return false;
+        }
+        wait(b);
+        cursor = b.data;
+        limit = b.data + b.filled;
+        return true;
+    }
+
+    // Returns false for a skipped malformed line
+    bool parseLine(const char* line, const char* lineEnd, Branch& branch) {
+        if (parseBranchLine(line, lineEnd, branch)) return true;
+        rejectLine(line, lineEnd);
+        return false;
+    }
+
+    // next() for records that cross the end of the current buffer
+    bool nextAcrossBuffers(Branch& branch) {
+        while (true) {
+            carry.assign(cursor, limit);
+            if (traceFormat == TraceFormat::Binary) {
+                while (carry.size() < BINARY_RECORD_SIZE) {
+                    if (!advance()) return false;       // truncated trailing record
+                    size_t take = std::min<size_t>(BINARY_RECORD_SIZE - carry.size(), limit - cursor);
+                    carry.append(cursor, take);
+                    cursor += take;
+                }
+                decodeBinaryRecord(carry.data(), branch);
+                return true;
+            }
+            while (true) {
+                if (!advance()) {
+                    // last line without a newline
+                    if (carry.empty()) return false;
+                    bool parsed = parseLine(carry.data(), carry.data() + carry.size(), branch);
+                    carry.clear();
+                    return parsed;
+                }
+                const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', limit - cursor));
+                if (!newline) {
+                    carry.append(cursor, limit);
+                    continue;
+                }
+                carry.append(cursor, newline);
+                cursor = newline + 1;
+                break;
+            }
+            if (!carry.empty() && parseLine(carry.data(), carry.data() + carry.size(), branch)) {
+                return true;
+            }
+            // an empty or skipped line, continue with the in-place path
+            return next(branch);
+        }
+    }
+
+public:
+    explicit AsyncTraceReader(const std::string& path, size_t queueDepth = config.ASYNC_QUEUE_DEPTH,
+                              size_t bufferBytes = config.ASYNC_BUFFER_SIZE, bool direct = config.ASYNC_DIRECT_IO)
+        : path(path), directIO(direct) {
+        fd = ::open(path.c_str(), O_RDONLY | (directIO ? O_DIRECT : 0));
+        if (fd < 0 && directIO && errno == EINVAL) {
+            // the file system does not support O_DIRECT
+            directIO = false;
+            fd = ::open(path.c_str(), O_RDONLY);
+        }
+        if (fd < 0) {
+            std::cerr << "Error: Could not open file " << path << std::endl;
+            throw std::runtime_error("File not found");
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not stat " + path);
+        }
+        fileSize = static_cast<uint64_t>(st.st_size);
+        if (!directIO) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        bufferSize = std::max(ASYNC_IO_ALIGNMENT, (bufferBytes + ASYNC_IO_ALIGNMENT - 1) & ~(ASYNC_IO_ALIGNMENT - 1));
+        queueDepth = std::max<size_t>(1, queueDepth);
+        if (!ring.setup(static_cast<unsigned>(queueDepth))) {
+            static bool warned = false;
+            if (!warned) {
+                std::cerr << "Warning: io_uring unavailable (" << std::strerror(errno)
+                          << "), reading traces with pread" << std::endl;
+                warned = true;
+            }
+        }
+
+        buffers.resize(queueDepth);
+        for (Buffer& b : buffers) {
+            b.data = static_cast<char*>(std::aligned_alloc(ASYNC_IO_ALIGNMENT, bufferSize));
+            if (!b.data) {
+                for (Buffer& allocated : buffers) std::free(allocated.data);
+                ::close(fd);
+                throw std::bad_alloc();
+            }
+        }
+        for (Buffer& b : buffers) refill(b);
+        if (ring.active()) ring.submit(0);
+
+        Buffer& first = buffers[0];
+        if (first.expected == 0) {
+            exhausted = true;           // empty file
+            return;
+        }
+        wait(first);
+        cursor = first.data;
+        limit = first.data + first.filled;
+        if (first.filled >= BINARY_TRACE_HEADER_SIZE &&
+            std::memcmp(first.data, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) == 0) {
+            traceFormat = TraceFormat::Binary;
+            cursor += BINARY_TRACE_HEADER_SIZE;
+        }
+    }
+
+    AsyncTraceReader(const AsyncTraceReader&) = delete;
+    AsyncTraceReader& operator=(const AsyncTraceReader&) = delete;
+
+    ~AsyncTraceReader() {
+        // the kernel may still write into the buffers
+        for (Buffer& b : buffers) {
+            try {
+                wait(b);
+            } catch (const std::exception&) {}
+        }
+        for (Buffer& b : buffers) std::free(b.data);
+        if (fd >= 0) ::close(fd);
+    }
+
+    TraceFormat format() const { return traceFormat; }
+    bool usesIoUring() const { return ring.active(); }
+    bool usesDirectIO() const { return directIO; }
+
+    bool next(Branch& branch) override {
+        if (traceFormat == TraceFormat::Binary) {
+            if (static_cast<size_t>(limit - cursor) >= BINARY_RECORD_SIZE) {
+                decodeBinaryRecord(cursor, branch);
+                cursor += BINARY_RECORD_SIZE;
+                return true;
+            }
+            return nextAcrossBuffers(branch);
+        }
+        while (cursor < limit) {
+            const char* newline = static_cast<const char*>(std::memchr(cursor, '\n', limit - cursor));
+            if (!newline) break;
+            const char* line = cursor;
+            cursor = newline + 1;
+            if (newline == line) continue;  // skip empty lines
+            if (!parseLine(line, newline, branch)) continue;
+            return true;
+        }
+        return nextAcrossBuffers(branch);
+    }
+
+    size_t nextBatch(Branch* out, size_t count) override {
+        size_t n = 0;
+        while (n < count && next(out[n])) n++;
+        return n;
+    }
+
+    size_t skip(size_t count) override {
+        Branch branch;
+        size_t n = 0;
+        while (n < count && next(branch)) n++;
+        return n;
+    }
+
+    double progress() const override {
+        if (fileSize == 0 || exhausted) return 1.0;
+        return static_cast<double>(consumed + (cursor - buffers[current].data)) / fileSize;
+    }
+};
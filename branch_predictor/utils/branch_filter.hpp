@@ -0,0 +1,295 @@
+# pragma once
+
+#include "predictor/branch.hpp"
+#include "utils/trace_io.hpp"
+#include "utils/trace_columns.hpp"
+#include "utils/hash.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
+
+// ==== branch classes ====
+// Every record falls in one class, misprediction rates are reported per class
+
+enum BranchClass : uint8_t { CLASS_CONDITIONAL, CLASS_JUMP, CLASS_INDIRECT, CLASS_CALL, CLASS_RETURN };
+
+const size_t BRANCH_CLASSES = 5;
+const char* const BRANCH_CLASS_NAMES[BRANCH_CLASSES] = {"conditional", "jump", "indirect", "call", "return"};
+
+// Flag combination of a record: kind code (trace_io.hpp) in bits 0-1, direct in bit 2, conditional in bit 3
+inline uint8_t branchFlagIndex(uint8_t kindCode, bool direct, bool conditional) {
+    return kindCode | (direct << 2) | (conditional << 3);
+}
+
+inline uint8_t branchFlagIndex(const Branch& branch) {
+    return branchFlagIndex(encodeBranchKind(branch.kind), branch.direct, branch.conditional);
+}
+
+inline BranchClass branchClassOf(uint8_t flagIndex) {
+    uint8_t kind = flagIndex & 3;
+    if (kind == 1) return CLASS_CALL;
+    if (kind == 2) return CLASS_RETURN;
+    if (flagIndex & 8) return CLASS_CONDITIONAL;
+    return (flagIndex & 4) ? CLASS_JUMP : CLASS_INDIRECT;
+}
+
+// Kind codes by kind character and branch classes by flag combination, so
+// classifying a record takes two loads and no branches
+struct BranchClassTable {
+    uint8_t kindCodes[256];
+    uint8_t classes[16];
+    BranchClassTable() {
+        for (int c = 0; c < 256; c++) kindCodes[c] = encodeBranchKind(static_cast<char>(c));
+        for (uint8_t i = 0; i < 16; i++) classes[i] = branchClassOf(i);
+    }
+
+    static const BranchClassTable& get() {
+        static const BranchClassTable table;
+        return table;
+    }
+
+    BranchClass classOf(const Branch& branch) const {
+        uint8_t code = kindCodes[static_cast<uint8_t>(branch.kind)];
+        return static_cast<BranchClass>(classes[branchFlagIndex(code, branch.direct, branch.conditional)]);
+    }
+};
+
+inline BranchClass branchClassOf(const Branch& branch) {
+    return BranchClassTable::get().classOf(branch);
+}
+
+// Branches and mispredictions per class
+struct ClassCounts {
+    uint64_t branches[BRANCH_CLASSES] = {};
+    uint64_t mispredictions[BRANCH_CLASSES] = {};
+
+    void add(const Branch& branch, bool predicted) {
+        BranchClass c = branchClassOf(branch);
+        branches[c]++;
+        mispredictions[c] += predicted != branch.taken;
+    }
+
+    // Add a batch of records with their predictions. Counts are accumulated
+    // in 12-bit lanes of two registers, one lane per class, so consecutive
+    // records of a class do not wait on each other's stores.
+    void addBatch(const Branch* batch, const uint8_t* predictions, size_t count) {
+        const BranchClassTable& table = BranchClassTable::get();
+        const size_t lane = 12;
+        for (size_t begin = 0; begin < count; begin += (1 << lane) - 1) {
+            size_t end = std::min(count, begin + (1 << lane) - 1);
+            uint64_t seen = 0, missed = 0;
+            for (size_t i = begin; i < end; i++) {
+                uint64_t one = uint64_t(1) << (lane * table.classOf(batch[i]));
+                seen += one;
+                missed += (predictions[i] != batch[i].taken) ? one : 0;
+            }
+            for (size_t c = 0; c < BRANCH_CLASSES; c++) {
+                branches[c] += (seen >> (lane * c)) & ((1 << lane) - 1);
+                mispredictions[c] += (missed >> (lane * c)) & ((1 << lane) - 1);
+            }
+        }
+    }
+
+    double mispredictionRate(size_t c) const {
+        return branches[c] > 0 ? static_cast<double>(mispredictions[c]) / branches[c] * 100.0 : 0.0;
+    }
+
+    // "n:m;n:m;..." in class order, as stored in the result cache
+    std::string encode() const {
+        std::string text;
+        for (size_t c = 0; c < BRANCH_CLASSES; c++) {
+            text += (c ? ";" : "") + std::to_string(branches[c]) + ":" + std::to_string(mispredictions[c]);
+        }
+        return text;
+    }
+
+    static bool decode(const std::string& text, ClassCounts& counts) {
+        std::stringstream ss(text);
+        std::string item;
+        size_t c = 0;
+        while (std::getline(ss, item, ';')) {
+            size_t colon = item.find(':');
+            if (c >= BRANCH_CLASSES || colon == std::string::npos) return false;
+            counts.branches[c] = std::stoull(item.substr(0, colon));
+            counts.mispredictions[c] = std::stoull(item.substr(colon + 1));
+            c++;
+        }
+        return c == BRANCH_CLASSES;
+    }
+};
+
+
+// ==== branch filter ====
+// Selects the records fed to direction predictors, everything by default.
+// A filter is a comma separated list of clauses that must all hold:
+//   conditional / unconditional   the conditional flag
+//   direct / indirect             the direct flag
+//   kind=LETTERS                  one of the kinds, e.g. kind=b or kind=cr
+//   pc=LO-HI                      hex pc in [LO, HI]; several pc clauses
+//                                 select the union of their ranges
+//   pcs=FILE                      pc in the allow-list FILE, one hex pc per line
+// e.g. "conditional,direct,pc=400000-4fffff". The flag clauses reduce to a
+// 16-entry table over (kind, direct, conditional): row readers test one bit
+// per record, columnar traces are tested 64 records at a time on their flag
+// bit columns and only the selected records are gathered.
+
+class BranchFilter {
+private:
+    uint16_t flagTable = 0xFFFF;        // bit i: flag combination i selected
+    std::vector<std::pair<uint64_t, uint64_t>> pcRanges;
+    std::unordered_set<uint64_t> allowList;
+    bool hasAllowList = false;
+    std::string allowListKey;           // "FILE@<content hash>"
+    std::string text = "all";
+
+    void restrictFlags(bool (*keep)(uint8_t flagIndex, int value), int value) {
+        for (uint8_t i = 0; i < 16; i++) {
+            if (!keep(i, value)) flagTable &= ~(uint16_t(1) << i);
+        }
+    }
+
+    void loadAllowList(const std::string& path) {
+        std::ifstream file(path);
+        if (!file.is_open()) throw std::runtime_error("Could not open pc allow-list " + path);
+        std::string line;
+        std::vector<uint64_t> pcs;
+        while (std::getline(file, line)) {
+            line = line.substr(0, line.find('#'));
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+            pcs.push_back(std::stoull(line, nullptr, 16));
+        }
+        std::sort(pcs.begin(), pcs.end());
+        pcs.erase(std::unique(pcs.begin(), pcs.end()), pcs.end());
+        allowList.insert(pcs.begin(), pcs.end());
+        hasAllowList = true;
+        allowListKey = path + "@" + hashToHex(hashBytes(pcs.data(), pcs.size() * sizeof(uint64_t)));
+    }
+
+public:
+    static BranchFilter parse(const std::string& spec) {
+        BranchFilter filter;
+        std::stringstream ss(spec);
+        std::string clause;
+        while (std::getline(ss, clause, ',')) {
+            clause.erase(0, clause.find_first_not_of(" \t"));
+            clause.erase(clause.find_last_not_of(" \t") + 1);
+            if (clause.empty() || clause == "all") continue;
+            size_t eq = clause.find('=');
+            std::string key = clause.substr(0, eq);
+            std::string value = (eq == std::string::npos) ? "" : clause.substr(eq + 1);
+            if (eq == std::string::npos && (key == "conditional" || key == "unconditional")) {
+                filter.restrictFlags([](uint8_t i, int v) { return bool(i & 8) == bool(v); }, key == "conditional");
+            } else if (eq == std::string::npos && (key == "direct" || key == "indirect")) {
+                filter.restrictFlags([](uint8_t i, int v) { return bool(i & 4) == bool(v); }, key == "direct");
+            } else if (key == "kind" && !value.empty()) {
+                int kinds = 0;
+                for (char kind : value) {
+                    if (kind != 'b' && kind != 'c' && kind != 'r') throw std::invalid_argument("Unknown branch kind in " + clause);
+                    kinds |= 1 << encodeBranchKind(kind);
+                }
+                filter.restrictFlags([](uint8_t i, int v) { return bool((v >> (i & 3)) & 1); }, kinds);
+            } else if (key == "pc" && value.find('-') != std::string::npos) {
+                size_t dash = value.find('-');
+                uint64_t low = std::stoull(value.substr(0, dash), nullptr, 16);
+                uint64_t high = std::stoull(value.substr(dash + 1), nullptr, 16);
+                if (low > high) throw std::invalid_argument("Empty pc range " + clause);
+                filter.pcRanges.push_back({low, high});
+            } else if (key == "pcs" && !value.empty()) {
+                filter.loadAllowList(value);
+            } else {
+                throw std::invalid_argument("Invalid filter clause " + clause +
+                                            " (conditional, unconditional, direct, indirect, kind=, pc=, pcs=)");
+            }
+        }
+        if (filter.flagTable == 0) throw std::invalid_argument("Filter " + spec + " selects no branches");
+        if (!filter.empty()) filter.text = spec;
+        return filter;
+    }
+
+    // Selects every record
+    bool empty() const { return flagTable == 0xFFFF && pcRanges.empty() && !hasAllowList; }
+
+    // The filter as given, "all" if empty
+    const std::string& toString() const { return text; }
+
+    // Canonical form for result cache keys, empty if the filter selects everything
+    std::string key() const {
+        if (empty()) return "";
+        std::stringstream ss;
+        ss << "flags=" << std::hex << flagTable;
+        for (const auto& range : pcRanges) ss << ",pc=" << range.first << "-" << range.second;
+        if (hasAllowList) ss << ",pcs=" << allowListKey;
+        return ss.str();
+    }
+
+    bool matchesPc(uint64_t pc) const {
+        if (!pcRanges.empty()) {
+            bool inRange = false;
+            for (const auto& range : pcRanges) inRange |= (pc >= range.first) & (pc <= range.second);
+            if (!inRange) return false;
+        }
+        return !hasAllowList || allowList.count(pc);
+    }
+
+    bool matches(const Branch& branch) const {
+        return ((flagTable >> branchFlagIndex(branch)) & 1) && matchesPc(branch.pc);
+    }
+
+    // Keep the selected records of branches[0, count) in order at the front, returns how many
+    size_t compact(Branch* branches, size_t count) const {
+        size_t kept = 0;
+        if (pcRanges.empty() && !hasAllowList) {
+            // branch-free: every record is copied, the cursor only advances past selected ones
+            for (size_t i = 0; i < count; i++) {
+                branches[kept] = branches[i];
+                kept += (flagTable >> branchFlagIndex(branches[i])) & 1;
+            }
+            return kept;
+        }
+        for (size_t i = 0; i < count; i++) {
+            if (matches(branches[i])) branches[kept++] = branches[i];
+        }
+        return kept;
+    }
+
+    // Records of flag word w (records 64w to 64w + 63) whose flags are selected
+    uint64_t flagWord(const BranchColumns& columns, size_t w) const {
+        if (flagTable == 0xFFFF) return ~uint64_t(0);
+        uint64_t low = columns.kindLow[w], high = columns.kindHigh[w];
+        uint64_t direct = columns.direct[w], conditional = columns.conditional[w];
+        uint64_t selected = 0;
+        for (uint8_t i = 0; i < 16; i++) {
+            if (!((flagTable >> i) & 1)) continue;
+            selected |= ((i & 1) ? low : ~low) & ((i & 2) ? high : ~high) &
+                        ((i & 4) ? direct : ~direct) & ((i & 8) ? conditional : ~conditional);
+        }
+        return selected;
+    }
+
+    // Gather the selected records of columns [begin, end) into out (pc and
+    // flags, target left zero), returns how many
+    size_t gatherSelected(const BranchColumns& columns, size_t begin, size_t end, Branch* out) const {
+        size_t kept = 0;
+        for (size_t i = begin; i < end;) {
+            size_t w = i >> 6;
+            size_t wordEnd = std::min(end, (w + 1) << 6);
+            uint64_t mask = flagWord(columns, w) & (~uint64_t(0) << (i & 63));
+            if (wordEnd & 63) mask &= (uint64_t(1) << (wordEnd & 63)) - 1;
+            while (mask) {
+                size_t j = (w << 6) + __builtin_ctzll(mask);
+                mask &= mask - 1;
+                if (!matchesPc(columns.pc[j])) continue;
+                columns.gather(j, 1, out + kept, true);
+                kept++;
+            }
+            i = wordEnd;
+        }
+        return kept;
+    }
+};
@@ -0,0 +1,268 @@
+# pragma once
+
+#include "utils/config.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <type_traits>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <stdexcept>
+
+// ==== columnar binary result tables ====
+// Result tables are written next to their CSV (x.csv -> x.bpcol) when
+// config.COLUMNAR_RESULTS is set, keeping full-precision numbers and
+// streaming rows in record batches of config.COLUMNAR_BATCH_ROWS, so
+// million-row per-PC and per-interval tables are written and loaded
+// without text formatting or parsing. Layout, little-endian:
+//
+//   "BPCOLS01"
+//   uint32 schema length, schema as JSON:
+//     {"columns": [{"name": "PC", "type": "uint64"}, ...], "metadata": {"key": "value", ...}}
+//     types: int64, uint64, float64, string
+//   record batches:
+//     uint32 row count (never 0xFFFFFFFF), then each column in schema order:
+//       int64 / uint64 / float64: rows x 8 bytes
+//       string: dictionary encoded, as result tables repeat trace and
+//               predictor names: uint32 distinct values n, uint32 offsets[n + 1]
+//               into the values' bytes, the bytes, uint32 codes[rows]
+//   uint32 0xFFFFFFFF, uint64 total rows (missing if the writer did not finish)
+// The schema, the uint32 fields and every buffer are zero-padded to a
+// multiple of 8 bytes, so each column can be mapped as an aligned array.
+//
+// visualize.py's read_columnar loads a file into a pandas DataFrame.
+
+const char COLUMNAR_MAGIC[8] = {'B', 'P', 'C', 'O', 'L', 'S', '0', '1'};
+const uint32_t COLUMNAR_END_MARKER = 0xFFFFFFFF;
+
+enum class ColumnType { Int64, UInt64, Float64, String };
+
+struct ColumnSpec {
+    std::string name;
+    ColumnType type;
+};
+
+inline const char* columnTypeName(ColumnType type) {
+    switch (type) {
+        case ColumnType::Int64: return "int64";
+        case ColumnType::UInt64: return "uint64";
+        case ColumnType::Float64: return "float64";
+        case ColumnType::String: return "string";
+    }
+    return "unknown";
+}
+
+// Quoted JSON string
+inline std::string jsonQuote(const std::string& text) {
+    std::string quoted = "\"";
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += c;
+        } else if (c < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+            quoted += escape;
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "\"";
+}
+
+class ColumnarWriter {
+private:
+    struct Column {
+        ColumnSpec spec;
+        std::vector<uint64_t> values;       // numbers as raw 8-byte words
+        // strings: the batch's distinct values, their end offsets in bytes, and one code per row
+        std::unordered_map<std::string, uint32_t> dictionary;
+        std::vector<uint32_t> offsets;
+        std::string bytes;
+        std::vector<uint32_t> codes;
+    };
+
+    std::string path;
+    std::ofstream out;
+    std::vector<Column> columns;
+    size_t batchRows;
+    size_t rows = 0;            // rows in the current batch
+    uint64_t totalRows = 0;
+    size_t nextColumn = 0;      // column of the next value within a row
+
+    void pad(size_t written) {
+        static const char zeros[8] = {};
+        if (written % 8) out.write(zeros, 8 - written % 8);
+    }
+
+    Column& next(bool number) {
+        if (nextColumn >= columns.size()) throw std::logic_error(path + ": more values than columns in a row");
+        Column& column = columns[nextColumn++];
+        if (number == (column.spec.type == ColumnType::String)) {
+            throw std::logic_error(path + ": wrong value type for column " + column.spec.name);
+        }
+        return column;
+    }
+
+    void add(int64_t value) {
+        Column& column = next(true);
+        if (column.spec.type == ColumnType::Float64) return add(column, static_cast<double>(value));
+        if (column.spec.type == ColumnType::UInt64 && value < 0) {
+            throw std::logic_error(path + ": negative value for unsigned column " + column.spec.name);
+        }
+        column.values.push_back(static_cast<uint64_t>(value));
+    }
+
+    void add(uint64_t value) {
+        Column& column = next(true);
+        if (column.spec.type == ColumnType::Float64) return add(column, static_cast<double>(value));
+        column.values.push_back(value);
+    }
+
+    void add(double value) {
+        Column& column = next(true);
+        if (column.spec.type != ColumnType::Float64) {
+            throw std::logic_error(path + ": floating-point value for integer column " + column.spec.name);
+        }
+        add(column, value);
+    }
+
+    static void add(Column& column, double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        column.values.push_back(bits);
+    }
+
+    void add(const std::string& value) {
+        Column& column = next(false);
+        auto inserted = column.dictionary.emplace(value, static_cast<uint32_t>(column.dictionary.size()));
+        if (inserted.second) {
+            column.bytes += value;
+            column.offsets.push_back(static_cast<uint32_t>(column.bytes.size()));
+        }
+        column.codes.push_back(inserted.first->second);
+    }
+
+    template <typename T>
+    void addValue(const T& value) {
+        if constexpr (std::is_same_v<T, bool>) add(static_cast<uint64_t>(value));
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) add(static_cast<int64_t>(value));
+        else if constexpr (std::is_integral_v<T>) add(static_cast<uint64_t>(value));
+        else if constexpr (std::is_floating_point_v<T>) add(static_cast<double>(value));
+        else add(std::string(value));
+    }
+
+    void writeBatch() {
+        if (rows == 0) return;
+        uint32_t count = static_cast<uint32_t>(rows);
+        out.write(reinterpret_cast<const char*>(&count), 4);
+        pad(4);
+        for (Column& column : columns) {
+            if (column.spec.type == ColumnType::String) {
+                uint32_t distinct = static_cast<uint32_t>(column.offsets.size());
+                uint32_t start = 0;
+                out.write(reinterpret_cast<const char*>(&distinct), 4);
+                pad(4);
+                out.write(reinterpret_cast<const char*>(&start), 4);
+                out.write(reinterpret_cast<const char*>(column.offsets.data()), distinct * 4);
+                pad((distinct + 1) * 4);
+                out.write(column.bytes.data(), column.bytes.size());
+                pad(column.bytes.size());
+                out.write(reinterpret_cast<const char*>(column.codes.data()), column.codes.size() * 4);
+                pad(column.codes.size() * 4);
+                column.dictionary.clear();
+                column.offsets.clear();
+                column.bytes.clear();
+                column.codes.clear();
+            } else {
+                out.write(reinterpret_cast<const char*>(column.values.data()), column.values.size() * 8);
+                column.values.clear();
+            }
+        }
+        rows = 0;
+    }
+
+public:
+    ColumnarWriter(const std::string& path, const std::vector<ColumnSpec>& specs,
+                   const std::vector<std::pair<std::string, std::string>>& metadata = {},
+                   size_t batchRows = config.COLUMNAR_BATCH_ROWS)
+        : path(path), out(path, std::ios::binary), batchRows(std::max<size_t>(1, batchRows)) {
+        if (!out.is_open()) throw std::runtime_error("Could not create " + path);
+        std::string schema = "{\"columns\": [";
+        for (size_t c = 0; c < specs.size(); c++) {
+            schema += (c ? ", " : "") + std::string("{\"name\": ") + jsonQuote(specs[c].name) +
+                      ", \"type\": \"" + columnTypeName(specs[c].type) + "\"}";
+            columns.push_back({specs[c], {}, {}, {}});
+        }
+        schema += "], \"metadata\": {";
+        for (size_t m = 0; m < metadata.size(); m++) {
+            schema += (m ? ", " : "") + jsonQuote(metadata[m].first) + ": " + jsonQuote(metadata[m].second);
+        }
+        schema += "}}";
+
+        uint32_t schemaLength = static_cast<uint32_t>(schema.size());
+        out.write(COLUMNAR_MAGIC, sizeof(COLUMNAR_MAGIC));
+        out.write(reinterpret_cast<const char*>(&schemaLength), 4);
+        out.write(schema.data(), schema.size());
+        pad(4 + schema.size());
+    }
+
+    ColumnarWriter(const ColumnarWriter&) = delete;
+    ColumnarWriter& operator=(const ColumnarWriter&) = delete;
+
+    ~ColumnarWriter() {
+        try {
+            close();
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+        }
+    }
+
+    // Append one row, one value per column in schema order
+    template <typename... Values>
+    void row(const Values&... values) {
+        nextColumn = 0;
+        (addValue(values), ...);
+        if (nextColumn != columns.size()) throw std::logic_error(path + ": fewer values than columns in a row");
+        totalRows++;
+        if (++rows == batchRows) writeBatch();
+    }
+
+    uint64_t size() const { return totalRows; }
+
+    // Write the last batch and the end marker
+    void close() {
+        if (!out.is_open()) return;
+        writeBatch();
+        out.write(reinterpret_cast<const char*>(&COLUMNAR_END_MARKER), 4);
+        pad(4);
+        out.write(reinterpret_cast<const char*>(&totalRows), 8);
+        out.close();
+        if (out.fail()) throw std::runtime_error("Could not write " + path);
+    }
+};
+
+// Columnar sibling of a CSV path (results/x.csv -> results/x.bpcol)
+inline std::string columnarPath(const std::string& csvPath) {
+    std::string base = csvPath;
+    if (base.size() > 4 && base.compare(base.size() - 4, 4, ".csv") == 0) base.resize(base.size() - 4);
+    return base + ".bpcol";
+}
+
+// Writer for the columnar copy of csvPath, or nullptr if columnar output is off or the file can't be created
+inline std::unique_ptr<ColumnarWriter> columnarFor(const std::string& csvPath, const std::vector<ColumnSpec>& columns,
+                                                   const std::vector<std::pair<std::string, std::string>>& metadata = {}) {
+    if (!config.COLUMNAR_RESULTS) return nullptr;
+    try {
+        return std::make_unique<ColumnarWriter>(columnarPath(csvPath), columns, metadata);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
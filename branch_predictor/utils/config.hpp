@@ -15,6 +15,40 @@ inline struct Config
         "trace/wrf_cutted.out",
     };
 
+    // predictor specs evaluated on TRACES when no --experiment file is given
+    std::vector<std::string> PREDICTORS = {
+        "always_taken",
+        "2bit size=512",
+        "2bit size=1024",
+        "2bit size=2048",
+        "2bit size=4096",
+        "gshare size=2048",
+        "profiled size=2048",
+        "profiled_2bit size=2048",
+        "pag history=10 bht=1024",
+        "pap history=8 bht=1024 phts=64",
+        "sag history=10 sets=64",
+    };
+
+    // finished jobs keyed by trace content and predictor spec (disabled with --no-cache)
+    std::string RESULT_CACHE_DIR = "results/cache";
+
+    // design-space exploration (predictor-dse): search space and early pruning
+    std::vector<std::string> DSE_PREDICTORS = {
+        "2bit size=256,512,1024,2048,4096,8192,16384,32768,65536",
+        "gshare size=256,512,1024,2048,4096,8192,16384,32768,65536",
+        "gshare size=1024,4096,16384 history=16,32,64,128",
+        "profiled size=256,512,1024,2048,4096,8192,16384,32768,65536",
+        "profiled_2bit size=256,512,1024,2048,4096,8192,16384,32768,65536",
+        "pag history=4,6,8,10,12 bht=256,1024,4096",
+        "pap history=4,6,8 bht=1024 phts=16,64,256",
+        "sag history=6,8,10,12 sets=16,64,256",
+        "2bit size=1024,4096,16384 loop=64",
+        "gshare size=1024,4096,16384 loop=64",
+    };
+    double DSE_PRUNE_MARGIN = 0.5;          // percentage points a sampled estimate must lose by
+    size_t DSE_SAMPLE_BRANCHES = 1000000;   // prefix sampled when a trace has no simpoints
+
     // useing for traces analysis
     std::vector<std::string> ORIGINAL_TRACES = {
         "../trace/bwaves.out",
@@ -26,4 +60,38 @@ inline struct Config
         "../trace/wrf.out",
         "../trace/xz.out",        
     };
+
+    // depth of the PC / taken patterns in the trace analysis (1-32)
+    size_t PATTERN_HISTORY_LENGTH = 4;
+
+    // global / local history lengths of the predictability bounds (0 = per-PC bias only)
+    std::vector<size_t> PREDICTABILITY_HISTORIES = {0, 4, 8, 16};
+
+    // reuse distance of table indices (pc & (2^bits - 1)) and working-set interval length
+    size_t REUSE_INDEX_BITS = 12;
+    size_t WORKING_SET_INTERVAL = 100000;
+
+    // simpoint selection and weighted evaluation
+    std::string SIMPOINT_DIR = "results/simpoints";
+    size_t SIMPOINT_WARMUP = 50000;     // branches simulated before each simpoint to warm predictor state
+
+    // node-wide shared cache of decoded traces (enabled with --shm-cache)
+    bool SHM_TRACE_CACHE = false;
+    std::string SHM_CACHE_DIR = "/dev/shm";
+
+    // asynchronous trace reads (enabled with --async-io), see utils/async_reader.hpp
+    bool ASYNC_TRACE_IO = false;
+    size_t ASYNC_QUEUE_DEPTH = 8;           // reads in flight
+    size_t ASYNC_BUFFER_SIZE = 1 << 20;     // bytes per read
+    bool ASYNC_DIRECT_IO = false;           // O_DIRECT, bypassing the page cache (--direct-io)
+
+    // columnar binary copies of the result tables (enabled with --columnar), see utils/columnar.hpp
+    bool COLUMNAR_RESULTS = false;
+    size_t COLUMNAR_BATCH_ROWS = 65536;     // rows per record batch
+
+    // per-predictor summaries printed by the evaluators (off in parallel runs)
+    bool EVALUATION_LOG = true;
+
+    // live progress reporting (--progress / --telemetry FILE)
+    double TELEMETRY_INTERVAL = 5.0;    // seconds between reports
 } config;
@@ -0,0 +1,253 @@
+# pragma once
+
+#include "predictor/factory.hpp"
+#include "utils/experiment.hpp"
+#include "utils/simpoint.hpp"
+#include "utils/utils.hpp"
+#include "utils/config.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <iomanip>
+#include <cstdint>
+
+// ==== design-space exploration ====
+// Every predictor spec of the search space within the storage budget is a
+// design point. Points are first estimated on a sample of the trace (its
+// simpoints if trace-simpoint produced them, otherwise a prefix); a point is
+// pruned when another one needs no more storage and its estimate is better
+// by more than the margin. The survivors are simulated on the full trace
+// (through the result cache) and reduced to the accuracy-vs-storage Pareto
+// frontier. Points are evaluated on a pool of threads.
+
+struct DesignPoint {
+    PredictorSpec spec;
+    std::string name;
+    uint64_t storageBits = 0;
+    double sampledRate = -1.0;          // sample estimate in percent, < 0 if not sampled
+    bool pruned = false;
+    size_t totalBranches = 0;
+    size_t mispredictions = 0;
+    bool cached = false;
+    bool pareto = false;
+
+    double mispredictionRate() const {
+        return (totalBranches > 0) ? (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
+    }
+};
+
+struct DseOptions {
+    std::vector<PredictorSpec> space;
+    uint64_t budget = 0;                // storage bits, 0 = unlimited
+    size_t threads = std::max(1u, std::thread::hardware_concurrency());
+    bool prune = true;
+    double margin = config.DSE_PRUNE_MARGIN;
+    std::string simPointDir = config.SIMPOINT_DIR;
+    size_t warmup = config.SIMPOINT_WARMUP;
+    size_t sampleBranches = config.DSE_SAMPLE_BRANCHES;
+    std::string cacheDir = config.RESULT_CACHE_DIR;     // empty = no cache
+    std::string outputDir = "results";
+};
+
+// Run fn(i) for every i in [0, n) on a pool of threads taking the next index as they finish.
+// The first exception stops handing out indices and is rethrown once all threads joined.
+template <typename Fn>
+void parallelForEach(size_t n, size_t threads, Fn fn) {
+    threads = std::max<size_t>(1, std::min(threads, n));
+    std::atomic<size_t> next(0);
+    std::mutex mutex;
+    std::exception_ptr failure;
+    auto worker = [&]() {
+        try {
+            // tables are allocated by the worker creating the predictor, keep it on their node
+            if (tableMemory.numaLocal) pinThreadToLocalNode();
+            for (size_t i = next++; i < n; i = next++) fn(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!failure) failure = std::current_exception();
+            next = n;
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; t++) workers.emplace_back(worker);
+    worker();
+    for (auto& thread : workers) thread.join();
+    if (failure) std::rethrow_exception(failure);
+}
+
+// Misprediction estimate in percent from the simpoints, or from a prefix if there are none
+inline double estimateDesignPoint(BranchPredictor& predictor, const std::string& traceFile,
+                                  const std::vector<SimPoint>& points, const DseOptions& options) {
+    if (!points.empty()) {
+        return estimateAnyWithSimPoints(predictor, traceFile, points, options.warmup).mispredictionRate;
+    }
+    std::vector<size_t> result = evaluateAnyPredictor(predictor, traceFile, options.sampleBranches);
+    return (result[0] > 0) ? (static_cast<double>(result[1]) / result[0]) * 100.0 : 0.0;
+}
+
+// Prune points whose estimate loses by more than margin to a point needing no more storage
+inline void pruneDominated(std::vector<DesignPoint>& points, double margin) {
+    for (DesignPoint& point : points) {
+        for (const DesignPoint& other : points) {
+            if (&other != &point && other.storageBits <= point.storageBits &&
+                other.sampledRate + margin < point.sampledRate) {
+                point.pruned = true;
+                break;
+            }
+        }
+    }
+}
+
+// Mark the simulated points no other point beats with less or equal storage
+inline void markParetoFrontier(std::vector<DesignPoint>& points) {
+    std::vector<DesignPoint*> simulated;
+    for (DesignPoint& point : points) {
+        if (!point.pruned) simulated.push_back(&point);
+    }
+    std::sort(simulated.begin(), simulated.end(), [](const DesignPoint* a, const DesignPoint* b) {
+        if (a->storageBits != b->storageBits) return a->storageBits < b->storageBits;
+        return a->mispredictionRate() < b->mispredictionRate();
+    });
+    double best = 101.0;
+    for (DesignPoint* point : simulated) {
+        if (point->mispredictionRate() < best) {
+            point->pareto = true;
+            best = point->mispredictionRate();
+        }
+    }
+}
+
+// Explore the design space on one trace
+inline std::vector<DesignPoint> exploreTrace(const std::string& traceFile, const DseOptions& options,
+                                             ResultCache* cache) {
+    std::string traceName = getTraceBaseName(traceFile);
+    std::vector<DesignPoint> points;
+    for (const PredictorSpec& spec : options.space) {
+        std::unique_ptr<BranchPredictor> predictor = createPredictor(spec);
+        if (options.budget > 0 && predictor->storageBits() > options.budget) continue;
+        DesignPoint point;
+        point.spec = spec;
+        point.name = predictor->getName();
+        point.storageBits = predictor->storageBits();
+        points.push_back(point);
+    }
+    std::mutex mutex;       // guards the cache and the console
+
+    if (options.prune && points.size() > 1) {
+        std::vector<SimPoint> simPoints;
+        std::string simPointPath = simPointFile(options.simPointDir, traceName);
+        if (std::filesystem::exists(simPointPath)) simPoints = loadSimPoints(simPointPath);
+        std::cout << "Sampling " << points.size() << " design points on "
+                  << (simPoints.empty() ? "a prefix of " + std::to_string(options.sampleBranches) + " branches"
+                                        : std::to_string(simPoints.size()) + " simpoints") << std::endl;
+
+        parallelForEach(points.size(), options.threads, [&](size_t i) {
+            std::unique_ptr<BranchPredictor> predictor = createPredictor(points[i].spec);
+            points[i].sampledRate = estimateDesignPoint(*predictor, traceFile, simPoints, options);
+        });
+        pruneDominated(points, options.margin);
+    }
+
+    std::string traceHash = cache ? cache->traceHash(traceFile) : "";
+    size_t survivors = std::count_if(points.begin(), points.end(), [](const DesignPoint& p) { return !p.pruned; });
+    std::cout << "Simulating " << survivors << " of " << points.size() << " design points on the full trace" << std::endl;
+
+    parallelForEach(points.size(), options.threads, [&](size_t i) {
+        DesignPoint& point = points[i];
+        if (point.pruned) return;
+        std::string key = cache ? ResultCache::jobKey(traceHash, point.spec, 0) : "";
+        if (cache) {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (const JobResult* cached = cache->find(key)) {
+                point.totalBranches = cached->totalBranches;
+                point.mispredictions = cached->mispredictions;
+                point.cached = true;
+                return;
+            }
+        }
+        std::unique_ptr<BranchPredictor> predictor = createPredictor(point.spec);
+        ClassCounts classes;
+        std::vector<size_t> result = evaluateAnyPredictor(*predictor, traceFile, 0, BranchFilter(), &classes);
+        point.totalBranches = result[0];
+        point.mispredictions = result[1];
+
+        std::lock_guard<std::mutex> guard(mutex);
+        std::cout << "  " << point.name << ": " << std::fixed << std::setprecision(2)
+                  << point.mispredictionRate() << "%" << std::endl;
+        if (cache) {
+            JobResult jobResult;
+            jobResult.predictorName = point.name;
+            jobResult.totalBranches = point.totalBranches;
+            jobResult.mispredictions = point.mispredictions;
+            jobResult.classes = classes;
+            jobResult.hasClasses = true;
+            cache->store(key, traceHash, point.spec, 0, jobResult);
+        }
+    });
+
+    markParetoFrontier(points);
+    return points;
+}
+
+// Explore every trace, writing all points to dse_points.csv and the frontiers to dse_pareto.csv
+inline void runDesignSpaceExploration(const std::vector<std::string>& traceFiles, const DseOptions& options) {
+    std::string pointsFile = options.outputDir + "/dse_points.csv";
+    std::string paretoFile = options.outputDir + "/dse_pareto.csv";
+    std::ofstream pointsCsv(pointsFile), paretoCsv(paretoFile);
+    if (!pointsCsv.is_open() || !paretoCsv.is_open()) {
+        std::cerr << "Error: Could not open CSV files in " << options.outputDir << std::endl;
+        return;
+    }
+    pointsCsv << "TraceFile,Spec,Predictor,StorageBits,SampledMispredictionRate,Pruned,"
+              << "TotalBranches,Mispredictions,MispredictionRate,Pareto\n";
+    paretoCsv << "TraceFile,Spec,Predictor,StorageBits,MispredictionRate\n";
+
+    std::unique_ptr<ResultCache> cache;
+    if (!options.cacheDir.empty()) cache = std::make_unique<ResultCache>(options.cacheDir);
+
+    for (const std::string& traceFile : traceFiles) {
+        std::string traceName = getTraceBaseName(traceFile);
+        std::cout << "Design-space exploration of " << traceFile << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<DesignPoint> points = exploreTrace(traceFile, options, cache.get());
+
+        std::vector<const DesignPoint*> frontier;
+        for (const DesignPoint& point : points) {
+            pointsCsv << traceName << "," << point.spec.toString() << "," << point.name << ","
+                      << point.storageBits << ",";
+            if (point.sampledRate >= 0) pointsCsv << std::fixed << std::setprecision(2) << point.sampledRate;
+            pointsCsv << "," << (point.pruned ? 1 : 0) << ",";
+            if (!point.pruned) {
+                pointsCsv << point.totalBranches << "," << point.mispredictions << ","
+                          << std::fixed << std::setprecision(2) << point.mispredictionRate();
+            } else {
+                pointsCsv << ",,";
+            }
+            pointsCsv << "," << (point.pareto ? 1 : 0) << "\n";
+            if (point.pareto) frontier.push_back(&point);
+        }
+        std::sort(frontier.begin(), frontier.end(),
+                  [](const DesignPoint* a, const DesignPoint* b) { return a->storageBits < b->storageBits; });
+
+        std::cout << "Pareto frontier:" << std::endl;
+        for (const DesignPoint* point : frontier) {
+            paretoCsv << traceName << "," << point->spec.toString() << "," << point->name << ","
+                      << point->storageBits << "," << std::fixed << std::setprecision(2)
+                      << point->mispredictionRate() << "\n";
+            std::cout << "  " << std::setw(10) << point->storageBits << " bits  "
+                      << std::setw(6) << point->mispredictionRate() << "%  " << point->name << std::endl;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "(" << std::setprecision(2) << seconds << "s)" << std::endl << std::endl;
+    }
+    std::cout << "Design points written to " << pointsFile << ", frontiers to " << paretoFile << std::endl;
+}
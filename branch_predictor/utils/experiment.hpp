@@ -0,0 +1,582 @@
+# pragma once
+
+#include "predictor/factory.hpp"
+#include "utils/utils.hpp"
+#include "utils/hash.hpp"
+#include "utils/columnar.hpp"
+#include "utils/config.hpp"
+#include "utils/perf_counters.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <filesystem>
+#include <stdexcept>
+#include <iomanip>
+
+#include <sys/stat.h>
+
+// ==== experiment matrix ====
+// An experiment file lists traces and predictor specs; every (trace,
+// predictor) pair is one job. Parameter values may be comma separated lists,
+// which expand to one predictor per combination:
+//
+//   # lines starting with # are comments
+//   trace = trace/gcc_cutted.out trace/leela_cutted.out
+//   predictor = always_taken
+//   predictor = 2bit size=512,1024,2048,4096
+//   predictor = gshare size=2048
+//   max_lines = 0
+//   filter = conditional         (see utils/branch_filter.hpp, default all)
+//   output = results/results_predict.csv
+//   cache = results/cache        (or off)
+
+// Bump when a predictor's behaviour changes, so cached results are not reused
+const char* const RESULT_CACHE_VERSION = "1";
+
+struct Experiment {
+    std::vector<std::string> traces;
+    std::vector<PredictorSpec> predictors;
+    size_t maxLines = 0;
+    BranchFilter filter;                                // records fed to the predictors
+    std::string output = "results/results_predict.csv";
+    std::string cacheDir = config.RESULT_CACHE_DIR;     // empty = no cache
+    size_t shardIndex = 0;                              // run only jobs with index % shardCount == shardIndex
+    size_t shardCount = 1;
+};
+
+struct Job {
+    size_t index;               // position in the full job matrix
+    std::string trace;
+    PredictorSpec predictor;
+};
+
+struct JobResult {
+    std::string predictorName;
+    size_t totalBranches = 0;
+    size_t mispredictions = 0;
+    ClassCounts classes;
+    bool hasClasses = false;    // false for results cached before per-class counts
+    bool cached = false;
+
+    double mispredictionRate() const {
+        return (totalBranches > 0) ? (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
+    }
+};
+
+inline std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+inline std::vector<std::string> splitList(const std::string& text, char separator) {
+    std::vector<std::string> items;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, separator)) {
+        item = trim(item);
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+// "2bit size=512,1024" -> "2bit size=512", "2bit size=1024"; earlier parameters vary slowest
+inline std::vector<PredictorSpec> expandPredictorSpecs(const std::string& line) {
+    std::vector<std::string> tokens = splitList(line, ' ');
+    if (tokens.empty()) throw std::invalid_argument("Empty predictor spec");
+    std::vector<std::string> specs = {tokens[0]};
+    for (size_t t = 1; t < tokens.size(); t++) {
+        size_t eq = tokens[t].find('=');
+        if (eq == std::string::npos) throw std::invalid_argument("Expected key=value in predictor spec, got " + tokens[t]);
+        std::string key = tokens[t].substr(0, eq);
+        std::vector<std::string> expanded;
+        for (const std::string& spec : specs) {
+            for (const std::string& value : splitList(tokens[t].substr(eq + 1), ',')) {
+                expanded.push_back(spec + " " + key + "=" + value);
+            }
+        }
+        specs.swap(expanded);
+    }
+    std::vector<PredictorSpec> predictors;
+    for (const std::string& spec : specs) predictors.push_back(PredictorSpec::parse(spec));
+    return predictors;
+}
+
+inline Experiment loadExperiment(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open experiment file " << path << std::endl;
+        throw std::runtime_error("File not found");
+    }
+    Experiment experiment;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) continue;
+        try {
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) throw std::invalid_argument("expected key = value");
+            std::string key = trim(line.substr(0, eq));
+            std::string value = trim(line.substr(eq + 1));
+            if (key == "trace" || key == "traces") {
+                for (const std::string& trace : splitList(value, ' ')) experiment.traces.push_back(trace);
+            } else if (key == "predictor") {
+                for (const PredictorSpec& spec : expandPredictorSpecs(value)) experiment.predictors.push_back(spec);
+            } else if (key == "max_lines") {
+                experiment.maxLines = std::stoull(value);
+            } else if (key == "filter") {
+                experiment.filter = BranchFilter::parse(value);
+            } else if (key == "output") {
+                experiment.output = value;
+            } else if (key == "cache") {
+                experiment.cacheDir = (value == "off") ? "" : value;
+            } else {
+                throw std::invalid_argument("unknown key " + key);
+            }
+        } catch (const std::exception& e) {
+            throw std::runtime_error(path + ":" + std::to_string(lineNumber) + ": " + e.what());
+        }
+    }
+    return experiment;
+}
+
+// Jobs in trace-major order, the order of the result CSV
+inline std::vector<Job> expandJobs(const Experiment& experiment) {
+    std::vector<Job> jobs;
+    for (const std::string& trace : experiment.traces) {
+        for (const PredictorSpec& predictor : experiment.predictors) {
+            jobs.push_back({jobs.size(), trace, predictor});
+        }
+    }
+    return jobs;
+}
+
+
+// ==== result cache ====
+// results.csv in the cache directory holds one line per finished job, keyed
+// by the hash of (cache version, trace content hash, canonical spec, max
+// lines, branch filter if any), with the per-class counts in a last column
+// (missing in lines written before them). Lines are appended as jobs finish, so interrupted runs keep their
+// progress. Trace content hashes are memoised in trace_hashes.csv by path,
+// size and modification time, so unchanged traces are not re-read.
+class ResultCache {
+private:
+    struct TraceStamp {
+        uint64_t size;
+        int64_t mtime;
+        std::string hash;
+    };
+
+    std::string dir;
+    std::unordered_map<std::string, JobResult> results;
+    std::map<std::string, TraceStamp> traceHashes;
+
+public:
+    explicit ResultCache(const std::string& directory) : dir(directory) {
+        std::filesystem::create_directories(dir);
+
+        std::ifstream resultsFile(dir + "/results.csv");
+        std::string line;
+        while (std::getline(resultsFile, line)) {
+            std::vector<std::string> fields;
+            std::stringstream ss(line);
+            std::string field;
+            while (std::getline(ss, field, ',')) fields.push_back(field);
+            if (fields.size() < 7 || fields.size() > 8 || fields[0] == "Key") continue;
+            JobResult result;
+            result.predictorName = fields[4];
+            result.totalBranches = std::stoull(fields[5]);
+            result.mispredictions = std::stoull(fields[6]);
+            result.hasClasses = fields.size() == 8 && ClassCounts::decode(fields[7], result.classes);
+            result.cached = true;
+            results[fields[0]] = result;
+        }
+
+        std::ifstream hashesFile(dir + "/trace_hashes.csv");
+        while (std::getline(hashesFile, line)) {
+            size_t c3 = line.rfind(','), c2 = line.rfind(',', c3 - 1), c1 = line.rfind(',', c2 - 1);
+            if (c1 == std::string::npos || c2 == std::string::npos || c3 == std::string::npos) continue;
+            if (line.compare(0, c1, "Path") == 0) continue;
+            traceHashes[line.substr(0, c1)] = {std::stoull(line.substr(c1 + 1, c2 - c1 - 1)),
+                                               std::stoll(line.substr(c2 + 1, c3 - c2 - 1)),
+                                               line.substr(c3 + 1)};
+        }
+    }
+
+    // Content hash of a trace, recomputed only when its size or mtime changed
+    std::string traceHash(const std::string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            std::cerr << "Error: Could not open file " << path << std::endl;
+            throw std::runtime_error("File not found");
+        }
+        int64_t mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+        auto it = traceHashes.find(path);
+        if (it != traceHashes.end() && it->second.size == static_cast<uint64_t>(st.st_size) && it->second.mtime == mtime) {
+            return it->second.hash;
+        }
+        std::string hash = hashToHex(hashFile(path));
+        traceHashes[path] = {static_cast<uint64_t>(st.st_size), mtime, hash};
+
+        bool fresh = !std::filesystem::exists(dir + "/trace_hashes.csv");
+        std::ofstream out(dir + "/trace_hashes.csv", std::ios::app);
+        if (fresh) out << "Path,Size,MTime,Hash\n";
+        out << path << "," << st.st_size << "," << mtime << "," << hash << "\n";
+        return hash;
+    }
+
+    static std::string jobKey(const std::string& traceHash, const PredictorSpec& spec, size_t maxLines,
+                              const BranchFilter& filter = BranchFilter()) {
+        std::string filterKey = filter.empty() ? "" : "|" + filter.key();
+        return hashToHex(hashString(std::string(RESULT_CACHE_VERSION) + "|" + traceHash + "|" +
+                                    spec.toString() + "|" + std::to_string(maxLines) + filterKey));
+    }
+
+    const JobResult* find(const std::string& key) const {
+        auto it = results.find(key);
+        return (it == results.end()) ? nullptr : &it->second;
+    }
+
+    void store(const std::string& key, const std::string& traceHash, const PredictorSpec& spec,
+               size_t maxLines, const JobResult& result) {
+        results[key] = result;
+        results[key].cached = true;
+        bool fresh = !std::filesystem::exists(dir + "/results.csv");
+        std::ofstream out(dir + "/results.csv", std::ios::app);
+        if (fresh) out << "Key,TraceHash,Spec,MaxLines,Predictor,TotalBranches,Mispredictions,Classes\n";
+        out << key << "," << traceHash << "," << spec.toString() << "," << maxLines << ","
+            << result.predictorName << "," << result.totalBranches << "," << result.mispredictions;
+        if (result.hasClasses) out << "," << result.classes.encode();
+        out << "\n";
+    }
+};
+
+
+// ==== job execution ====
+
+// Evaluate any predictor, profiled predictors get their profiling pass first
+inline std::vector<size_t> evaluateAnyPredictor(BranchPredictor& predictor, const std::string& traceFile, size_t maxLines,
+                                                const BranchFilter& filter = BranchFilter(),
+                                                ClassCounts* classes = nullptr) {
+    if (auto* profiled = dynamic_cast<ProfiledPredictor*>(&predictor)) {
+        return evaluateProfiledPredictor(*profiled, traceFile, maxLines, filter, classes);
+    } else if (auto* profiled2Bit = dynamic_cast<Profiled2BitPredictor*>(&predictor)) {
+        return evaluateProfiled2BitPredictor(*profiled2Bit, traceFile, maxLines, filter, classes);
+    }
+    return evaluatePredictor(predictor, traceFile, maxLines, filter, classes);
+}
+
+// Simulate one job
+inline JobResult simulateJob(const Job& job, size_t maxLines, const BranchFilter& filter = BranchFilter()) {
+    std::unique_ptr<BranchPredictor> predictor = createPredictor(job.predictor);
+    std::cout << "Evaluating " << predictor->getName() << " predictor..." << std::endl;
+    JobResult jobResult;
+    std::vector<size_t> result = evaluateAnyPredictor(*predictor, job.trace, maxLines, filter, &jobResult.classes);
+    jobResult.predictorName = predictor->getName();
+    jobResult.totalBranches = result[0];
+    jobResult.mispredictions = result[1];
+    jobResult.hasClasses = true;
+    return jobResult;
+}
+
+// Look a job up in the cache (if any), simulating and storing it on a miss.
+// Cached results without per-class counts are simulated again.
+inline JobResult runJob(const Job& job, size_t maxLines, ResultCache* cache, const BranchFilter& filter = BranchFilter()) {
+    if (!cache) return simulateJob(job, maxLines, filter);
+    std::string traceHash = cache->traceHash(job.trace);
+    std::string key = ResultCache::jobKey(traceHash, job.predictor, maxLines, filter);
+    const JobResult* cached = cache->find(key);
+    if (cached && cached->hasClasses) {
+        std::cout << "Cached " << cached->predictorName << " predictor" << std::endl;
+        return *cached;
+    }
+    JobResult result = simulateJob(job, maxLines, filter);
+    cache->store(key, traceHash, job.predictor, maxLines, result);
+    return result;
+}
+
+// ==== sharding ====
+// "--shard i/N" runs the jobs whose matrix index is i modulo N (0 <= i < N),
+// so N processes on any number of machines split the matrix without talking
+// to each other. Round robin spreads every trace's jobs over all shards.
+// Each shard writes <output>.shard-i-of-N.csv with the job index and spec in
+// front of the regular columns; mergeShardResults reassembles the canonical
+// CSV and fails on missing or duplicate jobs.
+
+const char* const RESULTS_HEADER = "TraceFile,Predictor,TotalBranches,Mispredictions,MispredictionRate";
+const char* const CLASS_RESULTS_HEADER = "TraceFile,Predictor,Class,TotalBranches,Mispredictions,MispredictionRate";
+
+inline void parseShard(const std::string& text, size_t& index, size_t& count) {
+    size_t slash = text.find('/');
+    if (slash == std::string::npos) throw std::invalid_argument("Expected --shard i/N, got " + text);
+    index = std::stoull(text.substr(0, slash));
+    count = std::stoull(text.substr(slash + 1));
+    if (count == 0 || index >= count) {
+        throw std::invalid_argument("Shard index must be in [0, N), got " + text);
+    }
+}
+
+// Per-class table next to the results CSV (results/x.csv -> results/x_classes.csv)
+inline std::string classOutputPath(const std::string& output) {
+    if (output.size() >= 4 && output.compare(output.size() - 4, 4, ".csv") == 0) {
+        return output.substr(0, output.size() - 4) + "_classes.csv";
+    }
+    return output + "_classes.csv";
+}
+
+inline std::string shardOutputPath(const std::string& output, size_t index, size_t count) {
+    std::string suffix = ".shard-" + std::to_string(index) + "-of-" + std::to_string(count) + ".csv";
+    if (output.size() >= 4 && output.compare(output.size() - 4, 4, ".csv") == 0) {
+        return output.substr(0, output.size() - 4) + suffix;
+    }
+    return output + suffix;
+}
+
+// Perf counter table in the directory of the results CSV, one per shard
+// (results/x.csv -> results/perf_counters.csv or results/perf_counters.shard-i-of-N.csv)
+inline std::string perfOutputPath(const Experiment& experiment) {
+    std::string path = (std::filesystem::path(experiment.output).parent_path() / "perf_counters.csv").string();
+    if (experiment.shardCount <= 1) return path;
+    return shardOutputPath(path, experiment.shardIndex, experiment.shardCount);
+}
+
+// Per-class shard file of a results shard file
+// (results/x.shard-i-of-N.csv -> results/x_classes.shard-i-of-N.csv)
+inline std::string classShardPath(const std::string& shardFile) {
+    size_t shard = shardFile.rfind(".shard-");
+    if (shard == std::string::npos) return classOutputPath(shardFile);
+    return shardFile.substr(0, shard) + "_classes" + shardFile.substr(shard);
+}
+
+// Read "JobIndex,JobCount,Spec,<row>" shard rows into rows[job index], each
+// job having rowsPerJob rows from a single shard file; returns false (after
+// reporting) on malformed rows, missing or duplicate jobs
+inline bool collectShardRows(const std::vector<std::string>& shardFiles, size_t rowsPerJob,
+                             std::vector<std::vector<std::string>>& rows) {
+    size_t jobCount = 0;
+    std::vector<std::string> sources;       // shard file each job came from
+    bool ok = true;
+
+    for (const std::string& path : shardFiles) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open shard file " << path << std::endl;
+            return false;
+        }
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(file, line)) {
+            lineNumber++;
+            if (lineNumber == 1) continue;      // header
+            if (line.empty()) continue;
+            size_t c1 = line.find(','), c2 = line.find(',', c1 + 1), c3 = line.find(',', c2 + 1);
+            if (c3 == std::string::npos) {
+                std::cerr << "Error: " << path << ":" << lineNumber << ": malformed shard row" << std::endl;
+                return false;
+            }
+            size_t index = std::stoull(line.substr(0, c1));
+            size_t count = std::stoull(line.substr(c1 + 1, c2 - c1 - 1));
+            if (jobCount == 0) {
+                jobCount = count;
+                rows.assign(jobCount, {});
+                sources.resize(jobCount);
+            }
+            if (count != jobCount || index >= jobCount) {
+                std::cerr << "Error: " << path << ":" << lineNumber << ": job " << index << " of " << count
+                          << " does not belong to a matrix of " << jobCount << " jobs" << std::endl;
+                return false;
+            }
+            if ((!sources[index].empty() && sources[index] != path) || rows[index].size() >= rowsPerJob) {
+                std::cerr << "Error: duplicate job " << index << " (" << line.substr(c2 + 1, c3 - c2 - 1)
+                          << ") in " << sources[index] << " and " << path << std::endl;
+                ok = false;
+                continue;
+            }
+            rows[index].push_back(line.substr(c3 + 1));
+            sources[index] = path;
+        }
+    }
+
+    if (jobCount == 0) {
+        std::cerr << "Error: no jobs in the shard files" << std::endl;
+        return false;
+    }
+    size_t missing = 0;
+    for (size_t i = 0; i < jobCount; i++) {
+        if (rows[i].size() != rowsPerJob) {
+            if (missing < 10) std::cerr << "Error: missing job " << i << std::endl;
+            missing++;
+        }
+    }
+    if (missing > 0) {
+        std::cerr << "Error: " << missing << " of " << jobCount << " jobs missing" << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+// Merge shard files into the canonical results CSV, and their per-class
+// shard files into the per-class CSV; returns false (and writes nothing) if
+// any job is missing, duplicated or the shards disagree
+inline bool mergeShardResults(const std::vector<std::string>& shardFiles, const std::string& output) {
+    std::vector<std::vector<std::string>> rows, classRows;
+    if (!collectShardRows(shardFiles, 1, rows)) return false;
+
+    // shards list every class of every job, empty classes are dropped here
+    std::vector<std::string> classFiles;
+    for (const std::string& path : shardFiles) {
+        if (std::filesystem::exists(classShardPath(path))) classFiles.push_back(classShardPath(path));
+    }
+    if (!classFiles.empty() && classFiles.size() != shardFiles.size()) {
+        std::cerr << "Error: only " << classFiles.size() << " of " << shardFiles.size()
+                  << " shard files have a per-class file" << std::endl;
+        return false;
+    }
+    if (!classFiles.empty()) {
+        if (!collectShardRows(classFiles, BRANCH_CLASSES, classRows)) return false;
+        if (classRows.size() != rows.size()) {
+            std::cerr << "Error: per-class shard files hold " << classRows.size() << " jobs, expected "
+                      << rows.size() << std::endl;
+            return false;
+        }
+    }
+
+    std::ofstream csv(output);
+    if (!csv.is_open()) {
+        std::cerr << "Error: Could not open CSV file " << output << std::endl;
+        return false;
+    }
+    csv << RESULTS_HEADER << "\n";
+    for (const auto& job : rows) csv << job[0] << "\n";
+    csv.close();
+    std::cout << "Merged " << rows.size() << " jobs from " << shardFiles.size() << " shard files into " << output << std::endl;
+
+    if (classFiles.empty()) return true;
+    std::string classOutput = classOutputPath(output);
+    std::ofstream classCsv(classOutput);
+    if (!classCsv.is_open()) {
+        std::cerr << "Error: Could not open CSV file " << classOutput << std::endl;
+        return false;
+    }
+    classCsv << CLASS_RESULTS_HEADER << "\n";
+    for (const auto& job : classRows) {
+        for (const std::string& row : job) {
+            // TraceFile,Predictor,Class,TotalBranches,...
+            size_t c3 = row.find(',', row.find(',', row.find(',') + 1) + 1);
+            if (row.compare(c3 + 1, 2, "0,") != 0) classCsv << row << "\n";
+        }
+    }
+    classCsv.close();
+    std::cout << "Merged per-class results into " << classOutput << std::endl;
+    return true;
+}
+
+
+// Run every job of the experiment (or of its shard) and write the results CSV
+// and the misprediction rates per branch class
+inline void runExperiment(const Experiment& experiment) {
+    bool sharded = experiment.shardCount > 1;
+    std::string output = sharded ? shardOutputPath(experiment.output, experiment.shardIndex, experiment.shardCount)
+                                 : experiment.output;
+    std::ofstream csv(output);
+    if (!csv.is_open()) {
+        std::cerr << "Error: Could not open CSV file " << output << std::endl;
+        return;
+    }
+    csv << (sharded ? "JobIndex,JobCount,Spec," : "") << RESULTS_HEADER << "\n";
+
+    // shards list every class of a job, so merging can check that none is missing
+    std::string classOutput = sharded ? classShardPath(output) : classOutputPath(output);
+    std::ofstream classCsv(classOutput);
+    if (!classCsv.is_open()) std::cerr << "Error: Could not open CSV file " << classOutput << std::endl;
+    else classCsv << (sharded ? "JobIndex,JobCount,Spec," : "") << CLASS_RESULTS_HEADER << "\n";
+
+    std::unique_ptr<ResultCache> cache;
+    if (!experiment.cacheDir.empty()) cache = std::make_unique<ResultCache>(experiment.cacheDir);
+
+    std::vector<Job> jobs = expandJobs(experiment);
+    // the columnar copy always carries the job index, trace hash and spec
+    std::unique_ptr<ColumnarWriter> columnar = columnarFor(output, {
+        {"JobIndex", ColumnType::UInt64}, {"TraceFile", ColumnType::String}, {"TraceHash", ColumnType::String},
+        {"Spec", ColumnType::String}, {"Predictor", ColumnType::String}, {"TotalBranches", ColumnType::UInt64},
+        {"Mispredictions", ColumnType::UInt64}, {"MispredictionRate", ColumnType::Float64},
+    }, {
+        {"table", "predictor results"}, {"job_count", std::to_string(jobs.size())},
+        {"shard", std::to_string(experiment.shardIndex) + "/" + std::to_string(experiment.shardCount)},
+        {"max_lines", std::to_string(experiment.maxLines)}, {"filter", experiment.filter.toString()},
+    });
+    std::unique_ptr<ColumnarWriter> classColumnar = columnarFor(classOutput, {
+        {"JobIndex", ColumnType::UInt64}, {"TraceFile", ColumnType::String}, {"Predictor", ColumnType::String},
+        {"Class", ColumnType::String}, {"TotalBranches", ColumnType::UInt64}, {"Mispredictions", ColumnType::UInt64},
+        {"MispredictionRate", ColumnType::Float64},
+    }, {
+        {"table", "predictor results per branch class"}, {"filter", experiment.filter.toString()},
+    });
+
+    size_t simulated = 0, cached = 0;
+    std::string currentTrace, currentHash;
+    for (const Job& job : jobs) {
+        if (job.index % experiment.shardCount != experiment.shardIndex) continue;
+        if (job.trace != currentTrace) {
+            currentTrace = job.trace;
+            if (columnar) currentHash = cache ? cache->traceHash(job.trace) : hashToHex(hashFile(job.trace));
+            std::cout << "Branch Predictor Simulator" << std::endl;
+            std::cout << "=========================" << std::endl;
+            std::cout << "Trace file: " << job.trace << std::endl;
+            if (experiment.maxLines > 0) {
+                std::cout << "Max lines: " << experiment.maxLines << std::endl;
+            }
+            if (!experiment.filter.empty()) {
+                std::cout << "Filter: " << experiment.filter.toString() << std::endl;
+            }
+            std::cout << std::endl;
+        }
+
+        JobResult result = runJob(job, experiment.maxLines, cache.get(), experiment.filter);
+        (result.cached ? cached : simulated)++;
+
+        perfProfiler().enter(PerfPhase::Export);
+        if (sharded) csv << job.index << "," << jobs.size() << "," << job.predictor.toString() << ",";
+        csv << getTraceBaseName(job.trace) << ","
+            << result.predictorName << ","
+            << result.totalBranches << ","
+            << result.mispredictions << ","
+            << std::fixed << std::setprecision(2) << result.mispredictionRate() << "\n";
+        csv.flush();
+        if (columnar) {
+            columnar->row(job.index, getTraceBaseName(job.trace), currentHash, job.predictor.toString(),
+                          result.predictorName, result.totalBranches, result.mispredictions, result.mispredictionRate());
+        }
+        for (size_t c = 0; c < BRANCH_CLASSES; c++) {
+            if (result.classes.branches[c] == 0 && !sharded) continue;
+            if (classCsv.is_open()) {
+                if (sharded) classCsv << job.index << "," << jobs.size() << "," << job.predictor.toString() << ",";
+                classCsv << getTraceBaseName(job.trace) << "," << result.predictorName << "," << BRANCH_CLASS_NAMES[c] << ","
+                         << result.classes.branches[c] << "," << result.classes.mispredictions[c] << ","
+                         << std::fixed << std::setprecision(2) << result.classes.mispredictionRate(c) << "\n";
+            }
+            if (classColumnar && result.classes.branches[c] > 0) {
+                classColumnar->row(job.index, getTraceBaseName(job.trace), result.predictorName, BRANCH_CLASS_NAMES[c],
+                                   result.classes.branches[c], result.classes.mispredictions[c],
+                                   result.classes.mispredictionRate(c));
+            }
+        }
+    }
+    csv.close();
+    bool classesWritten = classCsv.is_open();
+    if (classesWritten) classCsv.close();
+    if (columnar) columnar->close();
+    if (classColumnar) classColumnar->close();
+    std::cout << simulated << " jobs simulated, " << cached << " taken from the result cache" << std::endl;
+    std::cout << "Results written to " << output << std::endl;
+    if (classesWritten) std::cout << "Per-class results written to " << classOutput << std::endl;
+    if (columnar) std::cout << "Columnar results written to " << columnarPath(output) << std::endl;
+}
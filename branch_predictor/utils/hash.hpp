@@ -0,0 +1,67 @@
+# pragma once
+
+#include "utils/trace_io.hpp"
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+// Final avalanche step (splitmix64)
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27; x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Fast non-cryptographic 64-bit content hash, four independent lanes over 32-byte blocks
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0) {
+    const uint64_t PRIME1 = 0x9E3779B185EBCA87ULL;
+    const uint64_t PRIME2 = 0xC2B2AE3D27D4EB4FULL;
+    const char* p = static_cast<const char*>(data);
+    const char* end = p + size;
+
+    uint64_t lanes[4] = {seed + PRIME1, seed ^ PRIME2, seed - PRIME1, ~seed};
+    while (end - p >= 32) {
+        for (int j = 0; j < 4; j++) {
+            uint64_t word;
+            std::memcpy(&word, p + 8 * j, 8);
+            lanes[j] = rotl64(lanes[j] + word * PRIME2, 31) * PRIME1;
+        }
+        p += 32;
+    }
+
+    uint64_t h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+    h ^= size * PRIME1;
+    while (end - p >= 8) {
+        uint64_t word;
+        std::memcpy(&word, p, 8);
+        h = rotl64(h ^ (word * PRIME2), 27) * PRIME1;
+        p += 8;
+    }
+    while (p < end) {
+        h = rotl64(h ^ (static_cast<uint8_t>(*p++) * PRIME1), 11) * PRIME2;
+    }
+    return mix64(h);
+}
+
+inline uint64_t hashString(const std::string& text, uint64_t seed = 0) {
+    return hashBytes(text.data(), text.size(), seed);
+}
+
+// Hash of a whole file's contents
+inline uint64_t hashFile(const std::string& path) {
+    MappedFile file(path);
+    return hashBytes(file.data(), file.size());
+}
+
+inline std::string hashToHex(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
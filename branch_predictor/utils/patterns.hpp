@@ -0,0 +1,107 @@
+# pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// ==== packed branch patterns ====
+// A pattern of up to 32 symbols is packed into a uint64_t, 2 bits per symbol,
+// most recent symbol in the lowest bits. Symbol codes start at 1 so that
+// patterns of different lengths never share a code (0 = no symbol).
+
+const size_t MAX_PATTERN_LENGTH = 32;
+
+// Patterns up to this length are counted in a direct-indexed array (4^8 entries)
+const size_t DIRECT_PATTERN_LENGTH = 8;
+
+// Symbol tables, indexed by code
+const char PC_PATTERN_SYMBOLS[4] = {'?', 'S', 'D', '?'};      // same / different PC
+const char TAKEN_PATTERN_SYMBOLS[4] = {'?', 'T', 'N', 'X'};   // taken / not taken / other PC
+
+const uint64_t PATTERN_SAME = 1, PATTERN_DIFFERENT = 2;
+const uint64_t PATTERN_TAKEN = 1, PATTERN_NOT_TAKEN = 2, PATTERN_OTHER = 3;
+
+inline std::string decodePattern(uint64_t code, const char symbols[4]) {
+    std::string pattern;
+    for (size_t i = 0; i < MAX_PATTERN_LENGTH; i++) {
+        unsigned symbol = (code >> (2 * i)) & 3;
+        if (symbol == 0) break;
+        pattern += symbols[symbol];
+    }
+    return pattern;
+}
+
+// Counts of packed patterns: direct-indexed for short patterns, otherwise an
+// open-addressing hash table with linear probing
+class PatternCounter {
+private:
+    bool directIndexed;
+    std::vector<size_t> direct;     // code -> count
+    std::vector<uint64_t> keys;     // hash table keys, 0 = empty slot
+    std::vector<size_t> counts;     // hash table counts
+    size_t used = 0;
+
+    static size_t slotOf(uint64_t code, size_t mask) {
+        return static_cast<size_t>((code * 0x9E3779B97F4A7C15ULL) >> 20) & mask;
+    }
+
+    void grow() {
+        std::vector<uint64_t> oldKeys(keys.size() * 2, 0);
+        std::vector<size_t> oldCounts(counts.size() * 2, 0);
+        oldKeys.swap(keys);
+        oldCounts.swap(counts);
+        size_t mask = keys.size() - 1;
+        for (size_t i = 0; i < oldKeys.size(); i++) {
+            if (oldKeys[i] == 0) continue;
+            size_t slot = slotOf(oldKeys[i], mask);
+            while (keys[slot] != 0) slot = (slot + 1) & mask;
+            keys[slot] = oldKeys[i];
+            counts[slot] = oldCounts[i];
+        }
+    }
+
+public:
+    explicit PatternCounter(size_t maxLength)
+        : directIndexed(maxLength <= DIRECT_PATTERN_LENGTH) {
+        if (directIndexed) {
+            direct.assign(size_t(1) << (2 * maxLength), 0);
+        } else {
+            keys.assign(1024, 0);
+            counts.assign(1024, 0);
+        }
+    }
+
+    void add(uint64_t code) {
+        if (directIndexed) {
+            direct[code]++;
+            return;
+        }
+        size_t mask = keys.size() - 1;
+        size_t slot = slotOf(code, mask);
+        while (keys[slot] != 0 && keys[slot] != code) slot = (slot + 1) & mask;
+        if (keys[slot] == 0) {
+            keys[slot] = code;
+            if (++used * 4 > keys.size() * 3) {
+                counts[slot]++;
+                grow();
+                return;
+            }
+        }
+        counts[slot]++;
+    }
+
+    // Visit every pattern seen at least once
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        if (directIndexed) {
+            for (size_t code = 0; code < direct.size(); code++) {
+                if (direct[code] > 0) fn(static_cast<uint64_t>(code), direct[code]);
+            }
+            return;
+        }
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (keys[i] != 0) fn(keys[i], counts[i]);
+        }
+    }
+};
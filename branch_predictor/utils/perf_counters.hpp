@@ -0,0 +1,228 @@
+# pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ==== host performance counters ====
+// Counters of the simulator process itself (user space only), opened with
+// perf_event_open as one group so they are read together with one read().
+// Events the host does not support are left out; on machines without a PMU
+// (most VMs and containers) only the task clock remains.
+
+enum PerfEvent {
+    PERF_TASK_CLOCK = 0,    // ns on a CPU
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_EVENT_COUNT
+};
+
+const char* const PERF_EVENT_NAMES[PERF_EVENT_COUNT] = {
+    "TaskClock_ns", "Cycles", "Instructions", "L1DMisses", "LLCMisses", "BranchMisses",
+};
+
+class PerfCounters {
+private:
+    int leader = -1;
+    std::vector<int> fds;
+    std::vector<PerfEvent> events;      // event of each opened counter, in group order
+
+    static int openEvent(uint32_t type, uint64_t eventConfig, int groupFd) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = eventConfig;
+        attr.disabled = (groupFd == -1);
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+    }
+
+public:
+    PerfCounters() {
+        const uint64_t l1dReadMiss = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                     (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        const struct { PerfEvent event; uint32_t type; uint64_t config; } wanted[PERF_EVENT_COUNT] = {
+            {PERF_TASK_CLOCK, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+            {PERF_CYCLES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_INSTRUCTIONS, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_L1D_MISSES, PERF_TYPE_HW_CACHE, l1dReadMiss},
+            {PERF_LLC_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_BRANCH_MISSES, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        };
+        for (const auto& event : wanted) {
+            int fd = openEvent(event.type, event.config, leader);
+            if (fd < 0) continue;
+            if (leader == -1) leader = fd;
+            fds.push_back(fd);
+            events.push_back(event.event);
+        }
+        if (leader != -1) {
+            ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    ~PerfCounters() {
+        for (int fd : fds) close(fd);
+    }
+
+    bool available() const { return leader != -1; }
+    bool has(PerfEvent event) const {
+        for (PerfEvent e : events) if (e == event) return true;
+        return false;
+    }
+
+    // Current counts since the group was enabled, scaled up if the kernel multiplexed it
+    void read(uint64_t* values) const {
+        std::fill(values, values + PERF_EVENT_COUNT, 0);
+        if (leader == -1) return;
+        uint64_t buffer[3 + PERF_EVENT_COUNT];
+        if (::read(leader, buffer, sizeof(buffer)) < static_cast<ssize_t>(3 * sizeof(uint64_t))) return;
+        uint64_t count = buffer[0], enabled = buffer[1], running = buffer[2];
+        double scale = (running > 0 && running < enabled) ? static_cast<double>(enabled) / running : 1.0;
+        for (size_t i = 0; i < count && i < events.size(); i++) {
+            values[events[i]] = static_cast<uint64_t>(buffer[3 + i] * scale);
+        }
+    }
+};
+
+// Evaluation phases counters are attributed to
+enum class PerfPhase { None, Parse, Profile, Predict, Analyze, Export };
+
+inline const char* perfPhaseName(PerfPhase phase) {
+    switch (phase) {
+        case PerfPhase::Parse:   return "parse";
+        case PerfPhase::Profile: return "profile";
+        case PerfPhase::Predict: return "predict";
+        case PerfPhase::Analyze: return "analyze";
+        case PerfPhase::Export:  return "export";
+        default:                 return "none";
+    }
+}
+
+// Attributes counter deltas to the (trace, job, phase) that was current when
+// they accrued. Phase switches cost one read() and do nothing while disabled.
+class PhaseProfiler {
+private:
+    struct Totals {
+        uint64_t values[PERF_EVENT_COUNT] = {};
+        double seconds = 0.0;
+    };
+    using Key = std::pair<std::string, std::string>;    // (trace, job)
+
+    bool enabled = false;
+    std::unique_ptr<PerfCounters> counters;
+    std::vector<Key> jobs;                              // in first-seen order
+    std::map<Key, std::map<PerfPhase, Totals>> totals;
+    Key currentJob;
+    PerfPhase currentPhase = PerfPhase::None;
+    uint64_t last[PERF_EVENT_COUNT] = {};
+    std::chrono::steady_clock::time_point lastTime;
+
+    void attribute() {
+        uint64_t now[PERF_EVENT_COUNT];
+        counters->read(now);
+        auto time = std::chrono::steady_clock::now();
+        if (currentPhase != PerfPhase::None) {
+            Totals& t = totals[currentJob][currentPhase];
+            for (size_t i = 0; i < PERF_EVENT_COUNT; i++) t.values[i] += now[i] - last[i];
+            t.seconds += std::chrono::duration<double>(time - lastTime).count();
+        }
+        std::copy(now, now + PERF_EVENT_COUNT, last);
+        lastTime = time;
+    }
+
+public:
+    void enable() {
+        if (enabled) return;
+        counters = std::make_unique<PerfCounters>();
+        if (!counters->available()) {
+            std::cerr << "Warning: perf_event_open is not available, only wall time is recorded" << std::endl;
+        } else if (!counters->has(PERF_CYCLES)) {
+            std::cerr << "Warning: no hardware counters on this host, only the task clock is recorded" << std::endl;
+        }
+        enabled = true;
+    }
+
+    bool isEnabled() const { return enabled; }
+
+    // Start attributing to a new job, in the phase None until enter()
+    void beginJob(const std::string& trace, const std::string& job) {
+        if (!enabled) return;
+        attribute();
+        currentJob = {trace, job};
+        currentPhase = PerfPhase::None;
+        if (totals.find(currentJob) == totals.end()) {
+            jobs.push_back(currentJob);
+            totals[currentJob];
+        }
+    }
+
+    void enter(PerfPhase phase) {
+        if (!enabled || phase == currentPhase) return;
+        attribute();
+        currentPhase = phase;
+    }
+
+    void endJob() { enter(PerfPhase::None); }
+
+    // One row per (trace, job, phase); counters the host lacks are left empty
+    void writeCSV(const std::string& csvFile) {
+        if (!enabled) return;
+        endJob();
+        std::ofstream csv(csvFile);
+        if (!csv.is_open()) {
+            std::cerr << "Error: Could not open CSV file " << csvFile << std::endl;
+            return;
+        }
+        csv << "TraceFile,Job,Phase,Seconds";
+        for (size_t i = 0; i < PERF_EVENT_COUNT; i++) csv << "," << PERF_EVENT_NAMES[i];
+        csv << ",IPC\n";
+        for (const Key& job : jobs) {
+            for (const auto& phase : totals[job]) {
+                const Totals& t = phase.second;
+                csv << job.first << "," << job.second << "," << perfPhaseName(phase.first) << ","
+                    << std::fixed << std::setprecision(6) << t.seconds;
+                for (size_t i = 0; i < PERF_EVENT_COUNT; i++) {
+                    csv << ",";
+                    if (counters->has(static_cast<PerfEvent>(i))) csv << t.values[i];
+                }
+                csv << ",";
+                if (t.values[PERF_CYCLES] > 0) {
+                    csv << std::setprecision(3) << static_cast<double>(t.values[PERF_INSTRUCTIONS]) / t.values[PERF_CYCLES];
+                }
+                csv << "\n";
+            }
+        }
+        csv.close();
+        std::cout << "Performance counters written to " << csvFile << std::endl;
+    }
+};
+
+// Process-wide profiler, enabled with --perf
+inline PhaseProfiler& perfProfiler() {
+    static PhaseProfiler profiler;
+    return profiler;
+}
@@ -0,0 +1,287 @@
+# pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+#include <cstddef>
+
+// ==== predictability upper bounds ====
+// For every conditional branch the outcome is counted per (PC, k-bit history)
+// context. From those counts we get, per static branch and in aggregate:
+//  - the empirical conditional entropy H(outcome | PC, history), in bits
+//  - the misprediction rate of an optimal table indexed by (PC, history),
+//    i.e. sum over contexts of min(taken, not taken); no predictor using only
+//    that information can do better on this trace
+
+const size_t MAX_PREDICTABILITY_HISTORY = 32;
+
+// Histories up to this length are counted in a direct-indexed table per PC
+// (2^k contexts each, 8 bytes per context), longer ones in a shared hash
+// table holding only the contexts that occur. With the default histories a
+// PC's direct table is 33 contexts, 264 bytes.
+const size_t DIRECT_PREDICTABILITY_HISTORY = 4;
+
+enum class HistoryKind { None, Global, Local };
+
+inline std::string historyKindName(HistoryKind kind) {
+    switch (kind) {
+        case HistoryKind::Global: return "global";
+        case HistoryKind::Local:  return "local";
+        default:                  return "none";
+    }
+}
+
+struct PredictabilityBound {
+    HistoryKind kind;
+    size_t bits;                        // history length k
+    double entropy = 0.0;               // bits per conditional branch
+    double mispredictionBound = 0.0;    // percent of conditional branches
+};
+
+struct BranchPredictability {
+    uint64_t pc;
+    size_t executions;
+    std::vector<PredictabilityBound> bounds;    // same order as the analyzer's configurations
+};
+
+// Binary entropy of a (taken, total) count, weighted by total
+inline double weightedEntropy(uint64_t taken, uint64_t total) {
+    if (taken == 0 || taken == total) return 0.0;
+    double p = static_cast<double>(taken) / total;
+    return -static_cast<double>(total) * (p * std::log2(p) + (1.0 - p) * std::log2(1.0 - p));
+}
+
+class PredictabilityAnalyzer {
+private:
+    struct Config {
+        HistoryKind kind;
+        size_t bits;
+        uint64_t mask;
+        size_t offset;      // first context of this config in a PC's direct table, or SIZE_MAX if hashed
+    };
+
+    // Packed counts of one context; a context whose total fills 32 bits is
+    // moved to an overflow map of 64-bit counts and restarts from zero
+    struct Counts {
+        uint32_t taken = 0;
+        uint32_t total = 0;
+    };
+
+    struct WideCounts {
+        uint64_t taken = 0;
+        uint64_t total = 0;
+    };
+
+    struct Entry {
+        uint64_t key = 0;
+        Counts counts;
+    };
+
+    std::vector<Config> configs;
+
+    // Direct tables of all PCs, directContexts entries per PC id
+    std::vector<Counts> direct;
+    size_t directContexts = 0;
+
+    // Spilled counts, by index into direct and by hash table key
+    std::unordered_map<size_t, WideCounts> directOverflow;
+    std::unordered_map<uint64_t, WideCounts> tableOverflow;
+
+    // Context table of the long histories, open addressing with linear probing.
+    // The key packs the context history in the low 32 bits and
+    // (pcId * configs + config + 1) in the high 32 bits, so 0 marks an empty slot.
+    std::vector<Entry> table;
+    size_t used = 0;
+
+    std::unordered_map<uint64_t, uint32_t> pcIds;   // PC -> dense id
+    std::vector<uint64_t> pcs;                      // dense id -> PC
+    std::vector<uint64_t> localHistory;             // dense id -> local history
+    uint64_t globalHistory = 0;
+    size_t conditionalBranches = 0;
+
+    template <typename Key>
+    static void add(Counts& counts, bool taken, std::unordered_map<Key, WideCounts>& overflow, Key key) {
+        if (counts.total == std::numeric_limits<uint32_t>::max()) {
+            WideCounts& wide = overflow[key];
+            wide.taken += counts.taken;
+            wide.total += counts.total;
+            counts = Counts();
+        }
+        counts.taken += taken;
+        counts.total++;
+    }
+
+    template <typename Key>
+    static WideCounts widen(const Counts& counts, const std::unordered_map<Key, WideCounts>& overflow, Key key) {
+        WideCounts wide{counts.taken, counts.total};
+        if (!overflow.empty()) {
+            auto it = overflow.find(key);
+            if (it != overflow.end()) wide.taken += it->second.taken, wide.total += it->second.total;
+        }
+        return wide;
+    }
+
+    static size_t slotOf(uint64_t key, size_t mask) {
+        return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 17) & mask;
+    }
+
+    void grow() {
+        std::vector<Entry> old(table.size() * 2);
+        old.swap(table);
+        size_t mask = table.size() - 1;
+        for (const Entry& entry : old) {
+            if (entry.key == 0) continue;
+            size_t slot = slotOf(entry.key, mask);
+            while (table[slot].key != 0) slot = (slot + 1) & mask;
+            table[slot] = entry;
+        }
+    }
+
+    void count(uint64_t key, bool taken) {
+        size_t mask = table.size() - 1;
+        size_t slot = slotOf(key, mask);
+        while (table[slot].key != 0 && table[slot].key != key) slot = (slot + 1) & mask;
+        if (table[slot].key == 0) table[slot].key = key, used++;
+        add(table[slot].counts, taken, tableOverflow, key);
+        if (used * 4 > table.size() * 3) grow();
+    }
+
+    // Sum entropy and optimal-table mispredictions per (pcId, config)
+    void accumulate(std::vector<double>& entropy, std::vector<uint64_t>& missed, std::vector<uint64_t>& executions) const {
+        size_t perPC = configs.size();
+        entropy.assign(pcs.size() * perPC, 0.0);
+        missed.assign(pcs.size() * perPC, 0);
+        executions.assign(pcs.size(), 0);
+        auto sum = [&](size_t slot, const WideCounts& counts) {
+            entropy[slot] += weightedEntropy(counts.taken, counts.total);
+            missed[slot] += std::min(counts.taken, counts.total - counts.taken);
+            if (slot % perPC == 0) executions[slot / perPC] += counts.total;
+        };
+        for (size_t id = 0; id < pcs.size(); id++) {
+            for (size_t c = 0; c < perPC; c++) {
+                if (configs[c].offset == SIZE_MAX) continue;
+                size_t first = id * directContexts + configs[c].offset;
+                for (size_t h = 0; h <= configs[c].mask; h++) {
+                    WideCounts counts = widen(direct[first + h], directOverflow, first + h);
+                    if (counts.total > 0) sum(id * perPC + c, counts);
+                }
+            }
+        }
+        for (const Entry& entry : table) {
+            if (entry.key != 0) sum(static_cast<size_t>(entry.key >> 32) - 1, widen(entry.counts, tableOverflow, entry.key));
+        }
+    }
+
+public:
+    // One configuration per history length, global and local for k > 0
+    explicit PredictabilityAnalyzer(const std::vector<size_t>& historyBits) : table(1 << 12) {
+        auto addConfig = [&](HistoryKind kind, size_t bits) {
+            uint64_t mask = (uint64_t(1) << bits) - 1;
+            size_t offset = SIZE_MAX;
+            if (bits <= DIRECT_PREDICTABILITY_HISTORY) {
+                offset = directContexts;
+                directContexts += size_t(1) << bits;
+            }
+            configs.push_back({kind, bits, mask, offset});
+        };
+        for (size_t bits : historyBits) {
+            bits = std::min(bits, MAX_PREDICTABILITY_HISTORY);
+            if (bits == 0) {
+                addConfig(HistoryKind::None, 0);
+            } else {
+                addConfig(HistoryKind::Global, bits);
+                addConfig(HistoryKind::Local, bits);
+            }
+        }
+    }
+
+    bool empty() const { return configs.empty(); }
+
+    // Record one conditional branch
+    void observe(uint64_t pc, bool taken) {
+        if (configs.empty()) return;
+        auto it = pcIds.find(pc);
+        uint32_t id;
+        if (it == pcIds.end()) {
+            id = static_cast<uint32_t>(pcs.size());
+            pcIds.emplace(pc, id);
+            pcs.push_back(pc);
+            localHistory.push_back(0);
+            direct.resize(direct.size() + directContexts);
+        } else {
+            id = it->second;
+        }
+
+        size_t first = static_cast<size_t>(id) * directContexts;
+        uint64_t base = static_cast<uint64_t>(id) * configs.size() + 1;
+        for (size_t c = 0; c < configs.size(); c++) {
+            uint64_t history = 0;
+            if (configs[c].kind == HistoryKind::Global) history = globalHistory & configs[c].mask;
+            else if (configs[c].kind == HistoryKind::Local) history = localHistory[id] & configs[c].mask;
+            if (configs[c].offset != SIZE_MAX) {
+                size_t index = first + configs[c].offset + history;
+                add(direct[index], taken, directOverflow, index);
+            } else {
+                count(((base + c) << 32) | history, taken);
+            }
+        }
+
+        globalHistory = (globalHistory << 1) | taken;
+        localHistory[id] = (localHistory[id] << 1) | taken;
+        conditionalBranches++;
+    }
+
+    // Bounds over all conditional branches
+    std::vector<PredictabilityBound> aggregate() const {
+        std::vector<double> entropy;
+        std::vector<uint64_t> missed, executions;
+        accumulate(entropy, missed, executions);
+
+        std::vector<PredictabilityBound> bounds;
+        for (size_t c = 0; c < configs.size(); c++) {
+            PredictabilityBound bound{configs[c].kind, configs[c].bits};
+            double totalEntropy = 0.0;
+            uint64_t totalMissed = 0;
+            for (size_t id = 0; id < pcs.size(); id++) {
+                totalEntropy += entropy[id * configs.size() + c];
+                totalMissed += missed[id * configs.size() + c];
+            }
+            if (conditionalBranches > 0) {
+                bound.entropy = totalEntropy / conditionalBranches;
+                bound.mispredictionBound = 100.0 * totalMissed / conditionalBranches;
+            }
+            bounds.push_back(bound);
+        }
+        return bounds;
+    }
+
+    // Bounds per static conditional branch, most executed first
+    std::vector<BranchPredictability> perBranch() const {
+        std::vector<double> entropy;
+        std::vector<uint64_t> missed, executions;
+        accumulate(entropy, missed, executions);
+
+        std::vector<BranchPredictability> branches;
+        for (size_t id = 0; id < pcs.size(); id++) {
+            BranchPredictability branch{pcs[id], executions[id], {}};
+            for (size_t c = 0; c < configs.size(); c++) {
+                PredictabilityBound bound{configs[c].kind, configs[c].bits};
+                if (executions[id] > 0) {
+                    bound.entropy = entropy[id * configs.size() + c] / executions[id];
+                    bound.mispredictionBound = 100.0 * missed[id * configs.size() + c] / executions[id];
+                }
+                branch.bounds.push_back(bound);
+            }
+            branches.push_back(branch);
+        }
+        std::sort(branches.begin(), branches.end(),
+                  [](const BranchPredictability& a, const BranchPredictability& b) {
+                      return a.executions != b.executions ? a.executions > b.executions : a.pc < b.pc;
+                  });
+        return branches;
+    }
+};
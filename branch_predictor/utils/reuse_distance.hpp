@@ -0,0 +1,169 @@
+# pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+// ==== reuse (LRU stack) distance ====
+// The reuse distance of an access is the number of distinct keys touched
+// since the previous access to the same key. A fully associative LRU table of
+// S entries hits exactly the accesses with distance < S, so one histogram
+// gives the hit rate of every table size.
+//
+// Keys are mapped to dense ids. Each id marks the time of its last access in
+// a Fenwick tree; the distance is the number of marks after that time, one
+// O(log n) prefix query. Times are renumbered when the tree fills up, so its
+// size stays proportional to the number of distinct keys, not the trace length.
+
+// Fenwick (binary indexed) tree of counts
+class FenwickTree {
+private:
+    std::vector<uint32_t> tree;     // 1-based
+
+public:
+    explicit FenwickTree(size_t n = 0) : tree(n + 1, 0) {}
+
+    size_t size() const { return tree.size() - 1; }
+
+    void add(size_t i, int32_t delta) {
+        for (i++; i < tree.size(); i += i & (~i + 1)) tree[i] += delta;
+    }
+
+    // Sum of [0, i]
+    uint64_t prefix(size_t i) const {
+        uint64_t sum = 0;
+        for (i++; i > 0; i -= i & (~i + 1)) sum += tree[i];
+        return sum;
+    }
+
+    // Reset to n entries, the first ones of them set to 1, in O(n)
+    void assignOnes(size_t n, size_t ones) {
+        tree.assign(n + 1, 0);
+        for (size_t i = 1; i <= n; i++) {
+            if (i <= ones) tree[i] += 1;
+            size_t parent = i + (i & (~i + 1));
+            if (parent <= n) tree[parent] += tree[i];
+        }
+    }
+};
+
+// Histogram of reuse distances in power-of-two buckets: bucket 0 holds
+// distance 0, bucket b > 0 distances [2^(b-1), 2^b - 1]
+struct ReuseHistogram {
+    std::vector<uint64_t> buckets;
+    uint64_t accesses = 0;
+    uint64_t coldAccesses = 0;      // first access to a key
+    uint64_t distinct = 0;
+
+    static size_t bucketOf(uint64_t distance) {
+        return distance == 0 ? 0 : 64 - __builtin_clzll(distance);
+    }
+
+    static uint64_t bucketMin(size_t b) { return b == 0 ? 0 : uint64_t(1) << (b - 1); }
+    static uint64_t bucketMax(size_t b) { return b == 0 ? 0 : (uint64_t(1) << b) - 1; }
+
+    // Hit rate (percent of accesses) of a fully associative LRU table with 2^b entries
+    double lruHitRate(size_t b) const {
+        if (accesses == 0) return 0.0;
+        uint64_t hits = 0;
+        for (size_t i = 0; i <= b && i < buckets.size(); i++) hits += buckets[i];
+        return 100.0 * hits / accesses;
+    }
+};
+
+class ReuseDistanceAnalyzer {
+private:
+    static const size_t MIN_CAPACITY = 1 << 16;
+
+    size_t keySpace;                                // > 0: keys are already dense ids in [0, keySpace)
+    std::unordered_map<uint64_t, uint32_t> ids;     // key -> dense id, when keySpace == 0
+    std::vector<uint64_t> lastAccess;               // dense id -> time of the last access + 1, 0 = never
+    FenwickTree marks;
+    size_t now = 0;
+    size_t live = 0;                                // number of marks (distinct keys seen)
+
+    std::vector<uint64_t> intervalStamp;            // dense id -> last interval it was seen in, 0 = never
+    uint64_t interval = 1;
+    size_t intervalDistinct = 0;
+
+    ReuseHistogram histogram;
+
+    // Renumber the last-access times to 0..live-1, preserving their order
+    void compact() {
+        std::vector<std::pair<uint64_t, uint32_t>> order;
+        order.reserve(live);
+        for (size_t id = 0; id < lastAccess.size(); id++) {
+            if (lastAccess[id] != 0) order.emplace_back(lastAccess[id], static_cast<uint32_t>(id));
+        }
+        std::sort(order.begin(), order.end());
+        for (size_t i = 0; i < order.size(); i++) lastAccess[order[i].second] = i + 1;
+        marks.assignOnes(std::max(MIN_CAPACITY, 4 * live), live);
+        now = live;
+    }
+
+    uint32_t denseId(uint64_t key) {
+        if (keySpace > 0) return static_cast<uint32_t>(key);
+        auto it = ids.find(key);
+        if (it != ids.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(ids.size());
+        ids.emplace(key, id);
+        lastAccess.push_back(0);
+        intervalStamp.push_back(0);
+        return id;
+    }
+
+public:
+    explicit ReuseDistanceAnalyzer(size_t denseKeySpace = 0)
+        : keySpace(denseKeySpace), lastAccess(denseKeySpace, 0), marks(MIN_CAPACITY),
+          intervalStamp(denseKeySpace, 0) {
+        histogram.buckets.assign(65, 0);
+    }
+
+    void access(uint64_t key) {
+        uint32_t id = denseId(key);
+        histogram.accesses++;
+
+        if (intervalStamp[id] != interval) {
+            intervalStamp[id] = interval;
+            intervalDistinct++;
+        }
+
+        if (lastAccess[id] == 0) {
+            histogram.coldAccesses++;
+            live++;
+        } else {
+            size_t last = lastAccess[id] - 1;
+            uint64_t distance = live - marks.prefix(last);     // marks after last
+            histogram.buckets[ReuseHistogram::bucketOf(distance)]++;
+            marks.add(last, -1);
+        }
+
+        if (now == marks.size()) {
+            lastAccess[id] = 0;     // not marked while compacting
+            live--;
+            compact();
+            live++;
+        }
+        marks.add(now, 1);
+        lastAccess[id] = ++now;
+    }
+
+    // Distinct keys since the last startInterval()
+    size_t intervalSize() const { return intervalDistinct; }
+
+    void startInterval() {
+        interval++;
+        intervalDistinct = 0;
+    }
+
+    ReuseHistogram result() const {
+        ReuseHistogram out = histogram;
+        out.distinct = live;
+        size_t used = out.buckets.size();
+        while (used > 1 && out.buckets[used - 1] == 0) used--;
+        out.buckets.resize(used);
+        return out;
+    }
+};
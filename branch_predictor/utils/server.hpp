@@ -0,0 +1,355 @@
+# pragma once
+
+#include "predictor/branch.hpp"
+#include "predictor/predictor.hpp"
+#include "predictor/factory.hpp"
+#include "utils/trace_io.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ==== prediction server ====
+// Serves predictions over a UNIX domain stream socket, one predictor per
+// connection, all connections on a single epoll event loop.
+//
+// Protocol (integers little-endian):
+//   client: predictor spec line, e.g. "gshare size=4096\n"
+//   server: "OK <predictor name>\n", or "ERR <message>\n" and the connection is closed
+//   then any number of batches:
+//   client: uint32 count (at most SERVER_MAX_BATCH), count 17-byte records
+//           as in binary traces (pc, target, packed flags)
+//   server: uint32 count, ceil(count / 8) bytes of predictions, bit i % 8 of
+//           byte i / 8 for record i, made before the predictor saw its outcome
+// A batch of count 0 resets the predictor and is answered with count 0.
+//
+// Connection buffers keep their capacity and the decoded branches and
+// predictions are shared scratch, so a steady stream allocates nothing. A
+// connection whose replies are not being read stops being read until they
+// drain. Out of descriptors or memory, pending clients wait in the listen
+// queue until a connection closes. SIGINT and SIGTERM stop the loop, remove
+// the socket file and the signal mask is restored with the server.
+
+const uint32_t SERVER_MAX_BATCH = 1 << 16;
+const size_t SERVER_MAX_SPEC_LINE = 1024;
+const size_t SERVER_READ_CHUNK = 64 * 1024;
+const int SERVER_MAX_EVENTS = 64;
+
+class PredictionServer {
+private:
+    struct Connection {
+        int fd = -1;
+        std::unique_ptr<BranchPredictor> predictor;     // null until the spec line arrived
+        std::vector<char> input;
+        size_t inputUsed = 0;
+        std::vector<char> output;
+        size_t outputSent = 0;
+        bool closing = false;       // close once the output is flushed
+        bool writeBlocked = false;
+        uint64_t branches = 0;
+    };
+
+    std::string socketPath;
+    int listenFd = -1;
+    int epollFd = -1;
+    int signalFd = -1;
+    sigset_t savedSignals;                  // signal mask before SIGINT/SIGTERM were blocked
+    bool acceptStalled = false;             // out of descriptors or memory, warned once
+    std::unordered_map<int, Connection> connections;
+    std::vector<Branch> branches;           // scratch for one batch
+    std::vector<uint8_t> predictions;
+    uint64_t servedConnections = 0;
+    uint64_t servedBranches = 0;
+
+    static void fail(const std::string& what) {
+        throw std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    void watch(int fd, uint32_t events, int op) {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, op, fd, &event) < 0) fail("epoll_ctl");
+    }
+
+    void acceptClients() {
+        while (true) {
+            int fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                    // the pending client stays queued, retried on the next wakeup
+                    if (!acceptStalled) {
+                        std::cerr << "Warning: accept: " << std::strerror(errno) << ", "
+                                  << connections.size() << " connections open" << std::endl;
+                        acceptStalled = true;
+                    }
+                    return;
+                }
+                fail("accept");
+            }
+            acceptStalled = false;
+            Connection& connection = connections[fd];
+            connection.fd = fd;
+            connection.input.resize(SERVER_READ_CHUNK);
+            watch(fd, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD);
+            servedConnections++;
+        }
+    }
+
+    void closeConnection(Connection& connection) {
+        int fd = connection.fd;             // erase must not read the key from the erased element
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        servedBranches += connection.branches;
+        connections.erase(fd);
+    }
+
+    void reply(Connection& connection, const char* data, size_t size) {
+        connection.output.insert(connection.output.end(), data, data + size);
+    }
+
+    // Answer a bad request and close the connection once the answer is sent
+    void reject(Connection& connection, const std::string& message) {
+        std::string line = "ERR " + message + "\n";
+        reply(connection, line.data(), line.size());
+        connection.closing = true;
+    }
+
+    // Spec line; returns the bytes consumed, 0 if the line is incomplete
+    size_t handleSpecLine(Connection& connection, const char* data, size_t size) {
+        const char* newline = static_cast<const char*>(std::memchr(data, '\n', size));
+        if (!newline) {
+            if (size >= SERVER_MAX_SPEC_LINE) reject(connection, "Predictor spec line too long");
+            return 0;
+        }
+        std::string line(data, newline);
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        try {
+            PredictorSpec spec = PredictorSpec::parse(line);
+            if (findPredictorType(spec.type).profiled) {
+                throw std::invalid_argument("Profiled predictors need a profiling pass and cannot be served");
+            }
+            connection.predictor = createPredictor(spec);
+            std::string ok = "OK " + connection.predictor->getName() + "\n";
+            reply(connection, ok.data(), ok.size());
+        } catch (const std::exception& e) {
+            reject(connection, e.what());
+        }
+        return newline - data + 1;
+    }
+
+    // One batch; returns the bytes consumed, 0 if the batch is incomplete
+    size_t handleBatch(Connection& connection, const char* data, size_t size) {
+        if (size < 4) return 0;
+        uint32_t count;
+        std::memcpy(&count, data, 4);
+        if (count > SERVER_MAX_BATCH) {
+            reject(connection, "Batch of " + std::to_string(count) + " branches exceeds " +
+                               std::to_string(SERVER_MAX_BATCH));
+            return 0;
+        }
+        size_t needed = 4 + static_cast<size_t>(count) * BINARY_RECORD_SIZE;
+        if (size < needed) {
+            if (connection.input.size() < needed) connection.input.resize(needed);
+            return 0;
+        }
+
+        if (count == 0) {
+            connection.predictor->reset();
+        } else {
+            const char* record = data + 4;
+            for (uint32_t i = 0; i < count; i++, record += BINARY_RECORD_SIZE) {
+                decodeBinaryRecord(record, branches[i]);
+            }
+            connection.predictor->processBatch(branches.data(), count, predictions.data());
+            connection.branches += count;
+        }
+
+        size_t replyStart = connection.output.size();
+        connection.output.resize(replyStart + 4 + (count + 7) / 8);
+        char* out = connection.output.data() + replyStart;
+        std::memcpy(out, &count, 4);
+        uint8_t* bitmap = reinterpret_cast<uint8_t*>(out + 4);
+        for (uint32_t byte = 0; byte < count / 8; byte++) {
+            const uint8_t* p = &predictions[byte * 8];
+            bitmap[byte] = p[0] | (p[1] << 1) | (p[2] << 2) | (p[3] << 3) |
+                           (p[4] << 4) | (p[5] << 5) | (p[6] << 6) | (p[7] << 7);
+        }
+        if (count % 8) {
+            uint8_t last = 0;
+            for (uint32_t i = count & ~7u; i < count; i++) last |= predictions[i] << (i % 8);
+            bitmap[count / 8] = last;
+        }
+        return needed;
+    }
+
+    // Send pending output; returns false if the socket would block
+    bool flush(Connection& connection) {
+        while (connection.outputSent < connection.output.size()) {
+            ssize_t n = send(connection.fd, connection.output.data() + connection.outputSent,
+                             connection.output.size() - connection.outputSent, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) return false;
+                connection.closing = true;      // peer is gone
+                connection.output.clear();
+                connection.outputSent = 0;
+                return true;
+            }
+            connection.outputSent += n;
+        }
+        connection.output.clear();          // keeps its capacity
+        connection.outputSent = 0;
+        return true;
+    }
+
+    // Handle every complete request in the input buffer
+    void process(Connection& connection) {
+        size_t offset = 0;
+        while (!connection.closing && offset < connection.inputUsed) {
+            const char* data = connection.input.data() + offset;
+            size_t size = connection.inputUsed - offset;
+            size_t used = connection.predictor ? handleBatch(connection, data, size)
+                                               : handleSpecLine(connection, data, size);
+            if (used == 0) break;
+            offset += used;
+        }
+        if (offset > 0) {
+            std::memmove(connection.input.data(), connection.input.data() + offset, connection.inputUsed - offset);
+            connection.inputUsed -= offset;
+        }
+    }
+
+    // Flush, then stop reading while replies are stuck or close if done
+    void sendReplies(Connection& connection) {
+        bool flushed = flush(connection);
+        if (flushed && connection.closing) {
+            closeConnection(connection);
+            return;
+        }
+        if (flushed == connection.writeBlocked) {
+            connection.writeBlocked = !flushed;
+            watch(connection.fd, flushed ? (EPOLLIN | EPOLLRDHUP) : EPOLLOUT, EPOLL_CTL_MOD);
+        }
+    }
+
+    void readClient(Connection& connection) {
+        if (connection.inputUsed == connection.input.size()) {
+            connection.input.resize(connection.input.size() + SERVER_READ_CHUNK);
+        }
+        ssize_t n = read(connection.fd, connection.input.data() + connection.inputUsed,
+                         connection.input.size() - connection.inputUsed);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) return;
+        if (n <= 0) {
+            connection.closing = true;      // still send the replies already made
+            sendReplies(connection);
+            return;
+        }
+        connection.inputUsed += n;
+        process(connection);
+        sendReplies(connection);
+    }
+
+    void handle(const epoll_event& event) {
+        auto it = connections.find(event.data.fd);
+        if (it == connections.end()) return;
+        Connection& connection = it->second;
+        if (event.events & EPOLLOUT) {
+            sendReplies(connection);
+        } else if (event.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            readClient(connection);
+        }
+    }
+
+public:
+    explicit PredictionServer(const std::string& socketPath) : socketPath(socketPath) {
+        sockaddr_un address{};
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Socket path too long: " + socketPath);
+        }
+        address.sun_family = AF_UNIX;
+        std::strcpy(address.sun_path, socketPath.c_str());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) fail("socket");
+        unlink(socketPath.c_str());         // stale socket of an earlier server
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) fail("bind " + socketPath);
+        if (listen(listenFd, SOMAXCONN) < 0) fail("listen");
+
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (epollFd < 0) fail("epoll_create1");
+        watch(listenFd, EPOLLIN, EPOLL_CTL_ADD);
+
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &signals, &savedSignals);
+        signalFd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        if (signalFd < 0) {
+            int error = errno;
+            pthread_sigmask(SIG_SETMASK, &savedSignals, nullptr);
+            errno = error;
+            fail("signalfd");
+        }
+        watch(signalFd, EPOLLIN, EPOLL_CTL_ADD);
+
+        branches.resize(SERVER_MAX_BATCH);
+        predictions.resize(SERVER_MAX_BATCH);
+    }
+
+    ~PredictionServer() {
+        for (auto& entry : connections) close(entry.first);
+        if (signalFd >= 0) {
+            close(signalFd);
+            pthread_sigmask(SIG_SETMASK, &savedSignals, nullptr);
+        }
+        if (epollFd >= 0) close(epollFd);
+        if (listenFd >= 0) {
+            close(listenFd);
+            unlink(socketPath.c_str());
+        }
+    }
+
+    // Serve until SIGINT or SIGTERM
+    void run() {
+        std::cout << "Serving predictions on " << socketPath << std::endl;
+        epoll_event events[SERVER_MAX_EVENTS];
+        bool running = true;
+        while (running) {
+            int ready = epoll_wait(epollFd, events, SERVER_MAX_EVENTS, -1);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                fail("epoll_wait");
+            }
+            for (int i = 0; i < ready; i++) {
+                if (events[i].data.fd == listenFd) acceptClients();
+                else if (events[i].data.fd == signalFd) {
+                    // consume the signal, it would be delivered again once the mask is restored
+                    signalfd_siginfo info;
+                    while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {}
+                    running = false;
+                }
+                else handle(events[i]);
+            }
+        }
+        for (auto& entry : connections) servedBranches += entry.second.branches;
+        std::cout << "Served " << servedBranches << " branches to " << servedConnections << " connections" << std::endl;
+    }
+};
@@ -0,0 +1,364 @@
+# pragma once
+
+#include "predictor/branch.hpp"
+#include "predictor/predictor.hpp"
+#include "utils/trace_io.hpp"
+#include "utils/trace_cache.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <iomanip>
+#include <limits>
+#include <cstdint>
+#include <cmath>
+
+// A representative interval of a trace and the fraction of the trace it stands for
+struct SimPoint {
+    size_t interval;    // interval index in the trace
+    size_t start;       // first branch of the interval
+    size_t length;      // branches in the interval
+    double weight;      // fraction of all branches represented
+    size_t cluster;     // k-means cluster the interval represents
+};
+
+// Result of simulating a predictor on the simpoints of a trace
+struct SimPointEstimate {
+    size_t simulatedBranches = 0;   // measured branches (warmup excluded)
+    size_t mispredictions = 0;      // measured mispredictions
+    double mispredictionRate = 0.0; // weighted estimate, in percent
+};
+
+
+// ==== interval vectors ====
+
+// Deterministic projection coefficient in [-1, 1) for (pc, dimension)
+inline float projectionCoefficient(uint64_t pc, size_t dim, uint64_t seed) {
+    uint64_t x = pc ^ (seed * 0x9E3779B97F4A7C15ULL) ^ ((dim + 1) * 0xC2B2AE3D27D4EB4FULL);
+    x ^= x >> 33; x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33; x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return static_cast<float>(x >> 40) / static_cast<float>(1 << 23) - 1.0f;
+}
+
+// Build a randomly projected branch-PC frequency vector for every fixed-size
+// interval of the trace in one streaming pass. vectors is row-major
+// (intervals x dims), lengths holds the branch count of every interval.
+void buildIntervalVectors(const std::string& traceFile, size_t intervalSize, size_t dims, uint64_t seed,
+                          std::vector<float>& vectors, std::vector<size_t>& lengths) {
+    auto reader = openTrace(traceFile);
+    vectors.clear();
+    lengths.clear();
+
+    std::unordered_map<uint64_t, uint32_t> pcIds;    // PC -> dense id
+    std::vector<float> projection;                   // dense id -> projection row (dims)
+    std::vector<uint32_t> counts;                    // dense id -> count in current interval
+    std::vector<uint32_t> touched;                   // ids seen in current interval
+
+    auto flushInterval = [&](size_t length) {
+        size_t row = vectors.size();
+        vectors.resize(row + dims, 0.0f);
+        for (uint32_t id : touched) {
+            float frequency = static_cast<float>(counts[id]) / length;
+            const float* coefficients = &projection[static_cast<size_t>(id) * dims];
+            for (size_t d = 0; d < dims; d++) {
+                vectors[row + d] += frequency * coefficients[d];
+            }
+            counts[id] = 0;
+        }
+        touched.clear();
+        lengths.push_back(length);
+    };
+
+    Branch branch;
+    size_t inInterval = 0;
+    while (reader->next(branch)) {
+        auto it = pcIds.find(branch.pc);
+        uint32_t id;
+        if (it == pcIds.end()) {
+            id = static_cast<uint32_t>(pcIds.size());
+            pcIds.emplace(branch.pc, id);
+            counts.push_back(0);
+            for (size_t d = 0; d < dims; d++) {
+                projection.push_back(projectionCoefficient(branch.pc, d, seed));
+            }
+        } else {
+            id = it->second;
+        }
+        if (counts[id]++ == 0) touched.push_back(id);
+
+        if (++inInterval == intervalSize) {
+            flushInterval(inInterval);
+            inInterval = 0;
+        }
+    }
+    if (inInterval > 0) flushInterval(inInterval);
+}
+
+
+// ==== k-means ====
+
+inline float squaredDistance(const float* a, const float* b, size_t dims) {
+    float sum = 0.0f;
+    for (size_t d = 0; d < dims; d++) {
+        float diff = a[d] - b[d];
+        sum += diff * diff;
+    }
+    return sum;
+}
+
+// Run fn(begin, end) over [0, n) split across the given number of threads
+template <typename Fn>
+void parallelFor(size_t n, size_t threads, Fn fn) {
+    threads = std::max<size_t>(1, std::min(threads, n));
+    if (threads == 1) {
+        fn(size_t(0), n);
+        return;
+    }
+    std::vector<std::thread> workers;
+    size_t chunk = (n + threads - 1) / threads;
+    for (size_t t = 0; t < threads; t++) {
+        size_t begin = t * chunk;
+        size_t end = std::min(n, begin + chunk);
+        if (begin >= end) break;
+        workers.emplace_back(fn, begin, end);
+    }
+    for (auto& worker : workers) worker.join();
+}
+
+// Weighted k-means (k-means++ seeding, Lloyd iterations with a parallel
+// assignment step). Returns the cluster of every point, fills centroids.
+std::vector<size_t> kmeans(const std::vector<float>& points, const std::vector<size_t>& weights, size_t dims,
+                           size_t k, size_t threads, uint64_t seed, std::vector<float>& centroids,
+                           size_t maxIterations = 100) {
+    size_t n = weights.size();
+    k = std::min(k, n);
+    centroids.assign(k * dims, 0.0f);
+    std::vector<size_t> assignment(n, 0);
+    if (n == 0 || k == 0) return assignment;
+
+    // k-means++ seeding
+    std::mt19937_64 rng(seed);
+    std::vector<float> nearest(n, std::numeric_limits<float>::max());
+    size_t first = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+    std::copy_n(&points[first * dims], dims, &centroids[0]);
+    for (size_t c = 1; c < k; c++) {
+        double total = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            nearest[i] = std::min(nearest[i], squaredDistance(&points[i * dims], &centroids[(c - 1) * dims], dims));
+            total += nearest[i];
+        }
+        size_t chosen = 0;
+        if (total > 0.0) {
+            double target = std::uniform_real_distribution<double>(0.0, total)(rng);
+            for (chosen = 0; chosen + 1 < n; chosen++) {
+                target -= nearest[chosen];
+                if (target <= 0.0) break;
+            }
+        } else {
+            chosen = std::uniform_int_distribution<size_t>(0, n - 1)(rng);
+        }
+        std::copy_n(&points[chosen * dims], dims, &centroids[c * dims]);
+    }
+
+    // Lloyd iterations
+    for (size_t iteration = 0; iteration < maxIterations; iteration++) {
+        std::atomic<bool> changed(false);
+        parallelFor(n, threads, [&](size_t begin, size_t end) {
+            bool any = false;
+            for (size_t i = begin; i < end; i++) {
+                size_t best = 0;
+                float bestDistance = std::numeric_limits<float>::max();
+                for (size_t c = 0; c < k; c++) {
+                    float distance = squaredDistance(&points[i * dims], &centroids[c * dims], dims);
+                    if (distance < bestDistance) { bestDistance = distance; best = c; }
+                }
+                if (assignment[i] != best || iteration == 0) any = true;
+                assignment[i] = best;
+            }
+            if (any) changed = true;
+        });
+        if (!changed) break;
+
+        std::vector<double> sums(k * dims, 0.0);
+        std::vector<double> mass(k, 0.0);
+        for (size_t i = 0; i < n; i++) {
+            size_t c = assignment[i];
+            mass[c] += weights[i];
+            for (size_t d = 0; d < dims; d++) sums[c * dims + d] += static_cast<double>(points[i * dims + d]) * weights[i];
+        }
+        for (size_t c = 0; c < k; c++) {
+            if (mass[c] == 0.0) continue;   // keep an empty cluster's previous centroid
+            for (size_t d = 0; d < dims; d++) centroids[c * dims + d] = static_cast<float>(sums[c * dims + d] / mass[c]);
+        }
+    }
+    return assignment;
+}
+
+// Pick the interval closest to every centroid and weight it by its cluster's share of branches
+std::vector<SimPoint> selectSimPoints(const std::vector<float>& vectors, const std::vector<size_t>& lengths,
+                                      size_t dims, size_t intervalSize, size_t k, size_t threads, uint64_t seed) {
+    std::vector<float> centroids;
+    std::vector<size_t> assignment = kmeans(vectors, lengths, dims, k, threads, seed, centroids);
+    size_t clusters = centroids.size() / dims;
+
+    size_t totalBranches = 0;
+    for (size_t length : lengths) totalBranches += length;
+
+    std::vector<size_t> clusterBranches(clusters, 0);
+    std::vector<size_t> representative(clusters, SIZE_MAX);
+    std::vector<float> bestDistance(clusters, std::numeric_limits<float>::max());
+    for (size_t i = 0; i < lengths.size(); i++) {
+        size_t c = assignment[i];
+        clusterBranches[c] += lengths[i];
+        float distance = squaredDistance(&vectors[i * dims], &centroids[c * dims], dims);
+        // prefer full-length intervals as representatives
+        if (lengths[i] < intervalSize) distance += 1.0f;
+        if (distance < bestDistance[c]) { bestDistance[c] = distance; representative[c] = i; }
+    }
+
+    std::vector<SimPoint> points;
+    for (size_t c = 0; c < clusters; c++) {
+        if (representative[c] == SIZE_MAX) continue;
+        size_t i = representative[c];
+        points.push_back({i, i * intervalSize, lengths[i],
+                          static_cast<double>(clusterBranches[c]) / totalBranches, c});
+    }
+    std::sort(points.begin(), points.end(),
+              [](const SimPoint& a, const SimPoint& b) { return a.start < b.start; });
+    return points;
+}
+
+
+// ==== simpoint files ====
+
+void saveSimPoints(const std::vector<SimPoint>& points, const std::string& csvFile) {
+    std::ofstream csv(csvFile);
+    if (!csv.is_open()) {
+        std::cerr << "Error: Could not create CSV file " << csvFile << std::endl;
+        throw std::runtime_error("Could not create file");
+    }
+    csv << "Interval,Start,Length,Weight,Cluster\n";
+    for (const auto& point : points) {
+        csv << point.interval << "," << point.start << "," << point.length << ","
+            << std::setprecision(10) << point.weight << "," << point.cluster << "\n";
+    }
+}
+
+std::vector<SimPoint> loadSimPoints(const std::string& csvFile) {
+    std::ifstream csv(csvFile);
+    if (!csv.is_open()) {
+        std::cerr << "Error: Could not open file " << csvFile << std::endl;
+        throw std::runtime_error("File not found");
+    }
+    std::vector<SimPoint> points;
+    std::string line;
+    std::getline(csv, line);    // header
+    while (std::getline(csv, line)) {
+        if (line.empty()) continue;
+        SimPoint point;
+        char comma;
+        std::istringstream iss(line);
+        if (!(iss >> point.interval >> comma >> point.start >> comma >> point.length
+                  >> comma >> point.weight >> comma >> point.cluster)) {
+            throw std::runtime_error("Error parsing line: " + line);
+        }
+        points.push_back(point);
+    }
+    std::sort(points.begin(), points.end(),
+              [](const SimPoint& a, const SimPoint& b) { return a.start < b.start; });
+    return points;
+}
+
+// Default location of the simpoints of a trace
+std::string simPointFile(const std::string& simPointDir, const std::string& traceName) {
+    return simPointDir + "/" + traceName + "_simpoints.csv";
+}
+
+
+// ==== simulation on simpoints ====
+
+// Stream the branches of every simpoint, preceded by up to `warmup` branches
+// of warming. fn(branch, pointIndex, measured) is called for each branch.
+template <typename Fn>
+void forEachSimPointBranch(const std::string& traceFile, const std::vector<SimPoint>& points,
+                           size_t warmup, Fn fn) {
+    auto reader = openTrace(traceFile);
+    size_t position = 0;
+    Branch branch;
+    for (size_t p = 0; p < points.size(); p++) {
+        const SimPoint& point = points[p];
+        size_t warmStart = std::max(position, point.start > warmup ? point.start - warmup : 0);
+        position += reader->skip(warmStart - position);
+        while (position < point.start && reader->next(branch)) {
+            fn(branch, p, false);
+            position++;
+        }
+        size_t end = point.start + point.length;
+        while (position < end && reader->next(branch)) {
+            fn(branch, p, true);
+            position++;
+        }
+    }
+}
+
+// Weighted misprediction estimate of a predictor from the simpoints of a trace
+SimPointEstimate estimateWithSimPoints(BranchPredictor& predictor, const std::string& traceFile,
+                                       const std::vector<SimPoint>& points, size_t warmup, bool resetFirst = true) {
+    if (resetFirst) predictor.reset();
+
+    std::vector<size_t> measured(points.size(), 0);
+    std::vector<size_t> missed(points.size(), 0);
+    forEachSimPointBranch(traceFile, points, warmup, [&](const Branch& branch, size_t p, bool measure) {
+        bool prediction = predictor.predict(branch);
+        if (measure) {
+            measured[p]++;
+            if (prediction != branch.taken) missed[p]++;
+        }
+        predictor.update(branch, prediction);
+    });
+
+    SimPointEstimate estimate;
+    double weightTotal = 0.0;
+    for (size_t p = 0; p < points.size(); p++) {
+        if (measured[p] == 0) continue;
+        estimate.simulatedBranches += measured[p];
+        estimate.mispredictions += missed[p];
+        estimate.mispredictionRate += points[p].weight * missed[p] / measured[p];
+        weightTotal += points[p].weight;
+    }
+    // renormalise in case some simpoints fell outside the trace
+    if (weightTotal > 0.0) estimate.mispredictionRate = 100.0 * estimate.mispredictionRate / weightTotal;
+    return estimate;
+}
+
+// Profile-guided predictors are profiled on the simpoints before they are measured on them
+template <typename ProfiledType>
+SimPointEstimate estimateProfiledWithSimPoints(ProfiledType& predictor, const std::string& traceFile,
+                                               const std::vector<SimPoint>& points, size_t warmup) {
+    predictor.reset();
+    forEachSimPointBranch(traceFile, points, warmup, [&](const Branch& branch, size_t, bool) {
+        bool prediction = predictor.predict(branch);
+        predictor.update(branch, prediction);
+    });
+    predictor.switchToPredict();
+    return estimateWithSimPoints(predictor, traceFile, points, warmup, false);
+}
+
+// Estimate any predictor, profiled predictors are profiled on the simpoints first
+inline SimPointEstimate estimateAnyWithSimPoints(BranchPredictor& predictor, const std::string& traceFile,
+                                                 const std::vector<SimPoint>& points, size_t warmup) {
+    if (auto* profiled = dynamic_cast<ProfiledPredictor*>(&predictor)) {
+        return estimateProfiledWithSimPoints(*profiled, traceFile, points, warmup);
+    } else if (auto* profiled2Bit = dynamic_cast<Profiled2BitPredictor*>(&predictor)) {
+        return estimateProfiledWithSimPoints(*profiled2Bit, traceFile, points, warmup);
+    }
+    return estimateWithSimPoints(predictor, traceFile, points, warmup);
+}
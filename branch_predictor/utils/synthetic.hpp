@@ -0,0 +1,352 @@
+# pragma once
+
+#include "predictor/branch.hpp"
+#include "utils/trace_io.hpp"
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+// ==== synthetic traces ====
+// A synthetic program is a set of functions, each a sequence of branch
+// sites, built once from the seed:
+//   loop        backward branch taken trip - 1 times, then not taken; while
+//               taken, up to maxSpan sites before it run again. Spans stop
+//               at the previous loop, loops nest through calls in their body
+//   biased      taken with a fixed per-site probability far from 1/2
+//   correlated  parity of 1-2 recent global outcomes, flipped with `noise`
+//   random      taken with probability 1/2
+//   call        direct call of a later function (calls form a DAG, so the
+//               nesting depth is bounded), answered by its return
+//   indirect    indirect jump to one of up to INDIRECT_MAX_TARGETS targets,
+//               the first with probability INDIRECT_SKEW
+// Execution starts in a dispatcher calling random functions. The trace is
+// generated in chunks of `chunkBranches` branches, each starting from an
+// empty call stack with its own PRNG seeded by (seed, chunk index), so
+// chunks can be generated in parallel and the output only depends on the
+// options, not on the thread count.
+
+const uint64_t SYNTHETIC_BASE_PC = 0x400000;
+const uint64_t SYNTHETIC_DISPATCH_PC = 0x3ff000;
+const uint64_t SYNTHETIC_FUNCTION_STRIDE = 0x1000;
+const size_t INDIRECT_MAX_TARGETS = 8;
+const double INDIRECT_SKEW = 0.7;
+const size_t SYNTHETIC_MAX_LINE = 48;          // longest text line, two 16-digit addresses
+
+struct SyntheticOptions {
+    uint64_t branches = 10000000;
+    uint64_t seed = 1;
+    size_t functions = 256;
+    size_t bodySites = 16;          // sites per function
+    size_t maxDepth = 16;           // call nesting limit
+    size_t maxTrip = 32;            // loop trip counts are 2..maxTrip
+    size_t maxSpan = 4;             // sites repeated by a loop
+    double callFraction = 0.1;      // share of call sites
+    double indirectFraction = 0.02; // share of indirect jump sites
+    double noise = 0.02;            // flip probability of correlated branches
+    // weights of the conditional site classes: loop, biased, correlated, random
+    double mix[4] = {20, 50, 20, 10};
+    size_t chunkBranches = 1 << 18;
+    TraceFormat format = TraceFormat::Text;
+};
+
+// "loop=20,biased=50,correlated=20,random=10", omitted classes get weight 0
+inline void parseSyntheticMix(const std::string& text, SyntheticOptions& options) {
+    static const char* names[4] = {"loop", "biased", "correlated", "random"};
+    double mix[4] = {0, 0, 0, 0};
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        size_t eq = item.find('=');
+        std::string name = item.substr(0, eq);
+        size_t c = 0;
+        while (c < 4 && name != names[c]) c++;
+        if (eq == std::string::npos || c == 4) throw std::invalid_argument("Invalid mix entry " + item);
+        mix[c] = std::stod(item.substr(eq + 1));
+        if (mix[c] < 0) throw std::invalid_argument("Negative mix weight " + item);
+    }
+    if (mix[0] + mix[1] + mix[2] + mix[3] <= 0) throw std::invalid_argument("Mix has no weight: " + text);
+    std::memcpy(options.mix, mix, sizeof(mix));
+}
+
+// xoshiro256** seeded through splitmix64, a few ns per draw
+class FastRng {
+private:
+    uint64_t s[4];
+
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+public:
+    explicit FastRng(uint64_t seed) {
+        for (uint64_t& word : s) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t operator()() {
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    // Uniform in [0, n)
+    uint64_t below(uint64_t n) { return static_cast<uint64_t>((static_cast<unsigned __int128>((*this)()) * n) >> 64); }
+
+    double uniform() { return ((*this)() >> 11) * 0x1.0p-53; }
+};
+
+// Probability as a threshold on a 64-bit draw
+inline uint64_t probabilityThreshold(double p) {
+    if (p <= 0) return 0;
+    if (p >= 1) return ~uint64_t(0);
+    return static_cast<uint64_t>(p * 0x1.0p64);
+}
+
+class SyntheticProgram {
+public:
+    enum class SiteKind : uint8_t { Loop, Biased, Correlated, Random, Call, Indirect };
+
+    struct Site {
+        SiteKind kind;
+        uint64_t pc;
+        uint64_t target;            // branch target, callee entry or first indirect target
+        uint64_t threshold = 0;     // biased: P(taken); correlated: noise; indirect: skew
+        uint64_t taps = 0;          // correlated: global history bits
+        uint32_t trip = 0;          // loop trip count, indirect target count
+        uint32_t span = 0;          // loop: sites repeated
+        uint32_t callee = 0;
+        bool polarity = false;      // correlated: outcome for even parity
+    };
+
+    struct Function {
+        uint64_t entry;
+        uint64_t returnPc;
+        uint32_t firstSite;
+        uint32_t sites;
+    };
+
+    std::vector<Site> sites;
+    std::vector<Function> functions;
+    SyntheticOptions options;
+
+    explicit SyntheticProgram(const SyntheticOptions& opts) : options(opts) {
+        if (options.functions == 0 || options.bodySites == 0) {
+            throw std::invalid_argument("A synthetic program needs functions with at least one site");
+        }
+        FastRng rng(options.seed);
+        double mixTotal = options.mix[0] + options.mix[1] + options.mix[2] + options.mix[3];
+        uint64_t noise = probabilityThreshold(options.noise);
+
+        for (size_t f = 0; f < options.functions; f++) {
+            Function function;
+            function.entry = SYNTHETIC_BASE_PC + f * SYNTHETIC_FUNCTION_STRIDE + 16 * rng.below(16);
+            function.firstSite = static_cast<uint32_t>(sites.size());
+            function.sites = static_cast<uint32_t>(options.bodySites);
+            size_t loopStart = 0;       // first site a loop may repeat
+            for (size_t j = 0; j < options.bodySites; j++) {
+                Site site;
+                site.pc = function.entry + 8 + 16 * j + 2 * rng.below(4);
+                site.target = site.pc + 0x20;
+                double roll = rng.uniform();
+                bool canCall = f + 1 < options.functions;
+                if (canCall && roll < options.callFraction) {
+                    site.kind = SiteKind::Call;
+                    site.callee = static_cast<uint32_t>(f + 1 + rng.below(std::min<size_t>(16, options.functions - f - 1)));
+                } else if (roll < options.callFraction + options.indirectFraction) {
+                    site.kind = SiteKind::Indirect;
+                    site.target = function.entry + 0x800 + 0x40 * rng.below(16);
+                    site.trip = static_cast<uint32_t>(2 + rng.below(INDIRECT_MAX_TARGETS - 1));
+                    site.threshold = probabilityThreshold(INDIRECT_SKEW);
+                } else {
+                    double pick = rng.uniform() * mixTotal;
+                    if (pick < options.mix[0]) {
+                        site.kind = SiteKind::Loop;
+                        site.trip = static_cast<uint32_t>(2 + rng.below(std::max<size_t>(options.maxTrip, 2) - 1));
+                        site.span = static_cast<uint32_t>(rng.below(std::min(j - loopStart, options.maxSpan) + 1));
+                        loopStart = j + 1;
+                        site.target = function.entry + 8 + 16 * (j - site.span);
+                    } else if (pick < options.mix[0] + options.mix[1]) {
+                        site.kind = SiteKind::Biased;
+                        double bias = 0.85 + 0.14 * rng.uniform();
+                        site.threshold = probabilityThreshold(rng.below(10) < 6 ? bias : 1 - bias);
+                    } else if (pick < options.mix[0] + options.mix[1] + options.mix[2]) {
+                        site.kind = SiteKind::Correlated;
+                        site.taps = uint64_t(1) << rng.below(12);
+                        if (rng.below(2)) site.taps |= uint64_t(1) << rng.below(12);
+                        site.polarity = rng.below(2);
+                        site.threshold = noise;
+                    } else {
+                        site.kind = SiteKind::Random;
+                    }
+                }
+                if (site.kind == SiteKind::Call) site.target = 0;   // set below, callees are not placed yet
+                sites.push_back(site);
+            }
+            function.returnPc = function.entry + 8 + 16 * options.bodySites;
+            functions.push_back(function);
+        }
+        for (Site& site : sites) {
+            if (site.kind == SiteKind::Call) site.target = functions[site.callee].entry;
+        }
+    }
+
+    // Bytes generateChunk may write for count branches
+    size_t chunkCapacity(size_t count) const {
+        return count * (options.format == TraceFormat::Binary ? BINARY_RECORD_SIZE : SYNTHETIC_MAX_LINE);
+    }
+
+    // Generate chunk `chunk` of count branches into out (chunkCapacity(count)
+    // bytes), returns the bytes written
+    size_t generateChunk(uint64_t chunk, size_t count, char* out) const {
+        return options.format == TraceFormat::Binary ? generate<true>(chunk, count, out)
+                                                     : generate<false>(chunk, count, out);
+    }
+
+    // Write the whole trace on the calling thread, the same bytes trace-gen writes
+    void writeTrace(TraceWriter& writer) const {
+        std::vector<char> buffer(chunkCapacity(options.chunkBranches));
+        for (uint64_t chunk = 0; chunk * options.chunkBranches < options.branches; chunk++) {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(options.chunkBranches,
+                                                                  options.branches - chunk * options.chunkBranches));
+            writer.writeRaw(buffer.data(), generateChunk(chunk, count, buffer.data()), count);
+        }
+    }
+
+private:
+    template <bool Binary>
+    size_t generate(uint64_t chunk, size_t count, char* out) const {
+        struct Frame {
+            uint32_t function;
+            uint32_t position;
+            uint64_t returnPc;
+        };
+        FastRng rng(options.seed ^ (0xD1B54A32D192ED03ULL * (chunk + 1)));
+        std::vector<Frame> stack;
+        stack.reserve(options.maxDepth + 1);
+        std::vector<uint32_t> iterations(sites.size(), 0);
+        uint64_t history = 0;
+
+        char* p = out;
+        size_t emitted = 0;
+
+        auto emit = [&](uint64_t pc, uint64_t target, char kind, bool direct, bool conditional, bool taken) {
+            p = writeRecord<Binary>(p, pc, target, kind, direct, conditional, taken);
+            emitted++;
+        };
+
+        while (emitted < count) {
+            if (stack.empty()) {
+                uint32_t f = static_cast<uint32_t>(rng.below(functions.size()));
+                emit(SYNTHETIC_DISPATCH_PC, functions[f].entry, 'c', true, false, true);
+                stack.push_back({f, 0, SYNTHETIC_DISPATCH_PC + 5});
+                continue;
+            }
+            Frame& frame = stack.back();
+            const Function& function = functions[frame.function];
+            if (frame.position == function.sites) {
+                emit(function.returnPc, frame.returnPc, 'r', false, false, true);
+                stack.pop_back();
+                continue;
+            }
+            size_t index = function.firstSite + frame.position;
+            const Site& site = sites[index];
+            bool taken = false;
+            switch (site.kind) {
+                case SiteKind::Loop:
+                    taken = ++iterations[index] < site.trip;
+                    if (taken) {
+                        frame.position -= site.span;
+                    } else {
+                        iterations[index] = 0;
+                        frame.position++;
+                    }
+                    break;
+                case SiteKind::Biased:
+                    taken = rng() < site.threshold;
+                    frame.position++;
+                    break;
+                case SiteKind::Correlated:
+                    taken = (__builtin_popcountll(history & site.taps) & 1) ^ site.polarity ^ (rng() < site.threshold);
+                    frame.position++;
+                    break;
+                case SiteKind::Random:
+                    taken = rng() & 1;
+                    frame.position++;
+                    break;
+                case SiteKind::Call:
+                    frame.position++;
+                    if (stack.size() >= options.maxDepth) continue;     // too deep, the call is skipped
+                    emit(site.pc, site.target, 'c', true, false, true);
+                    stack.push_back({site.callee, 0, site.pc + 5});     // capacity reserved, frame stays valid
+                    continue;
+                case SiteKind::Indirect: {
+                    uint64_t choice = (rng() < site.threshold) ? 0 : rng.below(site.trip);
+                    emit(site.pc, site.target + 0x40 * choice, 'b', false, false, true);
+                    frame.position++;
+                    continue;
+                }
+            }
+            emit(site.pc, site.target, 'b', true, true, taken);
+            history = (history << 1) | taken;
+        }
+        return p - out;
+    }
+
+    // One record at p in the trace format, returns the end of the record
+    template <bool Binary>
+    static char* writeRecord(char* p, uint64_t pc, uint64_t target, char kind, bool direct, bool conditional, bool taken) {
+        if constexpr (Binary) {
+            Branch branch;
+            branch.pc = pc;
+            branch.target = target;
+            branch.kind = kind;
+            branch.direct = direct;
+            branch.conditional = conditional;
+            branch.taken = taken;
+            encodeBinaryRecord(branch, p);
+            return p + BINARY_RECORD_SIZE;
+        }
+        p = writeHex(p, pc);
+        *p++ = ' ';
+        p = writeHex(p, target);
+        char fields[9] = {' ', kind, ' ', char('0' + direct), ' ', char('0' + conditional), ' ', char('0' + taken), '\n'};
+        std::memcpy(p, fields, sizeof(fields));
+        return p + sizeof(fields);
+    }
+
+    // The 8 nibbles of x as ASCII hex digits, most significant first in memory
+    static uint64_t hexDigits(uint32_t x) {
+        uint64_t v = x;
+        v = ((v & 0xFFFF0000ULL) << 16) | (v & 0xFFFFULL);
+        v = ((v & 0x0000FF000000FF00ULL) << 8) | (v & 0x000000FF000000FFULL);
+        v = ((v & 0x00F000F000F000F0ULL) << 4) | (v & 0x000F000F000F000FULL);     // byte i = nibble i
+        uint64_t letters = ((v + 0x0606060606060606ULL) >> 4) & 0x0101010101010101ULL;
+        v += 0x3030303030303030ULL + letters * ('a' - '0' - 10);
+        return __builtin_bswap64(v);
+    }
+
+    // Lowercase hex without leading zeros, as formatBranchLine writes it. Always
+    // stores 16 bytes, the line's remaining fields overwrite the excess.
+    static char* writeHex(char* p, uint64_t value) {
+        int length = value ? (67 - __builtin_clzll(value)) / 4 : 1;
+        uint64_t aligned = value << (64 - 4 * length);
+        uint64_t high = hexDigits(static_cast<uint32_t>(aligned >> 32));
+        uint64_t low = hexDigits(static_cast<uint32_t>(aligned));
+        std::memcpy(p, &high, 8);
+        std::memcpy(p + 8, &low, 8);
+        return p + length;
+    }
+};
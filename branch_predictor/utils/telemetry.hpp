@@ -0,0 +1,295 @@
+# pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <iomanip>
+#include <ctime>
+
+#include <unistd.h>
+
+// ==== live progress telemetry ====
+// Each evaluation job publishes its branch count and the consumed fraction
+// of its trace through relaxed atomics, once per batch. A reporter thread
+// samples them every interval and derives rate, ETA and process RSS; it
+// prints them to the terminal and/or rewrites a metrics file that node
+// monitoring can scrape (JSON if the name ends in .json, otherwise the
+// OpenMetrics text format). Every job gets a unique id label, as trace and
+// job name repeat (profiling passes, DSE sample and full runs). A finished
+// job is reported once with its final average rate and then dropped; the
+// finished jobs and their branches are kept as process totals. Nothing runs
+// unless telemetry is started.
+
+struct JobTelemetry {
+    uint64_t id = 0;
+    std::string trace;
+    std::string job;
+    std::atomic<uint64_t> branches{0};
+    std::atomic<double> consumed{0.0};      // fraction of the trace, 0 to 1
+    std::atomic<bool> finished{false};
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+
+    // reporter-side state of the previous sample
+    uint64_t lastBranches = 0;
+    double lastConsumed = 0.0;
+    double rate = 0.0;                      // branches per second
+    double eta = -1.0;                      // seconds, < 0 if unknown
+    bool done = false;                      // final average rate computed
+};
+
+inline uint64_t residentSetBytes() {
+    std::ifstream statm("/proc/self/statm");
+    uint64_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+}
+
+inline std::string escapeLabel(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+class Telemetry {
+private:
+    bool running = false;
+    bool terminal = false;
+    std::string metricsFile;
+    double interval = 1.0;
+
+    std::thread reporter;
+    std::mutex mutex;                   // guards the job list, totals and stopping, never held for I/O
+    std::condition_variable wake;
+    bool stopping = false;
+    std::vector<std::shared_ptr<JobTelemetry>> jobs;
+    uint64_t nextId = 0;
+    uint64_t finishedJobs = 0;          // jobs dropped after their final report
+    uint64_t finishedBranches = 0;
+    std::chrono::steady_clock::time_point lastSample;
+
+    void sample() {
+        auto now = std::chrono::steady_clock::now();
+        double dt = std::chrono::duration<double>(now - lastSample).count();
+        lastSample = now;
+        for (auto& job : jobs) {
+            if (job->done) continue;
+            uint64_t branches = job->branches.load(std::memory_order_relaxed);
+            double consumed = job->consumed.load(std::memory_order_relaxed);
+            if (dt > 0) job->rate = (branches - job->lastBranches) / dt;
+            if (job->finished.load(std::memory_order_relaxed)) {
+                double elapsed = std::chrono::duration<double>(now - job->started).count();
+                job->rate = elapsed > 0 ? branches / elapsed : 0.0;
+                job->eta = 0.0;
+                job->done = true;
+            } else if (consumed > job->lastConsumed && dt > 0) {
+                job->eta = (1.0 - consumed) / ((consumed - job->lastConsumed) / dt);
+            }
+            job->lastBranches = branches;
+            job->lastConsumed = consumed;
+        }
+    }
+
+    static std::string formatDuration(double seconds) {
+        if (seconds < 0) return "?";
+        uint64_t s = static_cast<uint64_t>(seconds + 0.5);
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%llu:%02llu:%02llu", (unsigned long long)(s / 3600),
+                 (unsigned long long)(s / 60 % 60), (unsigned long long)(s % 60));
+        return buffer;
+    }
+
+    // Progress lines of the running jobs, formatted locally so the format
+    // flags of std::cerr stay untouched for the threads sharing it
+    std::string formatTerminal(uint64_t rss) const {
+        std::ostringstream lines;
+        lines << std::fixed << std::setprecision(1);
+        for (const auto& job : jobs) {
+            if (job->finished.load(std::memory_order_relaxed)) continue;
+            lines << "[progress] " << job->trace << " / " << job->job << ": "
+                  << 100.0 * job->consumed.load(std::memory_order_relaxed) << "%, "
+                  << job->rate / 1e6 << " M branches/s, ETA " << formatDuration(job->eta)
+                  << ", RSS " << rss / (1024 * 1024) << " MB\n";
+        }
+        return lines.str();
+    }
+
+    std::string formatMetrics(uint64_t rss) const {
+        bool json = metricsFile.size() >= 5 && metricsFile.compare(metricsFile.size() - 5, 5, ".json") == 0;
+        std::ostringstream out;
+        out << std::setprecision(10);
+        if (json) {
+            out << "{\"timestamp\": " << std::time(nullptr) << ", \"rss_bytes\": " << rss
+                << ", \"finished_jobs\": " << finishedJobs << ", \"finished_branches\": " << finishedBranches
+                << ", \"jobs\": [";
+            for (size_t i = 0; i < jobs.size(); i++) {
+                const auto& job = jobs[i];
+                out << (i ? ", " : "") << "{\"id\": " << job->id << ", \"trace\": \"" << escapeLabel(job->trace) << "\", \"job\": \""
+                    << escapeLabel(job->job) << "\", \"branches\": " << job->branches.load(std::memory_order_relaxed)
+                    << ", \"progress\": " << job->consumed.load(std::memory_order_relaxed)
+                    << ", \"branches_per_second\": " << job->rate
+                    << ", \"eta_seconds\": " << job->eta
+                    << ", \"finished\": " << (job->finished.load(std::memory_order_relaxed) ? "true" : "false") << "}";
+            }
+            out << "]}\n";
+        } else {
+            auto series = [&](const char* name, const char* type, const char* help, auto value) {
+                out << "# TYPE " << name << " " << type << "\n# HELP " << name << " " << help << "\n";
+                for (const auto& job : jobs) {
+                    out << name << (std::string(type) == "counter" ? "_total" : "")
+                        << "{id=\"" << job->id << "\",trace=\"" << escapeLabel(job->trace) << "\",job=\"" << escapeLabel(job->job) << "\"} "
+                        << value(*job) << "\n";
+                }
+            };
+            series("bp_job_branches", "counter", "Branches simulated by the job.",
+                   [](const JobTelemetry& j) { return j.branches.load(std::memory_order_relaxed); });
+            series("bp_job_progress_ratio", "gauge", "Fraction of the trace consumed.",
+                   [](const JobTelemetry& j) { return j.consumed.load(std::memory_order_relaxed); });
+            series("bp_job_branches_per_second", "gauge", "Simulation rate over the last interval.",
+                   [](const JobTelemetry& j) { return j.rate; });
+            series("bp_job_eta_seconds", "gauge", "Estimated time to completion, -1 if unknown.",
+                   [](const JobTelemetry& j) { return j.eta; });
+            series("bp_job_finished", "gauge", "1 once the job has completed.",
+                   [](const JobTelemetry& j) { return j.finished.load(std::memory_order_relaxed) ? 1 : 0; });
+            out << "# TYPE bp_finished_jobs counter\n# HELP bp_finished_jobs Jobs completed and dropped from the job series.\n"
+                << "bp_finished_jobs_total " << finishedJobs << "\n"
+                << "# TYPE bp_finished_branches counter\n# HELP bp_finished_branches Branches simulated by the finished jobs.\n"
+                << "bp_finished_branches_total " << finishedBranches << "\n"
+                << "# TYPE bp_process_resident_memory_bytes gauge\n"
+                << "bp_process_resident_memory_bytes " << rss << "\n# EOF\n";
+        }
+
+        return out.str();
+    }
+
+    // Rewrite the metrics file atomically so scrapers never see a partial file
+    void writeMetrics(const std::string& metrics) const {
+        std::string tmpFile = metricsFile + ".tmp";
+        std::ofstream file(tmpFile);
+        if (!file.is_open()) return;
+        file << metrics;
+        file.close();
+        std::rename(tmpFile.c_str(), metricsFile.c_str());
+    }
+
+    // Drop the jobs whose final rate has been reported, keeping their totals
+    void dropFinished() {
+        auto finished = std::stable_partition(jobs.begin(), jobs.end(), [](const std::shared_ptr<JobTelemetry>& job) {
+            return !job->done;
+        });
+        for (auto it = finished; it != jobs.end(); ++it) {
+            finishedJobs++;
+            finishedBranches += (*it)->branches.load(std::memory_order_relaxed);
+        }
+        jobs.erase(finished, jobs.end());
+    }
+
+    // Sample and format under the lock, print and write outside of it
+    void report(bool final = false) {
+        uint64_t rss = residentSetBytes();
+        std::string lines, metrics;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (final) {
+                for (auto& job : jobs) job->finished.store(true, std::memory_order_relaxed);
+            }
+            sample();
+            if (terminal && !final) lines = formatTerminal(rss);
+            if (!metricsFile.empty()) metrics = formatMetrics(rss);
+            dropFinished();
+        }
+        if (!lines.empty()) std::cerr << lines << std::flush;
+        if (!metrics.empty()) writeMetrics(metrics);
+    }
+
+public:
+    ~Telemetry() { stop(); }
+
+    // Start the reporter; terminal prints progress lines to stderr, metricsFile
+    // (if not empty) is rewritten every interval seconds
+    void start(bool toTerminal, const std::string& file, double intervalSeconds) {
+        if (running) return;
+        terminal = toTerminal;
+        metricsFile = file;
+        interval = intervalSeconds;
+        running = true;
+        stopping = false;
+        lastSample = std::chrono::steady_clock::now();
+        reporter = std::thread([this]() {
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    if (wake.wait_for(lock, std::chrono::duration<double>(interval), [this]() { return stopping; })) {
+                        return;
+                    }
+                }
+                report();
+            }
+        });
+    }
+
+    // Stop the reporter after a final report
+    void stop() {
+        if (!running) return;
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        reporter.join();
+        report(true);
+        running = false;
+    }
+
+    bool isRunning() const { return running; }
+
+    std::shared_ptr<JobTelemetry> beginJob(const std::string& trace, const std::string& job) {
+        auto telemetry = std::make_shared<JobTelemetry>();
+        telemetry->trace = trace;
+        telemetry->job = job;
+        std::lock_guard<std::mutex> guard(mutex);
+        telemetry->id = nextId++;
+        jobs.push_back(telemetry);
+        return telemetry;
+    }
+};
+
+// Process-wide telemetry, started with --progress / --telemetry
+inline Telemetry& telemetry() {
+    static Telemetry instance;
+    return instance;
+}
+
+// Handle held by an evaluation loop; does nothing unless telemetry is running
+class TelemetryJob {
+private:
+    std::shared_ptr<JobTelemetry> job;
+
+public:
+    TelemetryJob(const std::string& trace, const std::string& name) {
+        if (telemetry().isRunning()) job = telemetry().beginJob(trace, name);
+    }
+
+    ~TelemetryJob() {
+        if (job) job->finished.store(true, std::memory_order_relaxed);
+    }
+
+    void update(uint64_t branches, double consumed) {
+        if (!job) return;
+        job->branches.store(branches, std::memory_order_relaxed);
+        job->consumed.store(consumed, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,400 @@
+# pragma once
+
+#include "predictor/branch.hpp"
+#include "utils/config.hpp"
+#include "utils/hash.hpp"
+#include "utils/trace_io.hpp"
+#include "utils/trace_columns.hpp"
+#include "utils/async_reader.hpp"
+#include "utils/branch_filter.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <fstream>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ==== shared decoded-trace cache ====
+// A decoded trace is published once per node as a file in config.SHM_CACHE_DIR
+// (tmpfs), named after the trace's content hash. The first process to need it
+// decodes the trace under an flock and publishes it with an atomic rename;
+// every later process maps the same pages read-only.
+//
+// Next to the segments, a stamp per trace path (bp-stamp-<path hash>) records
+// the size, mtime and content hash seen when it was published, so attaching
+// an unchanged trace does not read it again. When a trace changes, the
+// segment of its old content is evicted; clearSharedTraces() drops them all.
+//
+// Segment layout: CachedTraceHeader, then 64-byte aligned columns in the
+// order of BranchColumns: pc and target (uint64_t[count]), followed by the
+// kind-low, kind-high, direct, conditional and taken bit vectors
+// (uint64_t[ceil(count / 64)] each).
+
+const char TRACE_CACHE_MAGIC[8] = {'B', 'P', 'C', 'A', 'C', 'H', 'E', '2'};
+const size_t TRACE_CACHE_COLUMNS = 7;
+
+struct CachedTraceHeader {
+    char magic[8];
+    uint64_t contentHash;                       // hash of the source trace file
+    uint64_t count;                             // number of branches
+    uint64_t offsets[TRACE_CACHE_COLUMNS];      // byte offsets of the columns from the segment start
+    uint64_t totalSize;                         // size of the whole segment
+};
+
+inline uint64_t alignColumn(uint64_t offset) {
+    return (offset + 63) & ~uint64_t(63);
+}
+
+// Columnar decoded trace, backed by a shared read-only mapping or by heap columns
+class DecodedTrace {
+private:
+    void* mapping = nullptr;
+    size_t mappingSize = 0;
+    TraceColumns owned;
+    BranchColumns view;
+    uint64_t hash = 0;
+
+public:
+    DecodedTrace() = default;
+    DecodedTrace(const DecodedTrace&) = delete;
+    DecodedTrace& operator=(const DecodedTrace&) = delete;
+
+    ~DecodedTrace() {
+        if (mapping) munmap(mapping, mappingSize);
+    }
+
+    // Decode a text or binary trace into heap columns
+    static std::shared_ptr<DecodedTrace> decode(const std::string& traceFile, uint64_t contentHash = 0) {
+        auto trace = std::make_shared<DecodedTrace>();
+        TraceReader reader(traceFile);
+        size_t expected = reader.recordCount();
+        if (expected == 0) expected = reader.dataSize() / 32;   // typical text line length
+        trace->owned.reserve(expected);
+
+        Branch branch;
+        while (reader.next(branch)) {
+            trace->owned.push_back(branch);
+        }
+        trace->view = trace->owned.view();
+        trace->hash = contentHash;
+        return trace;
+    }
+
+    // Attach a published cache segment read-only, returns nullptr if it is missing or invalid
+    static std::shared_ptr<DecodedTrace> attach(const std::string& segmentPath, uint64_t contentHash) {
+        int fd = ::open(segmentPath.c_str(), O_RDONLY);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CachedTraceHeader)) {
+            ::close(fd);
+            return nullptr;
+        }
+        void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return nullptr;
+
+        auto trace = std::make_shared<DecodedTrace>();
+        trace->mapping = p;
+        trace->mappingSize = st.st_size;
+
+        const auto* header = static_cast<const CachedTraceHeader*>(p);
+        if (std::memcmp(header->magic, TRACE_CACHE_MAGIC, sizeof(TRACE_CACHE_MAGIC)) != 0 ||
+            header->contentHash != contentHash || header->totalSize != trace->mappingSize) {
+            return nullptr;
+        }
+        const char* base = static_cast<const char*>(p);
+        const uint64_t** pointers[TRACE_CACHE_COLUMNS] = {
+            &trace->view.pc, &trace->view.target, &trace->view.kindLow, &trace->view.kindHigh,
+            &trace->view.direct, &trace->view.conditional, &trace->view.taken,
+        };
+        for (size_t c = 0; c < TRACE_CACHE_COLUMNS; c++) {
+            *pointers[c] = reinterpret_cast<const uint64_t*>(base + header->offsets[c]);
+        }
+        trace->view.count = header->count;
+        trace->hash = contentHash;
+        return trace;
+    }
+
+    // Write this trace as a cache segment at path
+    void writeSegment(const std::string& path) const {
+        size_t count = view.count;
+        const uint64_t* columns[TRACE_CACHE_COLUMNS] = {
+            view.pc, view.target, view.kindLow, view.kindHigh, view.direct, view.conditional, view.taken,
+        };
+        size_t sizes[TRACE_CACHE_COLUMNS];
+
+        CachedTraceHeader header = {};
+        std::memcpy(header.magic, TRACE_CACHE_MAGIC, sizeof(TRACE_CACHE_MAGIC));
+        header.contentHash = hash;
+        header.count = count;
+        uint64_t offset = sizeof(CachedTraceHeader);
+        for (size_t c = 0; c < TRACE_CACHE_COLUMNS; c++) {
+            sizes[c] = (c < 2 ? count : bitWords(count)) * sizeof(uint64_t);
+            header.offsets[c] = alignColumn(offset);
+            offset = header.offsets[c] + sizes[c];
+        }
+        header.totalSize = offset;
+
+        // reserve the pages first: writing to a hole of a full tmpfs through
+        // the mapping would raise SIGBUS instead of failing here
+        int fd = ::open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+        if (fd < 0) throw std::runtime_error("Could not create " + path);
+        int error = posix_fallocate(fd, 0, static_cast<off_t>(header.totalSize));
+        if (error != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not allocate " + std::to_string(header.totalSize) + " bytes for " +
+                                     path + ": " + std::strerror(error));
+        }
+        void* p = mmap(nullptr, header.totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("Could not map " + path);
+
+        char* base = static_cast<char*>(p);
+        std::memcpy(base, &header, sizeof(header));
+        for (size_t c = 0; c < TRACE_CACHE_COLUMNS; c++) {
+            if (sizes[c] > 0) std::memcpy(base + header.offsets[c], columns[c], sizes[c]);
+        }
+        munmap(p, header.totalSize);
+    }
+
+    size_t size() const { return view.count; }
+    uint64_t contentHash() const { return hash; }
+    bool isShared() const { return mapping != nullptr; }
+
+    const BranchColumns& columns() const { return view; }
+    Branch branch(size_t i) const { return view[i]; }
+};
+
+
+// Sequential reader over a decoded trace
+class DecodedTraceReader final : public BranchSource {
+private:
+    std::shared_ptr<const DecodedTrace> trace;
+    size_t cursor = 0;
+
+public:
+    explicit DecodedTraceReader(std::shared_ptr<const DecodedTrace> decoded) : trace(std::move(decoded)) {}
+
+    bool next(Branch& branch) override {
+        if (cursor >= trace->size()) return false;
+        branch = trace->branch(cursor++);
+        return true;
+    }
+
+    size_t nextBatch(Branch* out, size_t count) override {
+        size_t n = std::min(count, trace->size() - cursor);
+        trace->columns().gather(cursor, n, out);
+        cursor += n;
+        return n;
+    }
+
+    // Only the pc column and flag bits are streamed
+    size_t nextDirectionBatch(Branch* out, size_t count) override {
+        size_t n = std::min(count, trace->size() - cursor);
+        trace->columns().gather(cursor, n, out, true);
+        cursor += n;
+        return n;
+    }
+
+    size_t skip(size_t count) override {
+        size_t n = std::min(count, trace->size() - cursor);
+        cursor += n;
+        return n;
+    }
+
+    // Direction batch of the records among the next count that the filter
+    // selects, tested on the flag bit columns; consumed returns the records passed
+    size_t nextSelectedBatch(Branch* out, size_t count, const BranchFilter& filter, size_t& consumed) {
+        consumed = std::min(count, trace->size() - cursor);
+        size_t n = filter.gatherSelected(trace->columns(), cursor, cursor + consumed, out);
+        cursor += consumed;
+        return n;
+    }
+
+    double progress() const override {
+        return trace->size() > 0 ? static_cast<double>(cursor) / trace->size() : 1.0;
+    }
+};
+
+
+// Size, mtime and content hash of a trace file as last published
+struct TraceStamp {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t contentHash = 0;
+};
+
+inline std::string traceStampPath(const std::string& traceFile) {
+    std::string path = std::filesystem::absolute(traceFile).lexically_normal().string();
+    return config.SHM_CACHE_DIR + "/bp-stamp-" + hashToHex(hashString(path));
+}
+
+inline std::string traceSegmentPath(uint64_t contentHash) {
+    return config.SHM_CACHE_DIR + "/bp-trace-" + hashToHex(contentHash);
+}
+
+inline bool readTraceStamp(const std::string& stampPath, TraceStamp& stamp) {
+    std::ifstream in(stampPath);
+    return static_cast<bool>(in >> stamp.size >> stamp.mtime >> stamp.contentHash);
+}
+
+inline void writeTraceStamp(const std::string& stampPath, const TraceStamp& stamp) {
+    std::string tmpPath = stampPath + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(tmpPath);
+        out << stamp.size << " " << stamp.mtime << " " << stamp.contentHash << "\n";
+    }
+    if (std::rename(tmpPath.c_str(), stampPath.c_str()) != 0) ::unlink(tmpPath.c_str());
+}
+
+// Remove every segment, stamp and lock file of the cache, returns the number removed
+inline size_t clearSharedTraces() {
+    size_t removed = 0;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(config.SHM_CACHE_DIR, ec)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("bp-trace-", 0) == 0 || name.rfind("bp-stamp-", 0) == 0) {
+            removed += std::filesystem::remove(entry.path(), ec);
+        }
+    }
+    return removed;
+}
+
+// Exclusive flock on a lock file, held until the guard goes out of scope
+class SegmentLock {
+private:
+    int fd = -1;
+
+public:
+    explicit SegmentLock(const std::string& path) {
+        fd = ::open(path.c_str(), O_CREAT | O_RDWR, 0666);
+        if (fd >= 0) flock(fd, LOCK_EX);
+    }
+    SegmentLock(const SegmentLock&) = delete;
+    SegmentLock& operator=(const SegmentLock&) = delete;
+
+    ~SegmentLock() {
+        if (fd < 0) return;
+        flock(fd, LOCK_UN);
+        ::close(fd);
+    }
+
+    bool held() const { return fd >= 0; }
+};
+
+// Attach the node-wide decoded copy of a trace, publishing it first if needed
+std::shared_ptr<const DecodedTrace> attachSharedTrace(const std::string& traceFile) {
+    // traces stay attached for the lifetime of the process
+    static std::mutex registryMutex;
+    static std::map<std::string, std::shared_ptr<const DecodedTrace>> attached;
+    std::lock_guard<std::mutex> guard(registryMutex);
+    auto it = attached.find(traceFile);
+    if (it != attached.end()) return it->second;
+
+    struct stat st;
+    if (stat(traceFile.c_str(), &st) != 0) {
+        std::cerr << "Error: Could not open file " << traceFile << std::endl;
+        throw std::runtime_error("File not found");
+    }
+    TraceStamp current;
+    current.size = static_cast<uint64_t>(st.st_size);
+    current.mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+    // the trace is only hashed when its stamp changed since it was published
+    std::string stampPath = traceStampPath(traceFile);
+    TraceStamp recorded;
+    bool unchanged = readTraceStamp(stampPath, recorded) && recorded.size == current.size &&
+                     recorded.mtime == current.mtime;
+    current.contentHash = unchanged ? recorded.contentHash : hashFile(traceFile);
+    uint64_t contentHash = current.contentHash;
+    std::string segmentPath = traceSegmentPath(contentHash);
+
+    std::shared_ptr<DecodedTrace> trace = DecodedTrace::attach(segmentPath, contentHash);
+    if (!trace) {
+        // serialise publishers of the same trace, re-check once the lock is held;
+        // the lock is released on every path, including parse errors
+        SegmentLock lock(segmentPath + ".lock");
+        if (!lock.held()) {
+            std::cerr << "Warning: trace cache unavailable in " << config.SHM_CACHE_DIR
+                      << ", decoding " << traceFile << " privately" << std::endl;
+            trace = DecodedTrace::decode(traceFile, contentHash);
+        } else {
+            trace = DecodedTrace::attach(segmentPath, contentHash);
+            if (!trace) {
+                std::shared_ptr<DecodedTrace> decoded = DecodedTrace::decode(traceFile, contentHash);
+                std::cout << "Publishing decoded " << traceFile << " to " << segmentPath << std::endl;
+                std::string tmpPath = segmentPath + ".tmp." + std::to_string(getpid());
+                try {
+                    decoded->writeSegment(tmpPath);
+                    if (std::rename(tmpPath.c_str(), segmentPath.c_str()) != 0) {
+                        throw std::runtime_error("Could not publish " + segmentPath);
+                    }
+                    trace = DecodedTrace::attach(segmentPath, contentHash);
+                    if (!trace) throw std::runtime_error("Could not attach " + segmentPath);
+                } catch (const std::exception& e) {
+                    ::unlink(tmpPath.c_str());
+                    std::cerr << "Warning: " << e.what() << ", using " << traceFile << " privately" << std::endl;
+                    trace = decoded;
+                }
+            }
+        }
+    }
+    if (!unchanged && trace->isShared()) {
+        // the trace changed since its last publication, evict the old content
+        if (recorded.contentHash != 0 && recorded.contentHash != contentHash) {
+            std::string oldPath = traceSegmentPath(recorded.contentHash);
+            ::unlink(oldPath.c_str());
+            ::unlink((oldPath + ".lock").c_str());
+        }
+        writeTraceStamp(stampPath, current);
+    }
+    attached[traceFile] = trace;
+    return trace;
+}
+
+// Direction batch of the records among the next count of reader that the
+// filter selects, consumed returns the records read (0 at the end of the trace)
+inline size_t nextFilteredBatch(BranchSource& reader, const BranchFilter& filter, Branch* out, size_t count,
+                                size_t& consumed) {
+    if (auto* decoded = dynamic_cast<DecodedTraceReader*>(&reader)) {
+        return decoded->nextSelectedBatch(out, count, filter, consumed);
+    }
+    consumed = reader.nextDirectionBatch(out, count);
+    return filter.compact(out, consumed);
+}
+
+// Open a trace for sequential reading, through the shared cache or the
+// asynchronous reader when they are enabled. With skipMalformed, malformed
+// text lines are skipped and counted; the shared cache only holds traces
+// without them, others are streamed privately.
+std::unique_ptr<BranchSource> openTrace(const std::string& traceFile, bool skipMalformed = false) {
+    if (config.SHM_TRACE_CACHE) {
+        try {
+            return std::make_unique<DecodedTraceReader>(attachSharedTrace(traceFile));
+        } catch (const TraceParseError& e) {
+            if (!skipMalformed) throw;
+            std::cerr << "Warning: " << traceFile << ": " << e.what()
+                      << ", reading it without the trace cache" << std::endl;
+        }
+    }
+    std::unique_ptr<BranchSource> reader;
+    if (config.ASYNC_TRACE_IO) {
+        reader = std::make_unique<AsyncTraceReader>(traceFile);
+    } else {
+        reader = std::make_unique<TraceReader>(traceFile);
+    }
+    reader->setSkipMalformed(skipMalformed);
+    return reader;
+}
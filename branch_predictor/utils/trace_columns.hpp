@@ -0,0 +1,236 @@
+# pragma once
+
+#include "predictor/branch.hpp"
+#include "predictor/table_memory.hpp"
+#include "utils/trace_io.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <iterator>
+
+// ==== bit-packed columns ====
+
+inline bool testBit(const uint64_t* words, size_t i) {
+    return (words[i >> 6] >> (i & 63)) & 1;
+}
+
+inline size_t bitWords(size_t bits) {
+    return (bits + 63) / 64;
+}
+
+// Number of set bits in [begin, end)
+inline size_t countBits(const uint64_t* words, size_t begin, size_t end) {
+    if (begin >= end) return 0;
+    size_t first = begin >> 6, last = (end - 1) >> 6;
+    uint64_t headMask = ~uint64_t(0) << (begin & 63);
+    uint64_t tailMask = ~uint64_t(0) >> (63 - ((end - 1) & 63));
+    if (first == last) return __builtin_popcountll(words[first] & headMask & tailMask);
+    size_t total = __builtin_popcountll(words[first] & headMask);
+    for (size_t w = first + 1; w < last; w++) total += __builtin_popcountll(words[w]);
+    return total + __builtin_popcountll(words[last] & tailMask);
+}
+
+// Number of positions in [0, bits) set in both a and b
+inline size_t countBitsAnd(const uint64_t* a, const uint64_t* b, size_t bits) {
+    size_t total = 0;
+    size_t full = bits >> 6;
+    for (size_t w = 0; w < full; w++) total += __builtin_popcountll(a[w] & b[w]);
+    if (bits & 63) total += __builtin_popcountll(a[full] & b[full] & ((uint64_t(1) << (bits & 63)) - 1));
+    return total;
+}
+
+// Append-only bit vector stored in 64-bit words
+class BitColumn {
+private:
+    TableVector<uint64_t> words;
+    size_t bits = 0;
+
+public:
+    void push_back(bool value) {
+        if ((bits & 63) == 0) words.push_back(0);
+        words.back() |= uint64_t(value) << (bits & 63);
+        bits++;
+    }
+
+    bool operator[](size_t i) const { return testBit(words.data(), i); }
+    const uint64_t* data() const { return words.data(); }
+    size_t size() const { return bits; }
+    void reserve(size_t n) { words.reserve(bitWords(n)); }
+    void clear() { words.clear(); bits = 0; }
+};
+
+
+// ==== columnar trace view ====
+// PCs and targets are stored as plain columns, the branch kind (2 bits) and
+// the direct/conditional/taken flags as bit vectors. Direction-only
+// consumers touch the pc column and the taken bits, about 8 bytes per branch.
+struct BranchColumns {
+    const uint64_t* pc = nullptr;
+    const uint64_t* target = nullptr;
+    const uint64_t* kindLow = nullptr;      // bit 0 of the kind code (see encodeBranchKind)
+    const uint64_t* kindHigh = nullptr;     // bit 1 of the kind code
+    const uint64_t* direct = nullptr;
+    const uint64_t* conditional = nullptr;
+    const uint64_t* taken = nullptr;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+
+    bool isTaken(size_t i) const { return testBit(taken, i); }
+    bool isConditional(size_t i) const { return testBit(conditional, i); }
+    bool isDirect(size_t i) const { return testBit(direct, i); }
+    uint8_t kindCode(size_t i) const { return testBit(kindLow, i) | (testBit(kindHigh, i) << 1); }
+
+    Branch operator[](size_t i) const {
+        Branch branch;
+        branch.pc = pc[i];
+        branch.target = target[i];
+        branch.kind = decodeBranchKind(kindCode(i));
+        branch.direct = isDirect(i);
+        branch.conditional = isConditional(i);
+        branch.taken = isTaken(i);
+        return branch;
+    }
+
+    // Copy branches [begin, begin + n) into out; with directionOnly the
+    // target column is not read and target is left zero
+    void gather(size_t begin, size_t n, Branch* out, bool directionOnly = false) const {
+        for (size_t i = 0; i < n; i++) {
+            size_t j = begin + i;
+            out[i].pc = pc[j];
+            out[i].target = directionOnly ? 0 : target[j];
+            out[i].kind = decodeBranchKind(kindCode(j));
+            out[i].direct = isDirect(j);
+            out[i].conditional = isConditional(j);
+            out[i].taken = isTaken(j);
+        }
+    }
+
+    // ==== vectorised counts over the flag bits ====
+    size_t countTaken() const { return countBits(taken, 0, count); }
+    size_t countDirect() const { return countBits(direct, 0, count); }
+    size_t countConditional() const { return countBits(conditional, 0, count); }
+    size_t countConditionalTaken() const { return countBitsAnd(conditional, taken, count); }
+
+    // Branches of a kind code (0 = b, 1 = c, 2 = r, 3 = other)
+    size_t countKind(uint8_t code) const {
+        size_t total = 0;
+        size_t words = bitWords(count);
+        for (size_t w = 0; w < words; w++) {
+            uint64_t low = (code & 1) ? kindLow[w] : ~kindLow[w];
+            uint64_t high = (code & 2) ? kindHigh[w] : ~kindHigh[w];
+            uint64_t match = low & high;
+            if (w == words - 1 && (count & 63)) match &= (uint64_t(1) << (count & 63)) - 1;
+            total += __builtin_popcountll(match);
+        }
+        return total;
+    }
+
+    // Random-access iterator yielding Branch values, so existing code can walk the columns
+    class iterator {
+    private:
+        const BranchColumns* columns;
+        size_t index;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Branch;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Branch;
+
+        iterator(const BranchColumns* c, size_t i) : columns(c), index(i) {}
+
+        Branch operator*() const { return (*columns)[index]; }
+        Branch operator[](difference_type n) const { return (*columns)[index + n]; }
+        iterator& operator++() { index++; return *this; }
+        iterator operator++(int) { iterator copy = *this; index++; return copy; }
+        iterator& operator--() { index--; return *this; }
+        iterator operator--(int) { iterator copy = *this; index--; return copy; }
+        iterator& operator+=(difference_type n) { index += n; return *this; }
+        iterator& operator-=(difference_type n) { index -= n; return *this; }
+        iterator operator+(difference_type n) const { return iterator(columns, index + n); }
+        iterator operator-(difference_type n) const { return iterator(columns, index - n); }
+        difference_type operator-(const iterator& other) const {
+            return static_cast<difference_type>(index) - static_cast<difference_type>(other.index);
+        }
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+        bool operator<(const iterator& other) const { return index < other.index; }
+    };
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, count); }
+};
+
+
+// Owning columnar trace container
+class TraceColumns {
+private:
+    TableVector<uint64_t> pcs;
+    TableVector<uint64_t> targets;
+    BitColumn kindLow;
+    BitColumn kindHigh;
+    BitColumn direct;
+    BitColumn conditional;
+    BitColumn taken;
+
+public:
+    void push_back(const Branch& branch) {
+        uint8_t code = encodeBranchKind(branch.kind);
+        pcs.push_back(branch.pc);
+        targets.push_back(branch.target);
+        kindLow.push_back(code & 1);
+        kindHigh.push_back(code & 2);
+        direct.push_back(branch.direct);
+        conditional.push_back(branch.conditional);
+        taken.push_back(branch.taken);
+    }
+
+    void reserve(size_t n) {
+        pcs.reserve(n);
+        targets.reserve(n);
+        kindLow.reserve(n);
+        kindHigh.reserve(n);
+        direct.reserve(n);
+        conditional.reserve(n);
+        taken.reserve(n);
+    }
+
+    void clear() {
+        pcs.clear();
+        targets.clear();
+        kindLow.clear();
+        kindHigh.clear();
+        direct.clear();
+        conditional.clear();
+        taken.clear();
+    }
+
+    size_t size() const { return pcs.size(); }
+    Branch operator[](size_t i) const { return view()[i]; }
+
+    BranchColumns view() const {
+        BranchColumns columns;
+        columns.pc = pcs.data();
+        columns.target = targets.data();
+        columns.kindLow = kindLow.data();
+        columns.kindHigh = kindHigh.data();
+        columns.direct = direct.data();
+        columns.conditional = conditional.data();
+        columns.taken = taken.data();
+        columns.count = pcs.size();
+        return columns;
+    }
+};
+
+// Replace the contents of out with up to count branches from source, returns the number read
+inline size_t readColumns(BranchSource& source, TraceColumns& out, size_t count) {
+    out.clear();
+    Branch branch;
+    while (out.size() < count && source.next(branch)) {
+        out.push_back(branch);
+    }
+    return out.size();
+}
@@ -0,0 +1,415 @@
+# pragma once
+
+#include "predictor/branch.hpp"
+
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ==== trace file formats ====
+// Text:   one branch per line, "pc target kind direct conditional taken"
+//         with pc/target in hex, e.g. "55a233e5ab62 55a233e5ab80 b 1 1 0"
+// Binary: 16-byte header ("BPTRACE1" + little-endian record count)
+//         followed by fixed 17-byte records (pc, target, packed flags)
+enum class TraceFormat { Text, Binary };
+
+const char BINARY_TRACE_MAGIC[8] = {'B', 'P', 'T', 'R', 'A', 'C', 'E', '1'};
+const size_t BINARY_TRACE_HEADER_SIZE = 16;
+const size_t BINARY_RECORD_SIZE = 17;
+
+// Packed flags byte: bits 0-1 kind (b=0, c=1, r=2, other=3),
+// bit 2 direct, bit 3 conditional, bit 4 taken
+const uint8_t FLAG_DIRECT = 1 << 2;
+const uint8_t FLAG_CONDITIONAL = 1 << 3;
+const uint8_t FLAG_TAKEN = 1 << 4;
+
+inline uint8_t encodeBranchKind(char kind) {
+    switch (kind) {
+        case 'b': return 0;
+        case 'c': return 1;
+        case 'r': return 2;
+        default:  return 3;
+    }
+}
+
+inline char decodeBranchKind(uint8_t code) {
+    static const char kinds[4] = {'b', 'c', 'r', '?'};
+    return kinds[code & 3];
+}
+
+inline uint8_t packBranchFlags(const Branch& branch) {
+    return encodeBranchKind(branch.kind)
+         | (branch.direct ? FLAG_DIRECT : 0)
+         | (branch.conditional ? FLAG_CONDITIONAL : 0)
+         | (branch.taken ? FLAG_TAKEN : 0);
+}
+
+inline void unpackBranchFlags(uint8_t flags, Branch& branch) {
+    branch.kind = decodeBranchKind(flags);
+    branch.direct = flags & FLAG_DIRECT;
+    branch.conditional = flags & FLAG_CONDITIONAL;
+    branch.taken = flags & FLAG_TAKEN;
+}
+
+inline void decodeBinaryRecord(const char* record, Branch& branch) {
+    std::memcpy(&branch.pc, record, 8);
+    std::memcpy(&branch.target, record + 8, 8);
+    unpackBranchFlags(static_cast<uint8_t>(record[16]), branch);
+}
+
+inline void encodeBinaryRecord(const Branch& branch, char* record) {
+    std::memcpy(record, &branch.pc, 8);
+    std::memcpy(record + 8, &branch.target, 8);
+    record[16] = static_cast<char>(packBranchFlags(branch));
+}
+
+// Parse a hex number, advancing p; returns false if no digit was found
+inline bool parseHex(const char*& p, const char* end, uint64_t& value) {
+    value = 0;
+    const char* start = p;
+    while (p < end) {
+        char c = *p;
+        unsigned digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+        else break;
+        value = (value << 4) | digit;
+        p++;
+    }
+    return p != start;
+}
+
+inline void skipBlanks(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+}
+
+inline bool parseFlag(const char*& p, const char* end, bool& flag) {
+    skipBlanks(p, end);
+    if (p >= end || (*p != '0' && *p != '1')) return false;
+    flag = (*p++ == '1');
+    return true;
+}
+
+// Fast allocation-free parser for one text trace line [begin, end)
+inline bool parseBranchLine(const char* begin, const char* end, Branch& branch) {
+    const char* p = begin;
+    skipBlanks(p, end);
+    if (!parseHex(p, end, branch.pc)) return false;
+    skipBlanks(p, end);
+    if (!parseHex(p, end, branch.target)) return false;
+    skipBlanks(p, end);
+    if (p >= end) return false;
+    branch.kind = *p++;
+    return parseFlag(p, end, branch.direct)
+        && parseFlag(p, end, branch.conditional)
+        && parseFlag(p, end, branch.taken);
+}
+
+// Format one branch as a text trace line (including the newline), returns length
+inline size_t formatBranchLine(const Branch& branch, char* out, size_t capacity) {
+    int n = std::snprintf(out, capacity, "%llx %llx %c %d %d %d\n",
+                          static_cast<unsigned long long>(branch.pc),
+                          static_cast<unsigned long long>(branch.target),
+                          branch.kind, branch.direct, branch.conditional, branch.taken);
+    return n > 0 ? static_cast<size_t>(n) : 0;
+}
+
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+private:
+    const char* mapped = nullptr;
+    size_t length = 0;
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    explicit MappedFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open file " << path << std::endl;
+            throw std::runtime_error("File not found");
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Could not stat " + path);
+        }
+        length = static_cast<size_t>(st.st_size);
+        if (length > 0) {
+            void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Could not map " + path);
+            }
+            madvise(p, length, MADV_SEQUENTIAL);
+            mapped = static_cast<const char*>(p);
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (mapped) munmap(const_cast<char*>(mapped), length);
+    }
+
+    const char* data() const { return mapped; }
+    size_t size() const { return length; }
+};
+
+
+// A text trace line the parser rejected
+class TraceParseError : public std::runtime_error {
+public:
+    explicit TraceParseError(const std::string& line) : std::runtime_error("Error parsing line: " + line) {}
+};
+
+
+// Sequential source of decoded branches
+class BranchSource {
+protected:
+    bool skipMalformed = false;
+    size_t skipped = 0;
+
+    // Throws for a line the parser rejected, or counts it when malformed lines are skipped
+    void rejectLine(const char* line, const char* lineEnd) {
+        if (!skipMalformed) throw TraceParseError(std::string(line, lineEnd));
+        skipped++;
+    }
+
+public:
+    virtual ~BranchSource() {}
+
+    // Skip malformed text lines instead of throwing, counting them in skippedLines()
+    void setSkipMalformed(bool skip) { skipMalformed = skip; }
+    size_t skippedLines() const { return skipped; }
+
+    // Decode the next branch, returns false at end of trace
+    virtual bool next(Branch& branch) = 0;
+
+    // Decode up to count branches into out, returns the number decoded
+    virtual size_t nextBatch(Branch* out, size_t count) = 0;
+
+    // Like nextBatch, for direction predictors: only pc and the flags are
+    // guaranteed, columnar sources leave target zero to save bandwidth
+    virtual size_t nextDirectionBatch(Branch* out, size_t count) {
+        return nextBatch(out, count);
+    }
+
+    // Skip up to count records without decoding them, returns the number skipped
+    virtual size_t skip(size_t count) = 0;
+
+    // Fraction of the trace consumed so far, 0 to 1, for progress reporting
+    virtual double progress() const { return 0.0; }
+};
+
+
+// Streaming reader for text and binary traces, the format is detected from the header
+class TraceReader final : public BranchSource {
+private:
+    MappedFile file;
+    TraceFormat traceFormat = TraceFormat::Text;
+    const char* begin = nullptr;    // first record
+    const char* cursor = nullptr;   // next record
+    const char* end = nullptr;      // end of data
+
+public:
+    explicit TraceReader(const std::string& path) : file(path) {
+        begin = file.data();
+        end = file.data() + file.size();
+        if (file.size() >= BINARY_TRACE_HEADER_SIZE &&
+            std::memcmp(file.data(), BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC)) == 0) {
+            traceFormat = TraceFormat::Binary;
+            begin += BINARY_TRACE_HEADER_SIZE;
+            // ignore a truncated trailing record
+            end = begin + ((end - begin) / BINARY_RECORD_SIZE) * BINARY_RECORD_SIZE;
+        }
+        cursor = begin;
+    }
+
+    TraceFormat format() const { return traceFormat; }
+
+    bool next(Branch& branch) override {
+        if (traceFormat == TraceFormat::Binary) {
+            if (cursor >= end) return false;
+            decodeBinaryRecord(cursor, branch);
+            cursor += BINARY_RECORD_SIZE;
+            return true;
+        }
+        while (cursor < end) {
+            const char* lineEnd = lineEndOf(cursor);
+            const char* line = cursor;
+            cursor = (lineEnd < end) ? lineEnd + 1 : end;
+            if (lineEnd == line) continue;  // skip empty lines
+            if (!parseBranchLine(line, lineEnd, branch)) {
+                rejectLine(line, lineEnd);
+                continue;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    size_t nextBatch(Branch* out, size_t count) override {
+        size_t n = 0;
+        while (n < count && next(out[n])) n++;
+        return n;
+    }
+
+    size_t skip(size_t count) override {
+        if (traceFormat == TraceFormat::Binary) {
+            size_t available = (end - cursor) / BINARY_RECORD_SIZE;
+            size_t n = std::min(count, available);
+            cursor += n * BINARY_RECORD_SIZE;
+            return n;
+        }
+        size_t n = 0;
+        while (n < count && cursor < end) {
+            const char* lineEnd = lineEndOf(cursor);
+            if (lineEnd != cursor) n++;
+            cursor = (lineEnd < end) ? lineEnd + 1 : end;
+        }
+        return n;
+    }
+
+    // Move to the first record at or after the given byte offset into the data
+    void seek(size_t offset) {
+        offset = std::min(offset, static_cast<size_t>(end - begin));
+        if (traceFormat == TraceFormat::Binary) {
+            size_t record = (offset + BINARY_RECORD_SIZE - 1) / BINARY_RECORD_SIZE;
+            cursor = std::min(begin + record * BINARY_RECORD_SIZE, end);
+            return;
+        }
+        cursor = begin + offset;
+        if (cursor > begin && cursor < end && cursor[-1] != '\n') {
+            const char* lineEnd = lineEndOf(cursor);
+            cursor = (lineEnd < end) ? lineEnd + 1 : end;
+        }
+    }
+
+    // Move to the start of the last count records of the trace
+    void seekTail(size_t count) {
+        if (traceFormat == TraceFormat::Binary) {
+            size_t total = (end - begin) / BINARY_RECORD_SIZE;
+            cursor = begin + (total - std::min(count, total)) * BINARY_RECORD_SIZE;
+            return;
+        }
+        if (count == 0) { cursor = end; return; }
+        const char* p = end;
+        if (p > begin && p[-1] == '\n') p--;  // trailing newline of the last line
+        size_t lines = 0;
+        while (p > begin) {
+            const void* nl = memrchr(begin, '\n', p - begin);
+            const char* lineStart = nl ? static_cast<const char*>(nl) + 1 : begin;
+            if (lineStart != p && ++lines == count) { p = lineStart; break; }
+            p = nl ? static_cast<const char*>(nl) : begin;
+        }
+        cursor = p;
+    }
+
+    // Raw access for byte-exact copies of record ranges
+    const char* position() const { return cursor; }
+    const char* dataBegin() const { return begin; }
+    const char* dataEnd() const { return end; }
+
+    // Progress in bytes through the data section
+    size_t bytesConsumed() const { return cursor - begin; }
+    size_t dataSize() const { return end - begin; }
+
+    double progress() const override {
+        return (end > begin) ? static_cast<double>(cursor - begin) / (end - begin) : 1.0;
+    }
+
+    // Number of records, only known up front for binary traces
+    size_t recordCount() const {
+        return traceFormat == TraceFormat::Binary ? (end - begin) / BINARY_RECORD_SIZE : 0;
+    }
+
+private:
+    const char* lineEndOf(const char* p) const {
+        const void* nl = std::memchr(p, '\n', end - p);
+        return nl ? static_cast<const char*>(nl) : end;
+    }
+};
+
+
+// Buffered writer for text and binary traces
+class TraceWriter {
+private:
+    std::FILE* out = nullptr;
+    TraceFormat traceFormat;
+    uint64_t records = 0;
+    std::string path;
+
+public:
+    TraceWriter(const std::string& filepath, TraceFormat format) : traceFormat(format), path(filepath) {
+        out = std::fopen(filepath.c_str(), "wb");
+        if (!out) {
+            std::cerr << "Error: Could not create file " << filepath << std::endl;
+            throw std::runtime_error("Could not create file");
+        }
+        std::setvbuf(out, nullptr, _IOFBF, 1 << 22);
+        if (traceFormat == TraceFormat::Binary) {
+            char header[BINARY_TRACE_HEADER_SIZE] = {};
+            std::memcpy(header, BINARY_TRACE_MAGIC, sizeof(BINARY_TRACE_MAGIC));
+            std::fwrite(header, 1, sizeof(header), out);
+        }
+    }
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    ~TraceWriter() {
+        try { close(); } catch (...) {}
+    }
+
+    TraceFormat format() const { return traceFormat; }
+    uint64_t recordsWritten() const { return records; }
+
+    void write(const Branch& branch) {
+        if (traceFormat == TraceFormat::Binary) {
+            char record[BINARY_RECORD_SIZE];
+            encodeBinaryRecord(branch, record);
+            std::fwrite(record, 1, sizeof(record), out);
+        } else {
+            char line[64];
+            size_t n = formatBranchLine(branch, line, sizeof(line));
+            std::fwrite(line, 1, n, out);
+        }
+        records++;
+    }
+
+    // Copy already encoded records (same format as this writer) verbatim
+    void writeRaw(const char* data, size_t bytes, size_t recordCount) {
+        std::fwrite(data, 1, bytes, out);
+        // the last line of a text trace may lack its newline
+        if (traceFormat == TraceFormat::Text && bytes > 0 && data[bytes - 1] != '\n') {
+            std::fputc('\n', out);
+        }
+        records += recordCount;
+    }
+
+    void close() {
+        if (!out) return;
+        if (traceFormat == TraceFormat::Binary) {
+            // patch the record count into the header
+            std::fseek(out, sizeof(BINARY_TRACE_MAGIC), SEEK_SET);
+            std::fwrite(&records, sizeof(records), 1, out);
+        }
+        bool failed = std::ferror(out) != 0;
+        failed |= std::fclose(out) != 0;
+        out = nullptr;
+        if (failed) throw std::runtime_error("Error writing " + path);
+    }
+};
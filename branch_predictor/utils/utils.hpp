@@ -2,6 +2,12 @@
 
 #include "predictor/branch.hpp"
 #include "predictor/predictor.hpp"
+#include "utils/trace_io.hpp"
+#include "utils/trace_cache.hpp"
+#include "utils/branch_filter.hpp"
+#include "utils/perf_counters.hpp"
+#include "utils/telemetry.hpp"
+#include "utils/config.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -13,6 +19,8 @@
 #include <deque>
 #include <stack>
 
+// Branches decoded and handed to BranchPredictor::processBatch at a time
+const size_t EVALUATION_BATCH_SIZE = 4096;
 
 // Helper function to get trace file name without path and extension
 std::string getTraceBaseName(const std::string& filepath) {
@@ -32,6 +40,12 @@ std::string getTraceBaseName(const std::string& filepath) {
     return filename;
 }
 
+// Stream of the evaluators' per-predictor summaries, discarded unless config.EVALUATION_LOG
+inline std::ostream& evaluationLog() {
+    static std::ostream discard(nullptr);
+    return config.EVALUATION_LOG ? std::cout : discard;
+}
+
 // Utility function to parse a line from the trace file
 Branch parseLineToBranch(const std::string& line) {
     Branch branch;
@@ -50,196 +64,256 @@ Branch parseLineToBranch(const std::string& line) {
 }
 
 
-// Function to evaluate a predictor on a trace file, returning the total branches and mispredictions
-std::vector<size_t> evaluatePredictor(BranchPredictor& predictor, const std::string& traceFile, size_t maxLines = 0) {
-    std::ifstream file(traceFile);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << traceFile << std::endl;
-        throw std::runtime_error("File not found");
-    }
+// Function to evaluate a predictor on a trace file, returning the total branches and mispredictions.
+// Only the records selected by filter are predicted and counted, maxLines counts trace records;
+// classes, if given, receives the counts per branch class.
+std::vector<size_t> evaluatePredictor(BranchPredictor& predictor, const std::string& traceFile, size_t maxLines = 0,
+                                      const BranchFilter& filter = BranchFilter(), ClassCounts* classes = nullptr) {
+    perfProfiler().beginJob(getTraceBaseName(traceFile), predictor.getName());
+    perfProfiler().enter(PerfPhase::Parse);
+    TelemetryJob progress(getTraceBaseName(traceFile), predictor.getName());
+    auto reader = openTrace(traceFile);
     
     predictor.reset();
     
     size_t totalBranches = 0;
     size_t mispredictions = 0;
-    std::string line;
-    
-    while (std::getline(file, line) && (maxLines == 0 || totalBranches < maxLines)) {
-        Branch branch = parseLineToBranch(line);
-        
-        bool prediction = predictor.predict(branch);
-        bool correct = (prediction == branch.taken);
-        
-        if (!correct) {
-            mispredictions++;
+    size_t records = 0;
+    std::vector<Branch> batch(EVALUATION_BATCH_SIZE);
+    std::vector<uint8_t> predictions(EVALUATION_BATCH_SIZE);
+    
+    while (maxLines == 0 || records < maxLines) {
+        size_t limit = (maxLines == 0) ? EVALUATION_BATCH_SIZE
+                                       : std::min(EVALUATION_BATCH_SIZE, maxLines - records);
+        perfProfiler().enter(PerfPhase::Parse);
+        size_t read = 0;
+        size_t count = filter.empty() ? (read = reader->nextDirectionBatch(batch.data(), limit))
+                                      : nextFilteredBatch(*reader, filter, batch.data(), limit, read);
+        if (read == 0) break;
+
+        perfProfiler().enter(PerfPhase::Predict);
+        if (count > 0) predictor.processBatch(batch.data(), count, predictions.data());
+        for (size_t i = 0; i < count; i++) {
+            if (predictions[i] != batch[i].taken) {
+                mispredictions++;
+            }
         }
-        
-        predictor.update(branch, prediction);
-        totalBranches++;
+        if (classes) classes->addBatch(batch.data(), predictions.data(), count);
+        totalBranches += count;
+        records += read;
+        progress.update(records, reader->progress());
     }
     
     double mispredictionRate = (totalBranches > 0) ? 
         (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
     
-    std::cout << "Predictor: " << predictor.getName() << std::endl;
-    std::cout << "Total branches: " << totalBranches << std::endl;
-    std::cout << "Mispredictions: " << mispredictions << std::endl;
-    std::cout << "Misprediction rate: " << std::fixed << std::setprecision(2) << mispredictionRate << "%" << std::endl;
-    std::cout << std::endl;
+    evaluationLog() << "Predictor: " << predictor.getName() << std::endl;
+    evaluationLog() << "Total branches: " << totalBranches << std::endl;
+    evaluationLog() << "Mispredictions: " << mispredictions << std::endl;
+    evaluationLog() << "Misprediction rate: " << std::fixed << std::setprecision(2) << mispredictionRate << "%" << std::endl;
+    evaluationLog() << std::endl;
 
     return {totalBranches, mispredictions};
 }
 
 //  evaluation function for the Profiled predictor
-std::vector<size_t> evaluateProfiledPredictor(ProfiledPredictor& predictor, const std::string& traceFile, size_t maxLines = 0) {
+std::vector<size_t> evaluateProfiledPredictor(ProfiledPredictor& predictor, const std::string& traceFile, size_t maxLines = 0,
+                                              const BranchFilter& filter = BranchFilter(), ClassCounts* classes = nullptr) {
     // First pass: profiling mode
-    std::ifstream file1(traceFile);
-    if (!file1.is_open()) {
-        std::cerr << "Error: Could not open file " << traceFile << std::endl;
-        throw std::runtime_error("File not found");
-    }
+    perfProfiler().beginJob(getTraceBaseName(traceFile), predictor.getName());
+    perfProfiler().enter(PerfPhase::Parse);
+    TelemetryJob progress(getTraceBaseName(traceFile), predictor.getName());
+    auto reader1 = openTrace(traceFile);
     
     predictor.reset();
     
     size_t totalBranches = 0;
-    std::string line;
-    
-    std::cout << "Starting profiling phase..." << std::endl;
-    
-    while (std::getline(file1, line) && (maxLines == 0 || totalBranches < maxLines)) {
-        Branch branch = parseLineToBranch(line);
-        
-        bool prediction = predictor.predict(branch);
-        predictor.update(branch, prediction);
-        totalBranches++;
+    size_t records = 0;
+    std::vector<Branch> batch(EVALUATION_BATCH_SIZE);
+    
+    evaluationLog() << "Starting profiling phase..." << std::endl;
+    
+    while (maxLines == 0 || records < maxLines) {
+        size_t limit = (maxLines == 0) ? EVALUATION_BATCH_SIZE
+                                       : std::min(EVALUATION_BATCH_SIZE, maxLines - records);
+        perfProfiler().enter(PerfPhase::Parse);
+        size_t read = reader1->nextBatch(batch.data(), limit);
+        if (read == 0) break;
+        size_t count = filter.empty() ? read : filter.compact(batch.data(), read);
+
+        perfProfiler().enter(PerfPhase::Profile);
+        for (size_t i = 0; i < count; i++) {
+            bool prediction = predictor.predict(batch[i]);
+            predictor.update(batch[i], prediction);
+        }
+        totalBranches += count;
+        records += read;
+        progress.update(records, reader1->progress() / 2);
     }
+    perfProfiler().enter(PerfPhase::Profile);
     
     size_t uniqueBranches = predictor.getProfileSize();
     size_t initializedIndices = predictor.getInitializedIndices();
     
-    std::cout << "Profiling complete. Collected data for " << uniqueBranches 
+    evaluationLog() << "Profiling complete. Collected data for " << uniqueBranches 
               << " unique branch locations, affecting " << initializedIndices 
               << " table entries." << std::endl;
     
     // Calculate and report aliasing rate
     double aliasingRate = 1.0 - (static_cast<double>(initializedIndices) / uniqueBranches);
-    std::cout << "Aliasing rate in the prediction table: " 
+    evaluationLog() << "Aliasing rate in the prediction table: " 
               << std::fixed << std::setprecision(2) << (aliasingRate * 100) << "%" << std::endl;
     
     // Switch to prediction mode and initialize 2-bit counters based on profile
     predictor.switchToPredict();
+    size_t profiledRecords = records;
     
     // Second pass: prediction mode
-    std::ifstream file2(traceFile);
-    if (!file2.is_open()) {
-        std::cerr << "Error: Could not open file " << traceFile << " for second pass" << std::endl;
-        throw std::runtime_error("File not found");
-    }
+    perfProfiler().enter(PerfPhase::Parse);
+    auto reader2 = openTrace(traceFile);
     
     totalBranches = 0;
+    records = 0;
     size_t mispredictions = 0;
     
-    std::cout << "Starting prediction phase..." << std::endl;
+    evaluationLog() << "Starting prediction phase..." << std::endl;
     
-    while (std::getline(file2, line) && (maxLines == 0 || totalBranches < maxLines)) {
-        Branch branch = parseLineToBranch(line);
-        
-        bool prediction = predictor.predict(branch);
-        bool correct = (prediction == branch.taken);
-        
-        if (!correct) {
-            mispredictions++;
+    while (maxLines == 0 || records < maxLines) {
+        size_t limit = (maxLines == 0) ? EVALUATION_BATCH_SIZE
+                                       : std::min(EVALUATION_BATCH_SIZE, maxLines - records);
+        perfProfiler().enter(PerfPhase::Parse);
+        size_t read = reader2->nextBatch(batch.data(), limit);
+        if (read == 0) break;
+        size_t count = filter.empty() ? read : filter.compact(batch.data(), read);
+
+        perfProfiler().enter(PerfPhase::Predict);
+        for (size_t i = 0; i < count; i++) {
+            const Branch& branch = batch[i];
+            bool prediction = predictor.predict(branch);
+            bool correct = (prediction == branch.taken);
+            
+            if (!correct) {
+                mispredictions++;
+            }
+            if (classes) classes->add(branch, prediction);
+            
+            predictor.update(branch, prediction);
         }
-        
-        predictor.update(branch, prediction);
-        totalBranches++;
+        totalBranches += count;
+        records += read;
+        progress.update(profiledRecords + records, 0.5 + reader2->progress() / 2);
     }
+    perfProfiler().enter(PerfPhase::Predict);
     
     double mispredictionRate = (totalBranches > 0) ? 
         (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
     
-    std::cout << "Predictor: " << predictor.getName() << std::endl;
-    std::cout << "Total branches: " << totalBranches << std::endl;
-    std::cout << "Mispredictions: " << mispredictions << std::endl;
-    std::cout << "Misprediction rate: " << std::fixed << std::setprecision(2) << mispredictionRate << "%" << std::endl;
-    std::cout << std::endl;
+    evaluationLog() << "Predictor: " << predictor.getName() << std::endl;
+    evaluationLog() << "Total branches: " << totalBranches << std::endl;
+    evaluationLog() << "Mispredictions: " << mispredictions << std::endl;
+    evaluationLog() << "Misprediction rate: " << std::fixed << std::setprecision(2) << mispredictionRate << "%" << std::endl;
+    evaluationLog() << std::endl;
 
     return {totalBranches, mispredictions};
 }
 
 //  evaluation function for the Profiled 2Bit predictor
-std::vector<size_t> evaluateProfiled2BitPredictor(Profiled2BitPredictor& predictor, const std::string& traceFile, size_t maxLines = 0) {
+std::vector<size_t> evaluateProfiled2BitPredictor(Profiled2BitPredictor& predictor, const std::string& traceFile, size_t maxLines = 0,
+                                                  const BranchFilter& filter = BranchFilter(), ClassCounts* classes = nullptr) {
     // First pass: profiling mode
-    std::ifstream file1(traceFile);
-    if (!file1.is_open()) {
-        std::cerr << "Error: Could not open file " << traceFile << std::endl;
-        throw std::runtime_error("File not found");
-    }
+    perfProfiler().beginJob(getTraceBaseName(traceFile), predictor.getName());
+    perfProfiler().enter(PerfPhase::Parse);
+    TelemetryJob progress(getTraceBaseName(traceFile), predictor.getName());
+    auto reader1 = openTrace(traceFile);
     
     predictor.reset();
     
     size_t totalBranches = 0;
-    std::string line;
-    
-    std::cout << "Starting profiling phase..." << std::endl;
-    
-    while (std::getline(file1, line) && (maxLines == 0 || totalBranches < maxLines)) {
-        Branch branch = parseLineToBranch(line);
-        
-        bool prediction = predictor.predict(branch);
-        predictor.update(branch, prediction);
-        totalBranches++;
+    size_t records = 0;
+    std::vector<Branch> batch(EVALUATION_BATCH_SIZE);
+    
+    evaluationLog() << "Starting profiling phase..." << std::endl;
+    
+    while (maxLines == 0 || records < maxLines) {
+        size_t limit = (maxLines == 0) ? EVALUATION_BATCH_SIZE
+                                       : std::min(EVALUATION_BATCH_SIZE, maxLines - records);
+        perfProfiler().enter(PerfPhase::Parse);
+        size_t read = reader1->nextBatch(batch.data(), limit);
+        if (read == 0) break;
+        size_t count = filter.empty() ? read : filter.compact(batch.data(), read);
+
+        perfProfiler().enter(PerfPhase::Profile);
+        for (size_t i = 0; i < count; i++) {
+            bool prediction = predictor.predict(batch[i]);
+            predictor.update(batch[i], prediction);
+        }
+        totalBranches += count;
+        records += read;
+        progress.update(records, reader1->progress() / 2);
     }
+    perfProfiler().enter(PerfPhase::Profile);
     
     size_t uniqueBranches = predictor.getProfileSize();
     size_t initializedIndices = predictor.getInitializedIndices();
     
-    std::cout << "Profiling complete. Collected data for " << uniqueBranches 
+    evaluationLog() << "Profiling complete. Collected data for " << uniqueBranches 
               << " unique branch locations, affecting " << initializedIndices 
               << " table entries." << std::endl;
     
     // Calculate and report aliasing rate
     double aliasingRate = 1.0 - (static_cast<double>(initializedIndices) / uniqueBranches);
-    std::cout << "Aliasing rate in the prediction table: " 
+    evaluationLog() << "Aliasing rate in the prediction table: " 
               << std::fixed << std::setprecision(2) << (aliasingRate * 100) << "%" << std::endl;
     
     // Switch to prediction mode and initialize 2-bit counters based on profile
     predictor.switchToPredict();
+    size_t profiledRecords = records;
     
     // Second pass: prediction mode
-    std::ifstream file2(traceFile);
-    if (!file2.is_open()) {
-        std::cerr << "Error: Could not open file " << traceFile << " for second pass" << std::endl;
-        throw std::runtime_error("File not found");
-    }
+    perfProfiler().enter(PerfPhase::Parse);
+    auto reader2 = openTrace(traceFile);
     
     totalBranches = 0;
+    records = 0;
     size_t mispredictions = 0;
     
-    std::cout << "Starting prediction phase..." << std::endl;
+    evaluationLog() << "Starting prediction phase..." << std::endl;
     
-    while (std::getline(file2, line) && (maxLines == 0 || totalBranches < maxLines)) {
-        Branch branch = parseLineToBranch(line);
-        
-        bool prediction = predictor.predict(branch);
-        bool correct = (prediction == branch.taken);
-        
-        if (!correct) {
-            mispredictions++;
+    while (maxLines == 0 || records < maxLines) {
+        size_t limit = (maxLines == 0) ? EVALUATION_BATCH_SIZE
+                                       : std::min(EVALUATION_BATCH_SIZE, maxLines - records);
+        perfProfiler().enter(PerfPhase::Parse);
+        size_t read = reader2->nextBatch(batch.data(), limit);
+        if (read == 0) break;
+        size_t count = filter.empty() ? read : filter.compact(batch.data(), read);
+
+        perfProfiler().enter(PerfPhase::Predict);
+        for (size_t i = 0; i < count; i++) {
+            const Branch& branch = batch[i];
+            bool prediction = predictor.predict(branch);
+            bool correct = (prediction == branch.taken);
+            
+            if (!correct) {
+                mispredictions++;
+            }
+            if (classes) classes->add(branch, prediction);
+            
+            predictor.update(branch, prediction);
         }
-        
-        predictor.update(branch, prediction);
-        totalBranches++;
+        totalBranches += count;
+        records += read;
+        progress.update(profiledRecords + records, 0.5 + reader2->progress() / 2);
     }
+    perfProfiler().enter(PerfPhase::Predict);
     
     double mispredictionRate = (totalBranches > 0) ? 
         (static_cast<double>(mispredictions) / totalBranches) * 100.0 : 0.0;
     
-    std::cout << "Predictor: " << predictor.getName() << std::endl;
-    std::cout << "Total branches: " << totalBranches << std::endl;
-    std::cout << "Mispredictions: " << mispredictions << std::endl;
-    std::cout << "Misprediction rate: " << std::fixed << std::setprecision(2) << mispredictionRate << "%" << std::endl;
-    std::cout << std::endl;
+    evaluationLog() << "Predictor: " << predictor.getName() << std::endl;
+    evaluationLog() << "Total branches: " << totalBranches << std::endl;
+    evaluationLog() << "Mispredictions: " << mispredictions << std::endl;
+    evaluationLog() << "Misprediction rate: " << std::fixed << std::setprecision(2) << mispredictionRate << "%" << std::endl;
+    evaluationLog() << std::endl;
 
     return {totalBranches, mispredictions};
 }
\ No newline at end of file
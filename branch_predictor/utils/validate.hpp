@@ -0,0 +1,466 @@
+# pragma once
+
+#include "predictor/branch.hpp"
+#include "predictor/predictor.hpp"
+#include "predictor/factory.hpp"
+#include "utils/trace_io.hpp"
+#include "utils/trace_cache.hpp"
+#include "utils/synthetic.hpp"
+#include "utils/utils.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <cstdint>
+
+// ==== differential validation ====
+// A predictor configuration runs through two engines in lockstep:
+//   reference  the trace decoded record by record by ReferenceTraceReader,
+//              independently of the simulator's parsers, and fed to a
+//              plain model, one predict / update at a time: independent
+//              models of 2bit, gshare and profiled_2bit (without a loop
+//              table), a second instance driven through predict() / update()
+//              for the other types
+//   optimized  the simulator's own path: openTrace() (shared-memory cache,
+//              io_uring or mmap reader), EVALUATION_BATCH_SIZE direction
+//              batches and processBatch; nextBatch and predict / update for
+//              profiled predictors, as in evaluateAnyPredictor
+// Every record (pc and flags, the fields direction batches guarantee) and
+// every prediction is compared. The first divergence ends the run and is
+// reported with the state both engines read for the branch and the branches
+// leading up to it; the optimized state is replayed from the start in the
+// same batches, cut before the branch.
+
+// Record stream of the reference engine, decoded without the simulator's
+// readers: text lines through std::getline and parseLineToBranch (the
+// std::istringstream parser), binary records byte by byte from std::ifstream
+class ReferenceTraceReader {
+private:
+    std::ifstream file;
+    bool binary = false;
+
+    static uint64_t littleEndian(const unsigned char* bytes) {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; i--) value = (value << 8) | bytes[i];
+        return value;
+    }
+
+public:
+    explicit ReferenceTraceReader(const std::string& path) : file(path, std::ios::binary) {
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open file " << path << std::endl;
+            throw std::runtime_error("File not found");
+        }
+        char header[16] = {};
+        file.read(header, sizeof(header));
+        binary = file.gcount() == sizeof(header) && std::string(header, 8) == "BPTRACE1";
+        if (!binary) {
+            file.clear();
+            file.seekg(0);
+        }
+    }
+
+    bool next(Branch& branch) {
+        if (binary) {
+            // pc and target little-endian, then kind in bits 0-1, direct, conditional and taken in bits 2-4
+            unsigned char record[17];
+            if (!file.read(reinterpret_cast<char*>(record), sizeof(record))) return false;
+            branch.pc = littleEndian(record);
+            branch.target = littleEndian(record + 8);
+            branch.kind = "bcr?"[record[16] & 3];
+            branch.direct = (record[16] >> 2) & 1;
+            branch.conditional = (record[16] >> 3) & 1;
+            branch.taken = (record[16] >> 4) & 1;
+            return true;
+        }
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty()) continue;
+            branch = parseLineToBranch(line);
+            return true;
+        }
+        return false;
+    }
+};
+
+// Transitions of updateCounterState, [taken][counter]
+const uint8_t REFERENCE_COUNTER_NEXT[2][4] = {{0, 0, 0, 2}, {1, 3, 3, 3}};
+
+class ReferenceModel {
+public:
+    virtual ~ReferenceModel() {}
+    virtual bool predict(const Branch& branch) = 0;
+    virtual void update(const Branch& branch, bool predicted) = 0;
+    virtual void switchToPredict() {}
+    virtual std::string describeState(const Branch& branch) const = 0;
+};
+
+// 2-bit counters indexed by pc modulo the table size
+class ReferenceTwoBit : public ReferenceModel {
+private:
+    std::vector<uint8_t> counters;
+
+public:
+    explicit ReferenceTwoBit(size_t size) : counters(size, 2) {}
+
+    bool predict(const Branch& branch) override { return counters[branch.pc % counters.size()] >= 2; }
+
+    void update(const Branch& branch, bool) override {
+        uint8_t& counter = counters[branch.pc % counters.size()];
+        counter = REFERENCE_COUNTER_NEXT[branch.taken][counter];
+    }
+
+    std::string describeState(const Branch& branch) const override {
+        std::stringstream ss;
+        size_t index = branch.pc % counters.size();
+        ss << "index 0x" << std::hex << index << std::dec << ", counter " << int(counters[index]);
+        return ss.str();
+    }
+};
+
+// gshare over a plain list of outcomes: the newest historyBits outcomes, the
+// one of age a at bit a % indexBits, XORed with the pc's low bits
+class ReferenceGShare : public ReferenceModel {
+private:
+    std::vector<uint8_t> counters;
+    size_t indexBits = 0;
+    size_t historyBits;
+    std::deque<bool> outcomes;      // newest first
+
+    uint64_t historyValue() const {
+        size_t width = std::max<size_t>(1, indexBits);
+        uint64_t value = 0;
+        for (size_t age = 0; age < outcomes.size(); age++) {
+            value ^= static_cast<uint64_t>(outcomes[age]) << (age % width);
+        }
+        return value & (counters.size() - 1);
+    }
+
+    size_t index(const Branch& branch) const {
+        return ((branch.pc & (counters.size() - 1)) ^ historyValue());
+    }
+
+public:
+    ReferenceGShare(size_t size, size_t history) : counters(size, 2) {
+        while ((size_t(1) << (indexBits + 1)) <= size) indexBits++;
+        historyBits = history > 0 ? history : indexBits;
+    }
+
+    bool predict(const Branch& branch) override { return counters[index(branch)] >= 2; }
+
+    void update(const Branch& branch, bool) override {
+        uint8_t& counter = counters[index(branch)];
+        counter = REFERENCE_COUNTER_NEXT[branch.taken][counter];
+        outcomes.push_front(branch.taken);
+        if (outcomes.size() > historyBits) outcomes.pop_back();
+    }
+
+    std::string describeState(const Branch& branch) const override {
+        std::stringstream ss;
+        ss << "index 0x" << std::hex << index(branch) << " (pc 0x" << (branch.pc & (counters.size() - 1))
+           << " ^ history 0x" << historyValue() << ")" << std::dec << ", counter " << int(counters[index(branch)]);
+        return ss.str();
+    }
+};
+
+// Per-pc taken rates, aggregated per index into initial counters
+class ReferenceProfiled2Bit : public ReferenceModel {
+private:
+    std::vector<uint8_t> counters;
+    std::unordered_map<uint64_t, std::pair<uint64_t, uint64_t>> profile;   // pc -> (taken, total)
+    bool profiling = true;
+
+public:
+    explicit ReferenceProfiled2Bit(size_t size) : counters(size, 2) {}
+
+    bool predict(const Branch& branch) override {
+        return profiling ? branch.taken : counters[branch.pc % counters.size()] >= 2;
+    }
+
+    void update(const Branch& branch, bool) override {
+        if (profiling) {
+            auto& entry = profile[branch.pc];
+            entry.first += branch.taken;
+            entry.second++;
+            return;
+        }
+        uint8_t& counter = counters[branch.pc % counters.size()];
+        counter = REFERENCE_COUNTER_NEXT[branch.taken][counter];
+    }
+
+    void switchToPredict() override {
+        profiling = false;
+        std::vector<std::pair<uint64_t, uint64_t>> perIndex(counters.size(), {0, 0});
+        for (const auto& entry : profile) {
+            auto& sum = perIndex[entry.first % counters.size()];
+            sum.first += entry.second.first;
+            sum.second += entry.second.second;
+        }
+        for (size_t i = 0; i < counters.size(); i++) {
+            if (perIndex[i].second == 0) continue;
+            double rate = static_cast<double>(perIndex[i].first) / perIndex[i].second;
+            counters[i] = rate > 0.75 ? 3 : rate > 0.5 ? 2 : rate > 0.25 ? 1 : 0;
+        }
+    }
+
+    std::string describeState(const Branch& branch) const override {
+        std::stringstream ss;
+        if (profiling) {
+            auto seen = profile.find(branch.pc);
+            ss << "profiling, pc seen " << (seen == profile.end() ? 0 : seen->second.second) << " times";
+        } else {
+            size_t index = branch.pc % counters.size();
+            ss << "index 0x" << std::hex << index << std::dec << ", counter " << int(counters[index]);
+        }
+        return ss.str();
+    }
+};
+
+// Switch a profiled predictor from its profiling pass to prediction
+inline void switchToPredict(BranchPredictor& predictor) {
+    if (auto* profiled = dynamic_cast<ProfiledPredictor*>(&predictor)) profiled->switchToPredict();
+    else if (auto* profiled2Bit = dynamic_cast<Profiled2BitPredictor*>(&predictor)) profiled2Bit->switchToPredict();
+}
+
+// A second instance of the predictor, one predict() / update() per branch
+class ScalarReference : public ReferenceModel {
+private:
+    std::unique_ptr<BranchPredictor> predictor;
+
+public:
+    explicit ScalarReference(const PredictorSpec& spec) : predictor(createPredictor(spec)) { predictor->reset(); }
+
+    bool predict(const Branch& branch) override { return predictor->predict(branch); }
+    void update(const Branch& branch, bool predicted) override { predictor->update(branch, predicted); }
+    void switchToPredict() override { ::switchToPredict(*predictor); }
+    std::string describeState(const Branch& branch) const override { return predictor->describeState(branch); }
+};
+
+inline std::unique_ptr<ReferenceModel> createReference(const PredictorSpec& spec) {
+    if (!spec.params.count(LOOP_OVERRIDE_PARAM)) {
+        if (spec.type == "2bit") return std::make_unique<ReferenceTwoBit>(spec.param("size"));
+        if (spec.type == "gshare") return std::make_unique<ReferenceGShare>(spec.param("size"), spec.param("history"));
+        if (spec.type == "profiled_2bit") return std::make_unique<ReferenceProfiled2Bit>(spec.param("size"));
+    }
+    return std::make_unique<ScalarReference>(spec);
+}
+
+struct ValidationOptions {
+    size_t maxLines = 0;        // branches per pass, 0 for the whole trace
+    size_t context = 8;         // branches listed before a divergence
+};
+
+struct LockstepRecord {
+    uint64_t position;
+    Branch branch;
+    bool reference;
+    bool optimized;
+};
+
+struct Divergence {
+    size_t pass = 0;            // 0 is the profiling pass of profiled predictors
+    uint64_t position = 0;      // branch index within the pass
+    std::string reason;
+    Branch reference{};         // record as each engine decoded it
+    Branch optimized{};
+    bool referencePrediction = false;
+    bool optimizedPrediction = false;
+    std::string referenceState;
+    std::string optimizedState;
+    std::vector<LockstepRecord> context;
+};
+
+struct ValidationResult {
+    std::string predictorName;
+    uint64_t branches = 0;      // branches of the last pass
+    uint64_t mispredictions = 0;
+    bool diverged = false;
+    Divergence divergence;
+};
+
+// One batch of the optimized engine, returns the branches processed
+inline size_t optimizedBatch(BranchPredictor& predictor, BranchSource& reader, bool profiled,
+                             Branch* batch, uint8_t* predictions, size_t limit) {
+    if (profiled) {
+        size_t count = reader.nextBatch(batch, limit);
+        for (size_t i = 0; i < count; i++) {
+            bool prediction = predictor.predict(batch[i]);
+            predictions[i] = prediction;
+            predictor.update(batch[i], prediction);
+        }
+        return count;
+    }
+    size_t count = reader.nextDirectionBatch(batch, limit);
+    if (count > 0) predictor.processBatch(batch, count, predictions);
+    return count;
+}
+
+// Optimized engine state for the branch at `position` of pass `pass`, replayed from the start
+inline std::string replayOptimizedState(const PredictorSpec& spec, const std::string& traceFile, size_t pass,
+                                        uint64_t position, const Branch& branch, const ValidationOptions& options) {
+    std::unique_ptr<BranchPredictor> predictor = createPredictor(spec);
+    bool profiled = findPredictorType(spec.type).profiled;
+    predictor->reset();
+    std::vector<Branch> batch(EVALUATION_BATCH_SIZE);
+    std::vector<uint8_t> predictions(EVALUATION_BATCH_SIZE);
+    for (size_t p = 0; p <= pass; p++) {
+        if (p > 0) switchToPredict(*predictor);
+        auto reader = openTrace(traceFile);
+        uint64_t end = (p < pass) ? options.maxLines : position;
+        uint64_t done = 0;
+        while ((end == 0 && p < pass) || done < end) {
+            size_t limit = EVALUATION_BATCH_SIZE;
+            if (end > 0) limit = static_cast<size_t>(std::min<uint64_t>(limit, end - done));
+            size_t count = optimizedBatch(*predictor, *reader, profiled, batch.data(), predictions.data(), limit);
+            if (count == 0) break;
+            done += count;
+        }
+    }
+    return predictor->describeState(branch);
+}
+
+inline bool sameRecord(const Branch& a, const Branch& b) {
+    return a.pc == b.pc && a.kind == b.kind && a.direct == b.direct && a.conditional == b.conditional &&
+           a.taken == b.taken;
+}
+
+// Run spec on traceFile through both engines, stopping at the first divergence
+inline ValidationResult validatePredictor(const PredictorSpec& spec, const std::string& traceFile,
+                                          const ValidationOptions& options = ValidationOptions()) {
+    ValidationResult result;
+    std::unique_ptr<BranchPredictor> optimized = createPredictor(spec);
+    std::unique_ptr<ReferenceModel> reference = createReference(spec);
+    result.predictorName = optimized->getName();
+    bool profiled = findPredictorType(spec.type).profiled;
+    optimized->reset();
+
+    std::vector<Branch> batch(EVALUATION_BATCH_SIZE);
+    std::vector<uint8_t> predictions(EVALUATION_BATCH_SIZE);
+    std::deque<LockstepRecord> recent;
+
+    for (size_t pass = 0; pass < (profiled ? 2u : 1u); pass++) {
+        if (pass > 0) {
+            switchToPredict(*optimized);
+            reference->switchToPredict();
+        }
+        ReferenceTraceReader referenceReader(traceFile);
+        auto reader = openTrace(traceFile);
+        uint64_t position = 0;
+        uint64_t mispredictions = 0;
+        recent.clear();
+
+        auto diverge = [&](const std::string& reason, const Branch& expected, const Branch* actual,
+                           bool referencePrediction, bool optimizedPrediction) {
+            Divergence& d = result.divergence;
+            result.diverged = true;
+            d.pass = pass;
+            d.position = position;
+            d.reason = reason;
+            d.reference = expected;
+            if (actual) d.optimized = *actual;
+            d.referencePrediction = referencePrediction;
+            d.optimizedPrediction = optimizedPrediction;
+            d.referenceState = reference->describeState(expected);
+            d.optimizedState = replayOptimizedState(spec, traceFile, pass, position, actual ? *actual : expected, options);
+            d.context.assign(recent.begin(), recent.end());
+            return result;
+        };
+
+        while (options.maxLines == 0 || position < options.maxLines) {
+            size_t limit = (options.maxLines == 0) ? EVALUATION_BATCH_SIZE
+                                                   : std::min<uint64_t>(EVALUATION_BATCH_SIZE, options.maxLines - position);
+            size_t count = optimizedBatch(*optimized, *reader, profiled, batch.data(), predictions.data(), limit);
+            if (count == 0) break;
+            for (size_t i = 0; i < count; i++, position++) {
+                Branch expected;
+                if (!referenceReader.next(expected)) {
+                    return diverge("the optimized reader returned more records", batch[i], &batch[i], false, predictions[i]);
+                }
+                bool predicted = reference->predict(expected);
+                if (!sameRecord(expected, batch[i])) {
+                    return diverge("records differ", expected, &batch[i], predicted, predictions[i]);
+                }
+                if (predicted != static_cast<bool>(predictions[i])) {
+                    return diverge("predictions differ", expected, &batch[i], predicted, predictions[i]);
+                }
+                reference->update(expected, predicted);
+                mispredictions += predicted != expected.taken;
+                recent.push_back({position, expected, predicted, static_cast<bool>(predictions[i])});
+                if (recent.size() > options.context) recent.pop_front();
+            }
+        }
+        Branch extra;
+        if ((options.maxLines == 0 || position < options.maxLines) && referenceReader.next(extra)) {
+            return diverge("the optimized reader ended early", extra, nullptr, false, false);
+        }
+        result.branches = position;
+        result.mispredictions = mispredictions;
+    }
+    return result;
+}
+
+inline std::string describeRecord(const Branch& branch) {
+    std::stringstream ss;
+    ss << "pc " << std::hex << branch.pc << std::dec << " kind " << branch.kind << " direct " << branch.direct
+       << " conditional " << branch.conditional << " taken " << branch.taken;
+    return ss.str();
+}
+
+// Report of a divergence: where, both records and predictions, state and preceding branches
+inline void printDivergence(std::ostream& out, const std::string& traceFile, const PredictorSpec& spec,
+                            const ValidationResult& result) {
+    const Divergence& d = result.divergence;
+    bool profiled = findPredictorType(spec.type).profiled;
+    out << "DIVERGENCE " << traceFile << ", " << spec.toString() << " (" << result.predictorName << ")\n"
+        << "  " << d.reason << " at branch " << d.position;
+    if (profiled) out << " of the " << (d.pass == 0 ? "profiling" : "prediction") << " pass";
+    out << "\n"
+        << "  reference  " << describeRecord(d.reference) << ", predicted " << d.referencePrediction << "\n"
+        << "             " << (d.referenceState.empty() ? "(no state description)" : d.referenceState) << "\n"
+        << "  optimized  " << describeRecord(d.optimized) << ", predicted " << d.optimizedPrediction << "\n"
+        << "             " << (d.optimizedState.empty() ? "(no state description)" : d.optimizedState) << "\n";
+    if (!d.context.empty()) out << "  preceding branches (reference / optimized prediction):\n";
+    for (const LockstepRecord& record : d.context) {
+        out << "    " << record.position << "  " << describeRecord(record.branch) << "  "
+            << record.reference << " / " << record.optimized << "\n";
+    }
+}
+
+// A random valid configuration of one of the registered predictor types
+inline PredictorSpec randomPredictorSpec(FastRng& rng) {
+    auto power = [&](size_t minLog, size_t maxLog) { return uint64_t(1) << (minLog + rng.below(maxLog - minLog + 1)); };
+    std::stringstream ss;
+    switch (rng.below(8)) {
+        case 0: ss << "2bit size=" << power(1, 16); break;
+        case 1: {
+            uint64_t history = rng.below(3) == 0 ? 0 : 1 + rng.below(rng.below(2) ? 24 : 256);
+            ss << "gshare size=" << power(1, 16) << " history=" << history;
+            break;
+        }
+        case 2: ss << "profiled_2bit size=" << power(1, 16); break;
+        case 3: ss << "profiled size=" << power(1, 16); break;
+        case 4: ss << "pag history=" << 1 + rng.below(16) << " bht=" << power(1, 12) << " hash=" << rng.below(2); break;
+        case 5:
+            ss << "pap history=" << 1 + rng.below(12) << " bht=" << power(1, 10) << " phts=" << power(1, 8)
+               << " hash=" << rng.below(2);
+            break;
+        case 6:
+            ss << "sag history=" << 1 + rng.below(16) << " sets=" << power(1, 10) << " block=" << power(0, 8)
+               << " hash=" << rng.below(2);
+            break;
+        default: {
+            uint64_t ways = power(0, 2);
+            ss << "loop entries=" << std::max(ways, power(2, 8)) << " ways=" << ways;
+            return PredictorSpec::parse(ss.str());
+        }
+    }
+    std::string text = ss.str();
+    bool profiled = text.compare(0, 8, "profiled") == 0;
+    if (!profiled && rng.below(4) == 0) text += " loop=" + std::to_string(power(2, 8));
+    return PredictorSpec::parse(text);
+}
@@ -1,3 +1,7 @@
+import json
+import os
+import struct
+
 import numpy as np
 import pandas as pd
 import matplotlib.pyplot as plt
@@ -5,7 +9,7 @@ import matplotlib.pyplot as plt
 def main():
     ##############################################################
     csv_path = 'results/trace_comparison.csv'
-    df_row = pd.read_csv(csv_path)
+    df_row = read_table(csv_path)
 
     # draw trace comparison
     cols = [
@@ -31,7 +35,7 @@ def main():
 
     #####################################################################
     csv_path = 'results/results_predict.csv'
-    df_row = pd.read_csv(csv_path)
+    df_row = read_table(csv_path)
     df=df_row
     pivot_df = df.pivot_table(
         index='Predictor',
@@ -74,7 +78,72 @@ def main():
     )
 
     print('2-bit Predictor Comparison has been saved to results/plots_predictor_comparison_2b.png')
-    
+
+
+# columnar result tables written with --columnar, see branch_predictor/utils/columnar.hpp
+COLUMNAR_MAGIC = b'BPCOLS01'
+COLUMNAR_END_MARKER = 0xFFFFFFFF
+COLUMNAR_DTYPES = {'int64': '<i8', 'uint64': '<u8', 'float64': '<f8'}
+
+
+def read_columnar(path):
+    """Load a .bpcol table into a DataFrame, its schema metadata in df.attrs['metadata']."""
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != COLUMNAR_MAGIC:
+        raise ValueError(f'{path} is not a columnar result table')
+    align = lambda n: (n + 7) & ~7
+    (schema_length,) = struct.unpack_from('<I', data, 8)
+    schema = json.loads(data[12:12 + schema_length])
+    columns = schema['columns']
+    chunks = {column['name']: [] for column in columns}
+    pos = align(12 + schema_length)
+    finished = False
+    while pos + 4 <= len(data):
+        (rows,) = struct.unpack_from('<I', data, pos)
+        pos += 8
+        if rows == COLUMNAR_END_MARKER:
+            finished = True
+            break
+        batch = {}
+        try:
+            for column in columns:
+                if column['type'] == 'string':
+                    # dictionary of the batch's distinct values, then a code per row
+                    (distinct,) = struct.unpack_from('<I', data, pos)
+                    offsets = np.frombuffer(data, '<u4', distinct + 1, pos + 8)
+                    pos = align(pos + 8 + 4 * (distinct + 1))
+                    blob = data[pos:pos + int(offsets[-1])]
+                    pos = align(pos + int(offsets[-1]))
+                    values = np.array([blob[a:b].decode() for a, b in zip(offsets[:-1], offsets[1:])], dtype=object)
+                    batch[column['name']] = values[np.frombuffer(data, '<u4', rows, pos)]
+                    pos = align(pos + 4 * rows)
+                else:
+                    batch[column['name']] = np.frombuffer(data, COLUMNAR_DTYPES[column['type']], rows, pos)
+                    pos += 8 * rows
+        except (ValueError, IndexError, struct.error):
+            break                               # cut off inside this batch
+        for name, values in batch.items():
+            chunks[name].append(values)
+    if not finished:
+        print(f'Warning: {path} is truncated, loaded the complete record batches')
+
+    df = pd.DataFrame({
+        column['name']: np.concatenate(chunks[column['name']]) if chunks[column['name']]
+        else np.empty(0, dtype=COLUMNAR_DTYPES.get(column['type'], object))
+        for column in columns
+    })
+    df.attrs['metadata'] = schema['metadata']
+    return df
+
+
+def read_table(csv_path):
+    """Read a result table, from its columnar copy if one is at least as new as the CSV."""
+    columnar_path = os.path.splitext(csv_path)[0] + '.bpcol'
+    if os.path.exists(columnar_path) and os.path.getmtime(columnar_path) >= os.path.getmtime(csv_path):
+        return read_columnar(columnar_path)
+    return pd.read_csv(csv_path)
+
 
 def draw_bar(
 		df_data:pd.DataFrame,